@@ -0,0 +1,82 @@
+// Bake.cpp
+// Offline lightmap bake tool: path traces the indirect light of the hall into the lightmap atlas
+// the viewer loads with --lightmap. Run from the same directory as the viewer.
+//   bake [--stress N] [--out path] [--samples N] [--bounces N] [--texels-per-unit N] [--threads N]
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "GalleryLayout.h"
+#include "LightmapBaker.h"
+#include "LightmapFile.h"
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+int main(int argc, char** argv) {
+    int stressExhibits = 0;
+    std::string outputPath;
+    LightmapBakeSettings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stress" && i + 1 < argc) {
+            stressExhibits = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--samples" && i + 1 < argc) {
+            settings.samples = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--bounces" && i + 1 < argc) {
+            settings.bounces = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--texels-per-unit" && i + 1 < argc) {
+            settings.texelsPerUnit = std::max(0.5f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            settings.threads = static_cast<unsigned int>(std::max(0, atoi(argv[++i])));
+        }
+        else if (arg == "--no-track-lights") {
+            settings.trackLights = false;
+        }
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (outputPath.empty()) {
+        // Same default the viewer looks for.
+        outputPath = stressExhibits > 0 ? "lightmaps/museum_stress" + std::to_string(stressExhibits) + ".lightmap" : "lightmaps/museum.lightmap";
+#ifdef _WIN32
+        _mkdir("lightmaps");
+#else
+        mkdir("lightmaps", 0755);
+#endif
+    }
+
+    GalleryLayout layout = buildGalleryLayout(stressExhibits);
+    std::cout << "Baking " << layout.exhibits.size() + 1 << " objects, " << settings.samples << " samples, "
+        << settings.bounces << " bounces" << std::endl;
+
+    LightmapBaker baker(settings);
+    LightmapData lightmap;
+    std::string error;
+    if (!baker.bake(layout, lightmap, error)) {
+        std::cerr << "ERROR::BAKE::FAILED: " << error << std::endl;
+        return 1;
+    }
+    if (!writeLightmapFile(outputPath, lightmap, error)) {
+        std::cerr << "ERROR::BAKE::WRITE_FAILED: " << outputPath << " (" << error << ")" << std::endl;
+        return 1;
+    }
+
+    const LightmapBakeStats& stats = baker.stats();
+    std::cout << "Wrote " << outputPath << ": " << lightmap.width << "x" << lightmap.height << " atlas, "
+        << stats.texels << " texels at " << stats.texelsPerUnit << " texels/unit" << std::endl;
+    std::cout << "Bake time " << stats.seconds << " s on " << stats.threads << " threads, "
+        << stats.rays / 1e6 / std::max(stats.seconds, 1e-3f) << " Mrays/s" << std::endl;
+    return 0;
+}
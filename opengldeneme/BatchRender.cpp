@@ -0,0 +1,144 @@
+// BatchRender.cpp
+#include "BatchRender.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+    glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t) {
+        float t2 = t * t, t3 = t2 * t;
+        return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+            + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+}
+
+std::vector<BatchRange> splitBatchFrames(unsigned int frameCount, unsigned int workerCount) {
+    std::vector<BatchRange> ranges;
+    workerCount = std::max(1u, std::min(workerCount, frameCount));
+    unsigned int first = 0;
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        unsigned int count = frameCount / workerCount + (i < frameCount % workerCount ? 1 : 0);
+        ranges.push_back({ first, count });
+        first += count;
+    }
+    return ranges;
+}
+
+bool runBatchWorkers(const std::vector<std::string>& commands) {
+    std::vector<int> results(commands.size(), -1);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        threads.push_back(std::thread([&commands, &results, i]() {
+#ifdef _WIN32
+            // cmd.exe drops the outer quotes of a line that starts with one
+            results[i] = std::system(("\"" + commands[i] + "\"").c_str());
+#else
+            results[i] = std::system(commands[i].c_str());
+#endif
+        }));
+    }
+    for (auto& thread : threads) thread.join();
+    return std::all_of(results.begin(), results.end(), [](int result) { return result == 0; });
+}
+
+std::string quoteBatchArgument(const std::string& argument) {
+    std::string quoted = "\"";
+    for (char c : argument) {
+        if (c == '"') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string batchSegmentName(const std::string& directory, unsigned int segment) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/segment-%03u", segment);
+    return directory + name;
+}
+
+bool joinY4mSegments(const std::vector<std::string>& segments, const std::string& path, std::string& error) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        std::ifstream in(segments[i].c_str(), std::ios::binary);
+        std::string header;
+        if (!in || !std::getline(in, header) || header.compare(0, 9, "YUV4MPEG2") != 0) {
+            error = "missing or bad segment " + segments[i];
+            return false;
+        }
+        if (i == 0) out << header << '\n';
+        while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+            out.write(buffer.data(), in.gcount());
+        }
+    }
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool CameraTimeline::load(const std::string& path, std::string& error) {
+    std::ifstream file(path.c_str());
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    keys.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::istringstream fields(line);
+        Key key;
+        if (!(fields >> key.time >> key.position.x >> key.position.y >> key.position.z
+            >> key.target.x >> key.target.y >> key.target.z >> key.fov)) {
+            error = "bad keyframe on line " + std::to_string(lineNumber);
+            return false;
+        }
+        if (!keys.empty() && key.time <= keys.back().time) {
+            error = "keyframe times must increase (line " + std::to_string(lineNumber) + ")";
+            return false;
+        }
+        keys.push_back(key);
+    }
+    if (keys.empty()) {
+        error = "no keyframes in " + path;
+        return false;
+    }
+    return true;
+}
+
+void CameraTimeline::evaluate(float time, glm::vec3& position, glm::vec3& target, float& fov) const {
+    if (time <= keys.front().time || keys.size() == 1) {
+        position = keys.front().position;
+        target = keys.front().target;
+        fov = keys.front().fov;
+        return;
+    }
+    if (time >= keys.back().time) {
+        position = keys.back().position;
+        target = keys.back().target;
+        fov = keys.back().fov;
+        return;
+    }
+    size_t next = 1;
+    while (keys[next].time < time) ++next;
+    const Key& k0 = keys[next > 1 ? next - 2 : 0];
+    const Key& k1 = keys[next - 1];
+    const Key& k2 = keys[next];
+    const Key& k3 = keys[std::min(next + 1, keys.size() - 1)];
+    float t = (time - k1.time) / (k2.time - k1.time);
+    position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+    target = catmullRom(k0.target, k1.target, k2.target, k3.target, t);
+    fov = k1.fov + (k2.fov - k1.fov) * t;
+}
@@ -0,0 +1,74 @@
+#pragma once
+// BatchRender.h
+// Offline rendering of the robot tour, faster than real time. The coordinating process splits the
+// frames into one contiguous range per worker and runs a copy of the executable for each, every
+// one with its own hidden window and GL context. A worker replays the fixed-step simulation from
+// the start of the tour up to its first frame, so it draws exactly what a single process would,
+// and numbers its PNG frames globally; Y4M workers write a segment each, which the coordinator
+// joins in frame order once they are all done.
+#ifndef BATCH_RENDER_H
+#define BATCH_RENDER_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+struct BatchRange {
+    unsigned int first;
+    unsigned int count;
+};
+
+struct BatchSettings {
+    std::string outputDirectory;
+    std::string timelinePath;   // empty: a camera following the robot
+    int width, height;
+    float fps;
+    float seconds;              // 0: the timeline's length, or the tour's
+    unsigned int workers;       // 0: one per core, up to a few
+    bool y4m;                   // else numbered PNG frames
+    bool worker;                // this process renders range as segment number segment
+    BatchRange range;
+    unsigned int segment;
+
+    BatchSettings() : width(1920), height(1080), fps(60.0f), seconds(0.0f), workers(0), y4m(false),
+        worker(false), segment(0) { range.first = 0; range.count = 0; }
+};
+
+// Frames 0..frameCount-1 in at most workerCount contiguous, nearly equal ranges.
+std::vector<BatchRange> splitBatchFrames(unsigned int frameCount, unsigned int workerCount);
+
+// Runs the command lines at the same time and waits for all of them; false if any failed.
+bool runBatchWorkers(const std::vector<std::string>& commands);
+
+// Quotes an argument for the command line runBatchWorkers hands to the shell.
+std::string quoteBatchArgument(const std::string& argument);
+
+// Files of a worker's Y4M segment, without the extension.
+std::string batchSegmentName(const std::string& directory, unsigned int segment);
+
+// Concatenates Y4M segments of the same size and rate into one file, keeping the first header.
+bool joinY4mSegments(const std::vector<std::string>& segments, const std::string& path, std::string& error);
+
+// Scripted camera: one keyframe per line, "seconds  x y z  targetX targetY targetZ  fov", with
+// '#' comments. Positions and targets follow a Catmull-Rom spline through the keyframes.
+class CameraTimeline {
+public:
+    bool load(const std::string& path, std::string& error);
+    bool empty() const { return keys.empty(); }
+    float duration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    // The camera at time seconds; before the first or after the last key it holds still.
+    void evaluate(float time, glm::vec3& position, glm::vec3& target, float& fov) const;
+
+private:
+    struct Key {
+        float time;
+        glm::vec3 position;
+        glm::vec3 target;
+        float fov;
+    };
+
+    std::vector<Key> keys;
+};
+
+#endif
@@ -0,0 +1,141 @@
+// Benchmark.cpp
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+Benchmark::Benchmark() : running(false), duration(0.0f), elapsed(0.0f) {
+}
+
+void Benchmark::start(float durationSeconds, const std::string& path) {
+    running = true;
+    duration = durationSeconds;
+    elapsed = 0.0f;
+    outputPath = path;
+    samples.clear();
+    samples.reserve(static_cast<size_t>(durationSeconds * 240.0f));
+}
+
+void Benchmark::setInfo(const std::string& key, const std::string& value) {
+    for (auto& entry : info) {
+        if (entry.first == key) {
+            entry.second = value;
+            return;
+        }
+    }
+    info.push_back(std::make_pair(key, value));
+}
+
+bool Benchmark::recordFrame(float frameSeconds, const FrameStats& stats) {
+    if (!running) return false;
+    Sample sample;
+    sample.frameMs = frameSeconds * 1000.0f;
+    sample.stats = stats;
+    samples.push_back(sample);
+
+    elapsed += frameSeconds;
+    if (elapsed < duration) return false;
+
+    running = false;
+    if (!writeReport()) {
+        std::cerr << "ERROR::BENCHMARK::REPORT_NOT_WRITTEN: " << outputPath << std::endl;
+    }
+    else {
+        std::cout << "Benchmark report written to " << outputPath << std::endl;
+    }
+    return true;
+}
+
+static float percentile(std::vector<float> values, float p) {
+    if (values.empty()) return 0.0f;
+    size_t index = static_cast<size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Info values come from the driver and the command line, so quotes and control characters are
+// escaped rather than trusted.
+static void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", c);
+                out << code;
+            }
+            else {
+                out << static_cast<char>(c);
+            }
+        }
+    }
+    out << '"';
+}
+
+static void writeStats(std::ostream& out, const FrameStats& s) {
+    out << "\"drawCalls\": " << s.drawCalls
+        << ", \"instances\": " << s.instances
+        << ", \"triangles\": " << s.triangles
+        << ", \"uniformUploads\": " << s.uniformUploads
+        << ", \"bufferBytesUploaded\": " << s.bufferBytesUploaded
+        << ", \"textureBytesUploaded\": " << s.textureBytesUploaded
+        << ", \"programSwitches\": " << s.programSwitches
+        << ", \"vaoSwitches\": " << s.vaoSwitches
+        << ", \"textureSwitches\": " << s.textureSwitches
+        << ", \"objectsSubmitted\": " << s.objectsSubmitted
+        << ", \"objectsCulled\": " << s.objectsCulled;
+}
+
+bool Benchmark::writeReport() const {
+    std::ofstream out(outputPath.c_str());
+    if (!out) return false;
+
+    std::vector<float> frameTimes;
+    frameTimes.reserve(samples.size());
+    double totalMs = 0.0;
+    double drawCalls = 0.0, triangles = 0.0, uniforms = 0.0, bytes = 0.0;
+    for (const Sample& sample : samples) {
+        frameTimes.push_back(sample.frameMs);
+        totalMs += sample.frameMs;
+        drawCalls += sample.stats.drawCalls;
+        triangles += sample.stats.triangles;
+        uniforms += sample.stats.uniformUploads;
+        bytes += sample.stats.bufferBytesUploaded;
+    }
+    double count = samples.empty() ? 1.0 : (double)samples.size();
+
+    out << "{\n";
+    for (const auto& entry : info) {
+        out << "  ";
+        writeJsonString(out, entry.first);
+        out << ": ";
+        writeJsonString(out, entry.second);
+        out << ",\n";
+    }
+    out << "  \"durationSeconds\": " << elapsed << ",\n";
+    out << "  \"frames\": " << samples.size() << ",\n";
+    out << "  \"frameMs\": { \"avg\": " << totalMs / count
+        << ", \"p50\": " << percentile(frameTimes, 0.50f)
+        << ", \"p95\": " << percentile(frameTimes, 0.95f)
+        << ", \"p99\": " << percentile(frameTimes, 0.99f)
+        << ", \"max\": " << (frameTimes.empty() ? 0.0f : *std::max_element(frameTimes.begin(), frameTimes.end())) << " },\n";
+    out << "  \"avgPerFrame\": { \"drawCalls\": " << drawCalls / count
+        << ", \"triangles\": " << triangles / count
+        << ", \"uniformUploads\": " << uniforms / count
+        << ", \"bufferBytesUploaded\": " << bytes / count << " },\n";
+    out << "  \"samples\": [\n";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        out << "    { \"frameMs\": " << samples[i].frameMs << ", ";
+        writeStats(out, samples[i].stats);
+        out << " }" << (i + 1 < samples.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.good();
+}
@@ -0,0 +1,41 @@
+#pragma once
+// Benchmark.h
+// Fixed-length benchmark run: records frame times together with the frame's RenderStats
+// and writes them out as JSON when the run is over.
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include "RenderStats.h"
+
+class Benchmark {
+public:
+    Benchmark();
+
+    void start(float durationSeconds, const std::string& outputPath);
+    bool isRunning() const { return running; }
+
+    // Extra "key": "value" pairs written to the top level of the report (scene, settings, ...).
+    void setInfo(const std::string& key, const std::string& value);
+
+    // Returns true once the configured duration has elapsed and the report was written.
+    bool recordFrame(float frameSeconds, const FrameStats& stats);
+
+private:
+    struct Sample {
+        float frameMs;
+        FrameStats stats;
+    };
+
+    bool writeReport() const;
+
+    bool running;
+    float duration;
+    float elapsed;
+    std::string outputPath;
+    std::vector<std::pair<std::string, std::string> > info;
+    std::vector<Sample> samples;
+};
+
+#endif
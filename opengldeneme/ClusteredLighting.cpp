@@ -0,0 +1,249 @@
+// ClusteredLighting.cpp
+#include "ClusteredLighting.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+ClusteredLighting::ClusteredLighting()
+    : lightBuffer(0), lightTexture(0), gridBuffer(0), gridTexture(0), indexBuffer(0), indexTexture(0),
+    boundsProjection(0.0f), nearZ(0.0f), farZ(0.0f), zScale(0.0f), zBias(0.0f), width(0), height(0),
+    uploadedLights(0), uploadedIndices(0), busiestCluster(0), assignMs(0.0f) {
+}
+
+static void createTextureBuffer(GLuint& buffer, GLuint& texture, GLenum format) {
+    GLState& state = GLState::get();
+    glGenBuffers(1, &buffer);
+    state.bindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &texture);
+    state.bindTexture(0, GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+void ClusteredLighting::init() {
+    createTextureBuffer(lightBuffer, lightTexture, GL_RGBA32F);
+    createTextureBuffer(gridBuffer, gridTexture, GL_RG32UI);
+    createTextureBuffer(indexBuffer, indexTexture, GL_R32UI);
+
+    clusterMin.resize(CLUSTER_COUNT);
+    clusterMax.resize(CLUSTER_COUNT);
+    sliceLights.resize(CLUSTERS_Z);
+    clusterCounts.resize(CLUSTER_COUNT);
+    clusterLights.resize((size_t)CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+    gridData.resize(CLUSTER_COUNT * 2);
+}
+
+void ClusteredLighting::shutdown() {
+    GLState& state = GLState::get();
+    state.deleteTexture(lightTexture);
+    state.deleteTexture(gridTexture);
+    state.deleteTexture(indexTexture);
+    state.deleteBuffer(lightBuffer);
+    state.deleteBuffer(gridBuffer);
+    state.deleteBuffer(indexBuffer);
+    lightTexture = gridTexture = indexTexture = 0;
+    lightBuffer = gridBuffer = indexBuffer = 0;
+}
+
+int ClusteredLighting::sliceForDepth(float depth) const {
+    int slice = static_cast<int>(std::floor(std::log(std::max(depth, nearZ)) * zScale - zBias));
+    return std::min(std::max(slice, 0), CLUSTERS_Z - 1);
+}
+
+// Exponential depth slices: slice k spans near * (far/near)^(k/Z) .. near * (far/near)^((k+1)/Z).
+void ClusteredLighting::rebuildClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane) {
+    boundsProjection = projection;
+    nearZ = nearPlane;
+    farZ = farPlane;
+    zScale = CLUSTERS_Z / std::log(farPlane / nearPlane);
+    zBias = std::log(nearPlane) * zScale;
+
+    float invX = 1.0f / projection[0][0];
+    float invY = 1.0f / projection[1][1];
+    for (int z = 0; z < CLUSTERS_Z; ++z) {
+        float depthNear = nearPlane * std::pow(farPlane / nearPlane, (float)z / CLUSTERS_Z);
+        float depthFar = nearPlane * std::pow(farPlane / nearPlane, (float)(z + 1) / CLUSTERS_Z);
+        for (int y = 0; y < CLUSTERS_Y; ++y) {
+            float ndcY0 = -1.0f + 2.0f * y / CLUSTERS_Y;
+            float ndcY1 = -1.0f + 2.0f * (y + 1) / CLUSTERS_Y;
+            for (int x = 0; x < CLUSTERS_X; ++x) {
+                float ndcX0 = -1.0f + 2.0f * x / CLUSTERS_X;
+                float ndcX1 = -1.0f + 2.0f * (x + 1) / CLUSTERS_X;
+                glm::vec3 lo(1e30f), hi(-1e30f);
+                const float depths[2] = { depthNear, depthFar };
+                for (int d = 0; d < 2; ++d) {
+                    const float xs[2] = { ndcX0, ndcX1 };
+                    const float ys[2] = { ndcY0, ndcY1 };
+                    for (int i = 0; i < 2; ++i) {
+                        for (int j = 0; j < 2; ++j) {
+                            glm::vec3 p(xs[i] * depths[d] * invX, ys[j] * depths[d] * invY, -depths[d]);
+                            lo = glm::min(lo, p);
+                            hi = glm::max(hi, p);
+                        }
+                    }
+                }
+                int index = x + y * CLUSTERS_X + z * CLUSTERS_X * CLUSTERS_Y;
+                clusterMin[index] = lo;
+                clusterMax[index] = hi;
+            }
+        }
+    }
+}
+
+void ClusteredLighting::computeLightBounds(const std::vector<GalleryLight>& lights, const glm::mat4& view, const glm::mat4& projection) {
+    bounds.resize(lights.size());
+    for (auto& slice : sliceLights) slice.clear();
+
+    for (size_t i = 0; i < lights.size(); ++i) {
+        const GalleryLight& light = lights[i];
+        LightBounds& b = bounds[i];
+
+        // Tight bounding sphere of the spot cone, or the range sphere for point lights.
+        glm::vec3 center = light.position;
+        float radius = light.range;
+        if (light.cosOuterCutOff > 0.0f) {
+            float cosAngle = light.cosOuterCutOff;
+            glm::vec3 dir = glm::normalize(light.direction);
+            if (cosAngle < 0.70710678f) {
+                center = light.position + dir * (light.range * cosAngle);
+                radius = light.range * std::sqrt(1.0f - cosAngle * cosAngle);
+            }
+            else {
+                radius = light.range / (2.0f * cosAngle);
+                center = light.position + dir * radius;
+            }
+        }
+        b.viewCenter = glm::vec3(view * glm::vec4(center, 1.0f));
+        b.radius = radius;
+        b.minX = 0; b.maxX = -1; // empty unless proven visible
+
+        float depthMin = -b.viewCenter.z - radius;
+        float depthMax = -b.viewCenter.z + radius;
+        if (depthMax < nearZ || depthMin > farZ) continue;
+        b.minZ = sliceForDepth(depthMin);
+        b.maxZ = sliceForDepth(depthMax);
+
+        if (depthMin <= nearZ) {
+            // Sphere crosses the near plane, its projection is unbounded.
+            b.minX = 0; b.maxX = CLUSTERS_X - 1;
+            b.minY = 0; b.maxY = CLUSTERS_Y - 1;
+        }
+        else {
+            glm::vec2 lo(1e30f), hi(-1e30f);
+            for (int corner = 0; corner < 8; ++corner) {
+                glm::vec3 p = b.viewCenter + glm::vec3((corner & 1) ? radius : -radius,
+                    (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+                glm::vec4 clip = projection * glm::vec4(p, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                lo = glm::min(lo, ndc);
+                hi = glm::max(hi, ndc);
+            }
+            if (hi.x < -1.0f || lo.x > 1.0f || hi.y < -1.0f || lo.y > 1.0f) continue;
+            b.minX = std::max(0, (int)std::floor((lo.x * 0.5f + 0.5f) * CLUSTERS_X));
+            b.maxX = std::min(CLUSTERS_X - 1, (int)std::floor((hi.x * 0.5f + 0.5f) * CLUSTERS_X));
+            b.minY = std::max(0, (int)std::floor((lo.y * 0.5f + 0.5f) * CLUSTERS_Y));
+            b.maxY = std::min(CLUSTERS_Y - 1, (int)std::floor((hi.y * 0.5f + 0.5f) * CLUSTERS_Y));
+        }
+        for (int z = b.minZ; z <= b.maxZ; ++z) sliceLights[z].push_back(static_cast<unsigned int>(i));
+    }
+}
+
+// Each slice owns its clusters, so jobs never write to the same list.
+void ClusteredLighting::assignSlice(int z) {
+    const int sliceBase = z * CLUSTERS_X * CLUSTERS_Y;
+    for (int c = 0; c < CLUSTERS_X * CLUSTERS_Y; ++c) clusterCounts[sliceBase + c] = 0;
+
+    for (unsigned int lightIndex : sliceLights[z]) {
+        const LightBounds& b = bounds[lightIndex];
+        float radiusSq = b.radius * b.radius;
+        for (int y = b.minY; y <= b.maxY; ++y) {
+            for (int x = b.minX; x <= b.maxX; ++x) {
+                int cluster = sliceBase + x + y * CLUSTERS_X;
+                glm::vec3 closest = glm::clamp(b.viewCenter, clusterMin[cluster], clusterMax[cluster]);
+                glm::vec3 delta = closest - b.viewCenter;
+                if (glm::dot(delta, delta) > radiusSq) continue;
+                unsigned int& count = clusterCounts[cluster];
+                if (count < (unsigned int)MAX_LIGHTS_PER_CLUSTER) {
+                    clusterLights[(size_t)cluster * MAX_LIGHTS_PER_CLUSTER + count++] = lightIndex;
+                }
+            }
+        }
+    }
+}
+
+void ClusteredLighting::update(const std::vector<GalleryLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+    float nearPlane, float farPlane, int viewportWidth, int viewportHeight) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (projection != boundsProjection || nearPlane != nearZ || farPlane != farZ) {
+        rebuildClusterBounds(projection, nearPlane, farPlane);
+    }
+    width = viewportWidth;
+    height = viewportHeight;
+
+    computeLightBounds(lights, view, projection);
+    // Each slice is one job
+    JobSystem::get().parallelFor(0, CLUSTERS_Z, 1, [this](int first, int last) {
+        for (int slice = first; slice < last; ++slice) assignSlice(slice);
+    });
+
+    // Compact the per-cluster lists into one index buffer.
+    indexData.clear();
+    busiestCluster = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        unsigned int count = clusterCounts[cluster];
+        gridData[cluster * 2] = static_cast<unsigned int>(indexData.size());
+        gridData[cluster * 2 + 1] = count;
+        const unsigned int* list = &clusterLights[(size_t)cluster * MAX_LIGHTS_PER_CLUSTER];
+        indexData.insert(indexData.end(), list, list + count);
+        busiestCluster = std::max(busiestCluster, count);
+    }
+    if (indexData.empty()) indexData.push_back(0);
+
+    lightData.resize(std::max<size_t>(lights.size(), 1) * 16);
+    for (size_t i = 0; i < lights.size(); ++i) {
+        const GalleryLight& light = lights[i];
+        float* texel = &lightData[i * 16];
+        glm::vec3 dir = glm::length(light.direction) > 0.0f ? glm::normalize(light.direction) : glm::vec3(0.0f, -1.0f, 0.0f);
+        texel[0] = light.position.x; texel[1] = light.position.y; texel[2] = light.position.z; texel[3] = light.range;
+        texel[4] = light.color.r; texel[5] = light.color.g; texel[6] = light.color.b; texel[7] = light.cosInnerCutOff;
+        texel[8] = dir.x; texel[9] = dir.y; texel[10] = dir.z; texel[11] = light.cosOuterCutOff;
+        texel[12] = static_cast<float>(light.shadowIndex); texel[13] = texel[14] = texel[15] = 0.0f;
+    }
+
+    // Orphan and refill; the previous frame may still be reading the old storage.
+    GLState& state = GLState::get();
+    RenderStats& stats = RenderStats::get();
+    size_t lightBytes = lightData.size() * sizeof(float);
+    size_t gridBytes = gridData.size() * sizeof(unsigned int);
+    size_t indexBytes = indexData.size() * sizeof(unsigned int);
+    state.bindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, lightBytes, lightData.data(), GL_STREAM_DRAW);
+    state.bindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, gridBytes, gridData.data(), GL_STREAM_DRAW);
+    state.bindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, indexBytes, indexData.data(), GL_STREAM_DRAW);
+    stats.recordBufferUpload(lightBytes + gridBytes + indexBytes);
+
+    uploadedLights = static_cast<unsigned int>(lights.size());
+    uploadedIndices = static_cast<unsigned int>(indexData.size());
+    assignMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ClusteredLighting::apply(Shader& shader) const {
+    GLState& state = GLState::get();
+    shader.use();
+    state.bindTexture(LIGHT_DATA_UNIT, GL_TEXTURE_BUFFER, lightTexture);
+    state.bindTexture(CLUSTER_GRID_UNIT, GL_TEXTURE_BUFFER, gridTexture);
+    state.bindTexture(LIGHT_INDEX_UNIT, GL_TEXTURE_BUFFER, indexTexture);
+    shader.setInt("lightData", LIGHT_DATA_UNIT);
+    shader.setInt("clusterGrid", CLUSTER_GRID_UNIT);
+    shader.setInt("lightIndices", LIGHT_INDEX_UNIT);
+    shader.setIVec3("clusterDims", CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z);
+    shader.setVec2("clusterTileSize", glm::vec2((float)width / CLUSTERS_X, (float)height / CLUSTERS_Y));
+    shader.setFloat("clusterZScale", zScale);
+    shader.setFloat("clusterZBias", zBias);
+}
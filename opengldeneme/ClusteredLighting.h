@@ -0,0 +1,83 @@
+#pragma once
+// ClusteredLighting.h
+// Clustered forward lighting: the view frustum is split into froxels (screen tiles x exponential
+// depth slices), lights are assigned to the froxels they touch on the CPU, and the fragment
+// shader only loops over the list of its own cluster. Light data, the cluster grid and the light
+// index list are uploaded as texture buffers.
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "GalleryLayout.h"
+#include "Shader.h"
+
+class ClusteredLighting {
+public:
+    static const int CLUSTERS_X = 16;
+    static const int CLUSTERS_Y = 9;
+    static const int CLUSTERS_Z = 24;
+    static const int CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+    static const int MAX_LIGHTS_PER_CLUSTER = 256;
+
+    // Texture units the shader samples the light buffers from.
+    static const int LIGHT_DATA_UNIT = 1;
+    static const int CLUSTER_GRID_UNIT = 2;
+    static const int LIGHT_INDEX_UNIT = 3;
+
+    ClusteredLighting();
+
+    void init();
+    void shutdown();
+
+    // Assigns the lights to clusters for this view and uploads the result.
+    void update(const std::vector<GalleryLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+        float nearPlane, float farPlane, int viewportWidth, int viewportHeight);
+
+    // Binds the buffers and sets the cluster uniforms on a shader that includes the clustered light loop.
+    void apply(Shader& shader) const;
+
+    unsigned int lightCount() const { return uploadedLights; }
+    unsigned int assignedIndices() const { return uploadedIndices; }
+    unsigned int maxLightsInCluster() const { return busiestCluster; }
+    float assignMilliseconds() const { return assignMs; }
+
+private:
+    struct LightBounds {
+        glm::vec3 viewCenter;
+        float radius;
+        int minX, maxX, minY, maxY, minZ, maxZ;
+    };
+
+    void rebuildClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane);
+    void computeLightBounds(const std::vector<GalleryLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+    void assignSlice(int slice);
+    int sliceForDepth(float depth) const;
+
+    GLuint lightBuffer, lightTexture;
+    GLuint gridBuffer, gridTexture;
+    GLuint indexBuffer, indexTexture;
+
+    // Cluster AABBs in view space, rebuilt when the projection changes.
+    std::vector<glm::vec3> clusterMin, clusterMax;
+    glm::mat4 boundsProjection;
+    float nearZ, farZ;
+    float zScale, zBias;
+    int width, height;
+
+    std::vector<LightBounds> bounds;
+    std::vector<std::vector<unsigned int> > sliceLights; // lights touching each depth slice
+    std::vector<unsigned int> clusterCounts;
+    std::vector<unsigned int> clusterLights;             // CLUSTER_COUNT x MAX_LIGHTS_PER_CLUSTER
+    std::vector<unsigned int> gridData;                  // offset, count per cluster
+    std::vector<unsigned int> indexData;
+    std::vector<float> lightData;
+
+    unsigned int uploadedLights;
+    unsigned int uploadedIndices;
+    unsigned int busiestCluster;
+    float assignMs;
+};
+
+#endif
@@ -0,0 +1,43 @@
+// DeferredRenderer.cpp
+#include "DeferredRenderer.h"
+#include "GLState.h"
+#include "RenderStats.h"
+
+namespace {
+    const GLenum TARGET_FORMATS[DeferredRenderer::TARGET_COUNT] = { GL_RGBA8, GL_RGBA16, GL_R11F_G11F_B10F };
+    const size_t TARGET_BYTES[DeferredRenderer::TARGET_COUNT] = { 4, 8, 4 };
+    const int TARGET_UNITS[DeferredRenderer::TARGET_COUNT] = {
+        DeferredRenderer::ALBEDO_UNIT, DeferredRenderer::NORMAL_UNIT, DeferredRenderer::INDIRECT_UNIT
+    };
+    const char* const TARGET_SAMPLERS[DeferredRenderer::TARGET_COUNT] = { "gAlbedo", "gNormal", "gIndirect" };
+}
+
+RenderTargetDesc DeferredRenderer::targetDesc(int target, int width, int height) {
+    return RenderTargetDesc(TARGET_FORMATS[target], width, height);
+}
+
+size_t DeferredRenderer::gbufferBytes(int width, int height) {
+    size_t bytesPerPixel = 4; // depth
+    for (int i = 0; i < TARGET_COUNT; ++i) bytesPerPixel += TARGET_BYTES[i];
+    return bytesPerPixel * width * height;
+}
+
+void DeferredRenderer::light(Shader& lightingShader, const glm::mat4& projection, const glm::mat4& view,
+    const GLuint targets[TARGET_COUNT], GLuint depthTexture) {
+    GLState& state = GLState::get();
+    state.disable(GL_DEPTH_TEST);
+
+    lightingShader.use();
+    for (int i = 0; i < TARGET_COUNT; ++i) {
+        state.bindTexture(TARGET_UNITS[i], GL_TEXTURE_2D, targets[i]);
+        lightingShader.setInt(TARGET_SAMPLERS[i], TARGET_UNITS[i]);
+    }
+    state.bindTexture(DEPTH_UNIT, GL_TEXTURE_2D, depthTexture);
+    lightingShader.setInt("gDepth", DEPTH_UNIT);
+    lightingShader.setMat4("inverseProjection", glm::inverse(projection));
+    lightingShader.setMat4("inverseView", glm::inverse(view));
+    state.bindFullscreenVertexArray();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+    state.enable(GL_DEPTH_TEST);
+}
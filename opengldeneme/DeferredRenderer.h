@@ -0,0 +1,40 @@
+#pragma once
+// DeferredRenderer.h
+// G-buffer for the deferred path. The geometry pass writes the surface of every pixel into three
+// compact targets plus depth; one full-screen pass of basic.frag (DEFERRED) then lights each
+// pixel once, looking its lights up in the same cluster lists as the forward path. The targets
+// themselves are transient render graph targets.
+//   albedo    RGBA8           base color, roughness
+//   normal    RGBA16          octahedral normal, metalness, gallery ambient flag
+//   indirect  R11F_G11F_B10F  baked or flat ambient light, already times base color
+//   depth     DEPTH24         world position is reconstructed from it
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "RenderGraph.h"
+#include "Shader.h"
+
+class DeferredRenderer {
+public:
+    static const int TARGET_COUNT = 3;
+    // Texture units of the albedo, normal, indirect and depth targets in the lighting pass.
+    static const int ALBEDO_UNIT = 10;
+    static const int NORMAL_UNIT = 11;
+    static const int INDIRECT_UNIT = 12;
+    static const int DEPTH_UNIT = 13;
+
+    // Color target i (albedo, normal, indirect) at width x height. Draw the scene into them and
+    // a depth target with the GBUFFER variants, using the usual depth state.
+    static RenderTargetDesc targetDesc(int target, int width, int height);
+    static size_t gbufferBytes(int width, int height);
+
+    // Lights every covered pixel of the current viewport with lightingShader, which the caller
+    // has already set up with the light uniforms. The G-buffer is read pixel for pixel, so it may
+    // be larger than the viewport. The background keeps its clear color.
+    void light(Shader& lightingShader, const glm::mat4& projection, const glm::mat4& view,
+        const GLuint targets[TARGET_COUNT], GLuint depthTexture);
+};
+
+#endif
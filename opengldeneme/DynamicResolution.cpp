@@ -0,0 +1,115 @@
+// DynamicResolution.cpp
+#include "DynamicResolution.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Fraction of the frame budget aimed for, so small spikes don't miss it
+    const float BUDGET_HEADROOM = 0.9f;
+    // Largest change of the scale per step: drop quickly when over budget, recover gently
+    const float MAX_SCALE_DROP = 0.1f;
+    const float MAX_SCALE_RISE = 0.05f;
+    // Smaller corrections are ignored so the resolution doesn't flicker around the target
+    const float SCALE_DEADBAND = 0.02f;
+    const float SHARPEN_STRENGTH = 0.5f;
+}
+
+DynamicResolution::DynamicResolution()
+    : sceneWidth(0), sceneHeight(0), active(false), sharpen(false), currentScale(1.0f),
+      currentQuery(0), gpuMs(0.0f), measuredAtScale(false) {
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries[i] = 0;
+        pending[i] = false;
+        queryScale[i] = 1.0f;
+    }
+}
+
+void DynamicResolution::shutdown() {
+    if (queries[0]) glDeleteQueries(QUERY_COUNT, queries);
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries[i] = 0;
+        pending[i] = false;
+    }
+}
+
+void DynamicResolution::beginFrame(const DynamicResolutionSettings& settings, int width, int height) {
+    if (!queries[0]) glGenQueries(QUERY_COUNT, queries);
+    collectQueries();
+
+    active = settings.enabled && width > 0 && height > 0; // minimized windows have no framebuffer
+    sharpen = settings.sharpen;
+    if (active) {
+        updateScale(settings);
+    }
+    else {
+        currentScale = 1.0f;
+    }
+    sceneWidth = std::max(1, static_cast<int>(std::lround(width * currentScale)));
+    sceneHeight = std::max(1, static_cast<int>(std::lround(height * currentScale)));
+
+    queryScale[currentQuery] = currentScale;
+    glBeginQuery(GL_TIME_ELAPSED, queries[currentQuery]);
+}
+
+void DynamicResolution::endFrame() {
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[currentQuery] = true;
+    currentQuery = (currentQuery + 1) % QUERY_COUNT;
+}
+
+RenderTargetDesc DynamicResolution::sceneColorDesc(int width, int height) {
+    // Bilinear, the upscale pass samples it between texels
+    return RenderTargetDesc(GL_RGBA8, width, height, GL_LINEAR, glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+}
+
+void DynamicResolution::upscale(Shader& upscaleShader, GLuint sceneTexture) {
+    GLState& state = GLState::get();
+    state.disable(GL_DEPTH_TEST);
+    state.disable(GL_BLEND);
+
+    upscaleShader.use();
+    state.bindTexture(SCENE_UNIT, GL_TEXTURE_2D, sceneTexture);
+    upscaleShader.setInt("sceneColor", SCENE_UNIT);
+    upscaleShader.setVec2("sceneSize", glm::vec2(static_cast<float>(sceneWidth), static_cast<float>(sceneHeight)));
+    upscaleShader.setFloat("sharpness", sharpen ? SHARPEN_STRENGTH : 0.0f);
+    state.bindFullscreenVertexArray();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+    state.enable(GL_DEPTH_TEST);
+}
+
+void DynamicResolution::collectQueries() {
+    // Oldest first; the current slot is the oldest and about to be reused, so if it is somehow
+    // still running we wait for it.
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        int slot = (currentQuery + i) % QUERY_COUNT;
+        if (!pending[slot]) continue;
+        GLuint available = 0;
+        if (i > 0) glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (i > 0 && !available) break;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        gpuMs = static_cast<float>(nanoseconds / 1.0e6);
+        measuredAtScale = queryScale[slot] == currentScale;
+        pending[slot] = false;
+    }
+}
+
+void DynamicResolution::updateScale(const DynamicResolutionSettings& settings) {
+    float scale = currentScale;
+    // Until a frame drawn at the current scale has been timed, the measurement says nothing about it
+    if (measuredAtScale && gpuMs > 0.0f) {
+        // GPU time goes roughly with the pixel count, the square of the scale
+        float desired = scale * std::sqrt(settings.targetFrameMs * BUDGET_HEADROOM / gpuMs);
+        float change = glm::clamp(desired - scale, -MAX_SCALE_DROP, MAX_SCALE_RISE);
+        if (std::fabs(change) >= SCALE_DEADBAND) scale += change;
+    }
+    scale = glm::clamp(scale, glm::clamp(settings.minScale, 0.1f, 1.0f), 1.0f);
+    if (scale != currentScale) {
+        currentScale = scale;
+        measuredAtScale = false;
+    }
+}
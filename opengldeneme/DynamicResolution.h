@@ -0,0 +1,69 @@
+#pragma once
+// DynamicResolution.h
+// Renders the scene into an offscreen target at a fraction of the window's resolution and
+// scales it up, so a slow GPU can hold its frame rate in heavy galleries. The fraction is set by
+// a controller fed by a GPU timer query around the frame, read back a few frames late so it
+// never stalls. The scene targets (render graph targets) keep the window's size and the scene is
+// drawn into their lower left corner, so changing the scale never reallocates anything. The UI
+// is drawn afterwards at native resolution.
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+#include "RenderGraph.h"
+#include "Shader.h"
+
+struct DynamicResolutionSettings {
+    bool enabled;
+    float targetFrameMs;  // GPU time to aim for
+    float minScale;       // of the window's width and height
+    bool sharpen;         // sharpen while scaling up instead of plain bilinear
+
+    DynamicResolutionSettings() : enabled(false), targetFrameMs(1000.0f / 60.0f), minScale(0.5f), sharpen(true) {}
+};
+
+class DynamicResolution {
+public:
+    static const int QUERY_COUNT = 4;
+    // Texture unit the upscale pass samples the scene from.
+    static const int SCENE_UNIT = 0;
+
+    DynamicResolution();
+
+    void shutdown();
+
+    // Starts the frame's GPU timer and picks the scale from the latest finished measurement.
+    // Then renderWidth() x renderHeight() is the scene's viewport; while isScaling() the scene
+    // goes into a target of the window's size and upscale() draws it to the window.
+    void beginFrame(const DynamicResolutionSettings& settings, int windowWidth, int windowHeight);
+    // Stops the GPU timer.
+    void endFrame();
+
+    static RenderTargetDesc sceneColorDesc(int width, int height);
+    // Scales the scene up into the current framebuffer, which has the window's size.
+    void upscale(Shader& upscaleShader, GLuint sceneTexture);
+
+    bool isScaling() const { return active; }
+    int renderWidth() const { return sceneWidth; }
+    int renderHeight() const { return sceneHeight; }
+    float scale() const { return currentScale; }
+    float gpuMilliseconds() const { return gpuMs; }
+
+private:
+    void collectQueries();
+    void updateScale(const DynamicResolutionSettings& settings);
+
+    int sceneWidth, sceneHeight;
+    bool active;
+    bool sharpen;
+    float currentScale;
+
+    GLuint queries[QUERY_COUNT];
+    bool pending[QUERY_COUNT];
+    float queryScale[QUERY_COUNT]; // scale the timed frame was drawn at
+    int currentQuery;
+    float gpuMs;
+    bool measuredAtScale;          // gpuMs is from a frame drawn at currentScale
+};
+
+#endif
@@ -0,0 +1,563 @@
+// FontAtlasCache.cpp
+#include "FontAtlasCache.h"
+#include "JobSystem.h"
+#include "imgui/imgui_internal.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+    const unsigned int FILE_MAGIC = 0x41465356; // "VSFA"
+    const unsigned int FILE_VERSION = 1;
+    // Chunks per thread, so a chunk dense in glyphs doesn't leave the other threads idle.
+    const unsigned int CHUNKS_PER_THREAD = 2;
+    const unsigned int MIN_CHUNK_CODEPOINTS = 64;
+    const int MAX_TEXTURE_SIZE = 32768;
+    const unsigned int MAX_CUSTOM_RECTS = 16;
+
+    struct FileHeader {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long key;
+        int width, height;
+        unsigned int fontCount;
+        unsigned int rectCount;
+        ImVec2 uvWhitePixel;
+        ImVec4 uvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    };
+
+    struct FontRecord {
+        float size, ascent, descent;
+        unsigned int glyphCount;
+    };
+
+    struct GlyphRecord {
+        unsigned int codepoint;
+        unsigned int flags;     // 1: visible, 2: colored
+        float advanceX;
+        float x0, y0, x1, y1;
+        float u0, v0, u1, v1;
+    };
+
+    struct BakedFont {
+        float size, ascent, descent;
+        std::vector<ImFontGlyph> glyphs;    // without the tab ImFont::BuildLookupTable() adds
+    };
+
+    // What ImFontAtlas::Build() leaves in the atlas, apart from the lookup tables.
+    struct BakedAtlas {
+        int width, height;
+        std::vector<unsigned char> pixels;  // alpha
+        ImVec2 uvWhitePixel;
+        ImVec4 uvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+        std::vector<unsigned short> rects;  // x, y of each custom rectangle
+        std::vector<BakedFont> fonts;
+
+        BakedAtlas() : width(0), height(0), uvWhitePixel(0.0f, 0.0f), uvLines() {}
+    };
+
+    struct Interval {
+        unsigned int first, last;
+    };
+
+    struct ChunkJob {
+        int fontIndex;                      // in ImFontAtlas::Fonts
+        std::vector<Interval> codepoints;
+        bool defaultRects;                  // bakes the cursor and line rectangles
+        bool baked;
+
+        // The chunk's own atlas, its one font holding these codepoints only
+        int width, height;
+        std::vector<unsigned char> pixels;
+        BakedFont font;
+        std::vector<ImFontAtlasCustomRect> rects;
+        int cursorRect, lineRect;
+        ImVec2 uvWhitePixel;
+        ImVec4 uvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+
+        ChunkJob() : fontIndex(0), defaultRects(false), baked(false), width(0), height(0), cursorRect(-1), lineRect(-1),
+            uvWhitePixel(0.0f, 0.0f), uvLines() {}
+    };
+
+    // A glyph or custom rectangle of a chunk, and where it goes in the atlas.
+    struct PackedRect {
+        size_t job;
+        int glyph;              // in the chunk's font, or -1
+        int rect;               // in the chunk's custom rectangles, or -1
+        int x, y, width, height;
+        int atlasX, atlasY;
+    };
+
+    void hashBytes(unsigned long long& hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull; // FNV-1a
+        }
+    }
+
+    const ImWchar* sourceRanges(ImFontAtlas& atlas, const ImFontConfig& source) {
+        return source.GlyphRanges ? source.GlyphRanges : atlas.GetGlyphRangesDefault();
+    }
+
+    int fontIndex(const ImFontAtlas& atlas, const ImFont* font) {
+        for (int i = 0; i < atlas.Fonts.Size; ++i) {
+            if (atlas.Fonts[i] == font) return i;
+        }
+        return -1;
+    }
+
+    unsigned long long atlasKey(ImFontAtlas& atlas) {
+        unsigned long long hash = 14695981039346656037ull;
+        const int settings[] = { (int)FILE_VERSION, IMGUI_VERSION_NUM, (int)sizeof(ImWchar), atlas.Flags,
+            atlas.TexDesiredWidth, atlas.TexGlyphPadding, (int)atlas.FontBuilderFlags, atlas.Sources.Size };
+        hashBytes(hash, settings, sizeof(settings));
+        for (const ImFontConfig& source : atlas.Sources) {
+            const int sourceSettings[] = { fontIndex(atlas, source.DstFont), source.FontDataSize, source.FontNo,
+                source.OversampleH, source.OversampleV, source.PixelSnapH, source.MergeMode,
+                (int)source.FontBuilderFlags, (int)source.EllipsisChar };
+            const float metrics[] = { source.SizePixels, source.GlyphExtraAdvanceX, source.GlyphOffset.x, source.GlyphOffset.y,
+                source.GlyphMinAdvanceX, source.GlyphMaxAdvanceX, source.RasterizerMultiply, source.RasterizerDensity };
+            hashBytes(hash, sourceSettings, sizeof(sourceSettings));
+            hashBytes(hash, metrics, sizeof(metrics));
+            hashBytes(hash, source.FontData, source.FontDataSize);
+            const ImWchar* range = sourceRanges(atlas, source);
+            for (; range[0] && range[1]; range += 2) hashBytes(hash, range, 2 * sizeof(ImWchar));
+            hashBytes(hash, range, sizeof(ImWchar)); // the terminator keeps one source's ranges from running into the next
+        }
+        return hash;
+    }
+
+    // The codepoints any source of the font asks for, sorted and without overlaps.
+    std::vector<Interval> requestedCodepoints(ImFontAtlas& atlas, int font) {
+        std::vector<Interval> requested;
+        for (const ImFontConfig& source : atlas.Sources) {
+            if (source.DstFont != atlas.Fonts[font]) continue;
+            for (const ImWchar* range = sourceRanges(atlas, source); range[0] && range[1]; range += 2) {
+                Interval interval = { range[0], range[1] };
+                requested.push_back(interval);
+            }
+        }
+        std::sort(requested.begin(), requested.end(), [](const Interval& a, const Interval& b) { return a.first < b.first; });
+        std::vector<Interval> merged;
+        for (const Interval& interval : requested) {
+            if (!merged.empty() && interval.first <= merged.back().last + 1) merged.back().last = std::max(merged.back().last, interval.last);
+            else merged.push_back(interval);
+        }
+        return merged;
+    }
+
+    unsigned int codepointCount(const std::vector<Interval>& intervals) {
+        unsigned int count = 0;
+        for (const Interval& interval : intervals) count += interval.last - interval.first + 1;
+        return count;
+    }
+
+    // Cuts the intervals into up to chunkCount runs of nearly the same number of codepoints.
+    std::vector<std::vector<Interval> > splitCodepoints(const std::vector<Interval>& intervals, unsigned int chunkCount) {
+        std::vector<std::vector<Interval> > chunks(1);
+        const unsigned int perChunk = (codepointCount(intervals) + chunkCount - 1) / chunkCount;
+        unsigned int taken = 0;
+        for (Interval rest : intervals) {
+            while (rest.first <= rest.last) {
+                if (taken == perChunk) {
+                    chunks.push_back(std::vector<Interval>());
+                    taken = 0;
+                }
+                Interval piece = { rest.first, std::min(rest.last, rest.first + (perChunk - taken) - 1) };
+                chunks.back().push_back(piece);
+                taken += piece.last - piece.first + 1;
+                rest.first = piece.last + 1;
+            }
+        }
+        return chunks;
+    }
+
+    bool inChunk(unsigned int codepoint, const std::vector<Interval>& chunk) {
+        for (const Interval& interval : chunk) {
+            if (codepoint >= interval.first && codepoint <= interval.last) return true;
+        }
+        return false;
+    }
+
+    // The source's ranges within the chunk, zero-terminated. withSpace adds U+0020, so the
+    // chunk's font has a glyph even when none of its codepoints are in the font.
+    void clipRanges(const ImWchar* ranges, const std::vector<Interval>& chunk, bool withSpace, std::vector<ImWchar>& clipped) {
+        if (withSpace) {
+            clipped.push_back(0x20);
+            clipped.push_back(0x20);
+        }
+        for (; ranges[0] && ranges[1]; ranges += 2) {
+            for (const Interval& interval : chunk) {
+                unsigned int first = std::max<unsigned int>(ranges[0], interval.first);
+                unsigned int last = std::min<unsigned int>(ranges[1], interval.last);
+                if (first > last) continue;
+                clipped.push_back(static_cast<ImWchar>(first));
+                clipped.push_back(static_cast<ImWchar>(last));
+            }
+        }
+        clipped.push_back(0);
+    }
+
+    void bakeChunk(ImFontAtlas& atlas, const ImFontBuilderIO* builder, ChunkJob& job) {
+        ImFontAtlas chunk;
+        chunk.Flags = atlas.Flags | ImFontAtlasFlags_NoPowerOfTwoHeight;
+        if (!job.defaultRects) chunk.Flags |= ImFontAtlasFlags_NoMouseCursors | ImFontAtlasFlags_NoBakedLines;
+        chunk.TexDesiredWidth = atlas.TexDesiredWidth;
+        chunk.TexGlyphPadding = atlas.TexGlyphPadding;
+        chunk.FontBuilderIO = builder;
+        chunk.FontBuilderFlags = atlas.FontBuilderFlags;
+
+        std::vector<std::vector<ImWchar> > ranges; // read by Build()
+        ranges.reserve(atlas.Sources.Size);
+        for (const ImFontConfig& source : atlas.Sources) {
+            if (source.DstFont != atlas.Fonts[job.fontIndex]) continue;
+            bool first = chunk.Fonts.Size == 0;
+            ranges.push_back(std::vector<ImWchar>());
+            clipRanges(sourceRanges(atlas, source), job.codepoints, first, ranges.back());
+            if (!first && ranges.back().size() == 1) continue; // nothing of this source in the chunk
+            ImFontConfig config = source;
+            config.FontDataOwnedByAtlas = false; // AddFont() takes a copy
+            config.DstFont = NULL;
+            config.MergeMode = !first;
+            config.GlyphRanges = ranges.back().data();
+            chunk.AddFont(&config);
+        }
+        if (chunk.Fonts.Size != 1 || !chunk.Build()) return;
+
+        job.width = chunk.TexWidth;
+        job.height = chunk.TexHeight;
+        job.pixels.assign(chunk.TexPixelsAlpha8, chunk.TexPixelsAlpha8 + chunk.TexWidth * chunk.TexHeight);
+        if (job.defaultRects) {
+            job.rects.assign(chunk.CustomRects.Data, chunk.CustomRects.Data + chunk.CustomRects.Size);
+            job.cursorRect = chunk.PackIdMouseCursors;
+            job.lineRect = chunk.PackIdLines;
+            job.uvWhitePixel = chunk.TexUvWhitePixel;
+            memcpy(job.uvLines, chunk.TexUvLines, sizeof(job.uvLines));
+        }
+        const ImFont* font = chunk.Fonts[0];
+        job.font.size = font->FontSize;
+        job.font.ascent = font->Ascent;
+        job.font.descent = font->Descent;
+        for (const ImFontGlyph& glyph : font->Glyphs) {
+            if (glyph.Codepoint != '\t' && inChunk(glyph.Codepoint, job.codepoints)) job.font.glyphs.push_back(glyph);
+        }
+        job.baked = true;
+    }
+
+    // Packs the glyphs and custom rectangles of all chunks into one texture, on shelves filled
+    // tallest first, and points their texture coordinates at their new places.
+    void packChunks(const ImFontAtlas& atlas, const std::vector<ChunkJob>& jobs, BakedAtlas& bake) {
+        std::vector<PackedRect> rects;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            const ChunkJob& job = jobs[i];
+            for (size_t g = 0; g < job.font.glyphs.size(); ++g) {
+                const ImFontGlyph& glyph = job.font.glyphs[g];
+                PackedRect rect = { i, (int)g, -1, (int)std::lround(glyph.U0 * job.width), (int)std::lround(glyph.V0 * job.height), 0, 0, 0, 0 };
+                rect.width = (int)std::lround(glyph.U1 * job.width) - rect.x;
+                rect.height = (int)std::lround(glyph.V1 * job.height) - rect.y;
+                rects.push_back(rect);
+            }
+            for (size_t r = 0; r < job.rects.size(); ++r) {
+                PackedRect rect = { i, -1, (int)r, job.rects[r].X, job.rects[r].Y, job.rects[r].Width, job.rects[r].Height, 0, 0 };
+                rects.push_back(rect);
+            }
+        }
+
+        // Each rectangle keeps the padding ImGui packs it with, to its left and top for glyphs
+        const int padding = atlas.TexGlyphPadding;
+        int width = atlas.TexDesiredWidth, widest = 0;
+        double surface = 0.0;
+        for (const PackedRect& rect : rects) {
+            widest = std::max(widest, rect.width + padding);
+            surface += (double)(rect.width + padding) * (rect.height + padding);
+        }
+        if (width <= 0) {
+            // ImGui's own choice for this much surface
+            int side = (int)std::sqrt(surface) + 1;
+            width = side >= 4096 * 0.7f ? 4096 : side >= 2048 * 0.7f ? 2048 : side >= 1024 * 0.7f ? 1024 : 512;
+        }
+        width = std::max(width, widest);
+        std::stable_sort(rects.begin(), rects.end(), [](const PackedRect& a, const PackedRect& b) { return a.height > b.height; });
+        int shelfX = 0, shelfY = 0, shelfHeight = 0;
+        for (PackedRect& rect : rects) {
+            if (shelfX + rect.width + padding > width) {
+                shelfY += shelfHeight;
+                shelfX = shelfHeight = 0;
+            }
+            rect.atlasX = shelfX;
+            rect.atlasY = shelfY;
+            shelfX += rect.width + padding;
+            shelfHeight = std::max(shelfHeight, rect.height + padding);
+        }
+        int height = shelfY + shelfHeight;
+        height = (atlas.Flags & ImFontAtlasFlags_NoPowerOfTwoHeight) ? height + 1 : ImUpperPowerOfTwo(height);
+
+        bake.width = width;
+        bake.height = height;
+        bake.pixels.assign((size_t)width * height, 0);
+        bake.fonts.resize(atlas.Fonts.Size);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            BakedFont& font = bake.fonts[jobs[i].fontIndex];
+            font.size = jobs[i].font.size;
+            font.ascent = jobs[i].font.ascent;
+            font.descent = jobs[i].font.descent;
+            font.glyphs.insert(font.glyphs.end(), jobs[i].font.glyphs.begin(), jobs[i].font.glyphs.end());
+        }
+        std::vector<size_t> firstGlyph(jobs.size()); // of each chunk in its font's glyphs
+        std::vector<size_t> glyphsSoFar(atlas.Fonts.Size, 0);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            firstGlyph[i] = glyphsSoFar[jobs[i].fontIndex];
+            glyphsSoFar[jobs[i].fontIndex] += jobs[i].font.glyphs.size();
+        }
+        if (!jobs.empty()) bake.rects.resize(jobs[0].rects.size() * 2);
+
+        const float scaleU = 1.0f / width, scaleV = 1.0f / height;
+        for (const PackedRect& rect : rects) {
+            const ChunkJob& job = jobs[rect.job];
+            const int offset = rect.glyph >= 0 ? padding : 0;
+            const int x = rect.atlasX + offset, y = rect.atlasY + offset;
+            for (int row = 0; row < rect.height; ++row) {
+                memcpy(&bake.pixels[(size_t)(y + row) * width + x], &job.pixels[(size_t)(rect.y + row) * job.width + rect.x], rect.width);
+            }
+            if (rect.glyph >= 0) {
+                ImFontGlyph& glyph = bake.fonts[job.fontIndex].glyphs[firstGlyph[rect.job] + rect.glyph];
+                glyph.U0 = x * scaleU;
+                glyph.V0 = y * scaleV;
+                glyph.U1 = (x + rect.width) * scaleU;
+                glyph.V1 = (y + rect.height) * scaleV;
+                continue;
+            }
+            bake.rects[2 * rect.rect] = static_cast<unsigned short>(x);
+            bake.rects[2 * rect.rect + 1] = static_cast<unsigned short>(y);
+            // The white pixel and the line UVs move with the rectangle they are in
+            const float moveU = (float)(x - rect.x) / job.width, moveV = (float)(y - rect.y) / job.height;
+            const float toU = (float)job.width / width, toV = (float)job.height / height;
+            if (rect.rect == job.cursorRect) {
+                bake.uvWhitePixel = ImVec2((job.uvWhitePixel.x + moveU) * toU, (job.uvWhitePixel.y + moveV) * toV);
+            }
+            if (rect.rect == job.lineRect) {
+                for (int n = 0; n <= IM_DRAWLIST_TEX_LINES_WIDTH_MAX; ++n) {
+                    const ImVec4& line = job.uvLines[n];
+                    bake.uvLines[n] = ImVec4((line.x + moveU) * toU, (line.y + moveV) * toV, (line.z + moveU) * toU, (line.w + moveV) * toV);
+                }
+            }
+        }
+    }
+
+    // Splits every font's codepoints into chunks and bakes them at the same time. Returns the
+    // number of chunks, or 0 if one of them failed to build.
+    unsigned int bakeInParallel(ImFontAtlas& atlas, BakedAtlas& bake) {
+        std::vector<std::vector<Interval> > requested(atlas.Fonts.Size);
+        unsigned int total = 0;
+        for (int font = 0; font < atlas.Fonts.Size; ++font) {
+            requested[font] = requestedCodepoints(atlas, font);
+            total += codepointCount(requested[font]);
+        }
+        const unsigned int target = JobSystem::get().threadCount() * CHUNKS_PER_THREAD;
+        std::vector<ChunkJob> jobs;
+        for (int font = 0; font < atlas.Fonts.Size; ++font) {
+            unsigned int count = codepointCount(requested[font]);
+            unsigned int chunkCount = total > 0 ? (target * count + total / 2) / total : 1;
+            chunkCount = std::max(1u, std::min(chunkCount, count / MIN_CHUNK_CODEPOINTS));
+            std::vector<std::vector<Interval> > chunks = splitCodepoints(requested[font], chunkCount);
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                jobs.push_back(ChunkJob());
+                jobs.back().fontIndex = font;
+                jobs.back().codepoints.swap(chunks[i]);
+                jobs.back().defaultRects = jobs.size() == 1;
+            }
+        }
+
+        // Left to Build(), every job would fetch the default builder, which writes a static.
+        const ImFontBuilderIO* builder = atlas.FontBuilderIO;
+#ifndef IMGUI_ENABLE_FREETYPE
+        if (builder == NULL) builder = ImFontAtlasGetBuilderForStbTruetype();
+#endif
+        // IM_ALLOC() counts allocations in the current context, which isn't thread-safe; nothing
+        // else uses ImGui while the fonts are built.
+        ImGuiContext* context = ImGui::GetCurrentContext();
+        ImGui::SetCurrentContext(NULL);
+        JobSystem::get().parallelFor(0, static_cast<int>(jobs.size()), 1, [&atlas, builder, &jobs](int first, int last) {
+            for (int i = first; i < last; ++i) bakeChunk(atlas, builder, jobs[i]);
+        });
+        ImGui::SetCurrentContext(context);
+
+        for (const ChunkJob& job : jobs) {
+            if (!job.baked) return 0;
+        }
+        packChunks(atlas, jobs, bake);
+        return static_cast<unsigned int>(jobs.size());
+    }
+
+    // Puts the bake into the atlas as Build() would have. False if it doesn't fit the atlas.
+    bool installBake(ImFontAtlas& atlas, const BakedAtlas& bake) {
+        if (bake.fonts.size() != (size_t)atlas.Fonts.Size) return false;
+        ImFontAtlasBuildInit(&atlas); // registers the cursor and line rectangles
+        if (bake.rects.size() != (size_t)atlas.CustomRects.Size * 2) return false;
+
+        atlas.ClearTexData();
+        atlas.TexWidth = bake.width;
+        atlas.TexHeight = bake.height;
+        atlas.TexUvScale = ImVec2(1.0f / bake.width, 1.0f / bake.height);
+        atlas.TexUvWhitePixel = bake.uvWhitePixel;
+        memcpy(atlas.TexUvLines, bake.uvLines, sizeof(atlas.TexUvLines));
+        atlas.TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(bake.pixels.size()));
+        memcpy(atlas.TexPixelsAlpha8, bake.pixels.data(), bake.pixels.size());
+        for (int i = 0; i < atlas.CustomRects.Size; ++i) {
+            atlas.CustomRects[i].X = bake.rects[2 * i];
+            atlas.CustomRects[i].Y = bake.rects[2 * i + 1];
+        }
+        const float padding = atlas.TexGlyphPadding + 0.99f;
+        for (int i = 0; i < atlas.Fonts.Size; ++i) {
+            ImFont* font = atlas.Fonts[i];
+            const BakedFont& baked = bake.fonts[i];
+            font->ClearOutputData();
+            font->ContainerAtlas = &atlas;
+            font->FontSize = baked.size;
+            font->Ascent = baked.ascent;
+            font->Descent = baked.descent;
+            font->Glyphs.resize(static_cast<int>(baked.glyphs.size()));
+            if (!baked.glyphs.empty()) memcpy(font->Glyphs.Data, baked.glyphs.data(), font->Glyphs.size_in_bytes());
+            for (const ImFontGlyph& glyph : baked.glyphs) {
+                // As ImFont::AddGlyph() estimates it
+                font->MetricsTotalSurface += (int)((glyph.U1 - glyph.U0) * bake.width + padding) * (int)((glyph.V1 - glyph.V0) * bake.height + padding);
+            }
+            font->BuildLookupTable();
+        }
+        atlas.TexReady = true;
+        return true;
+    }
+
+    // fontCount is the atlas's, so a corrupt count is rejected before anything is sized by it.
+    bool readCache(const std::string& path, unsigned long long key, unsigned int fontCount, BakedAtlas& bake) {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        FileHeader header;
+        if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.key != key
+            || header.width <= 0 || header.width > MAX_TEXTURE_SIZE || header.height <= 0 || header.height > MAX_TEXTURE_SIZE
+            || header.fontCount != fontCount || header.rectCount > MAX_CUSTOM_RECTS) {
+            return false;
+        }
+        bake.width = header.width;
+        bake.height = header.height;
+        bake.uvWhitePixel = header.uvWhitePixel;
+        memcpy(bake.uvLines, header.uvLines, sizeof(bake.uvLines));
+        bake.fonts.resize(header.fontCount);
+        for (BakedFont& font : bake.fonts) {
+            FontRecord record;
+            if (!file.read(reinterpret_cast<char*>(&record), sizeof(record)) || record.glyphCount >= 0xFFFF) return false;
+            font.size = record.size;
+            font.ascent = record.ascent;
+            font.descent = record.descent;
+            std::vector<GlyphRecord> glyphs(record.glyphCount);
+            if (record.glyphCount > 0 && !file.read(reinterpret_cast<char*>(glyphs.data()), glyphs.size() * sizeof(GlyphRecord))) return false;
+            font.glyphs.resize(glyphs.size());
+            for (size_t i = 0; i < glyphs.size(); ++i) {
+                ImFontGlyph& glyph = font.glyphs[i];
+                glyph.Codepoint = glyphs[i].codepoint;
+                glyph.Visible = glyphs[i].flags & 1;
+                glyph.Colored = (glyphs[i].flags >> 1) & 1;
+                glyph.AdvanceX = glyphs[i].advanceX;
+                glyph.X0 = glyphs[i].x0;
+                glyph.Y0 = glyphs[i].y0;
+                glyph.X1 = glyphs[i].x1;
+                glyph.Y1 = glyphs[i].y1;
+                glyph.U0 = glyphs[i].u0;
+                glyph.V0 = glyphs[i].v0;
+                glyph.U1 = glyphs[i].u1;
+                glyph.V1 = glyphs[i].v1;
+            }
+        }
+        bake.rects.resize(header.rectCount * 2);
+        bake.pixels.resize((size_t)header.width * header.height);
+        return (bake.rects.empty() || file.read(reinterpret_cast<char*>(bake.rects.data()), bake.rects.size() * sizeof(unsigned short)))
+            && file.read(reinterpret_cast<char*>(bake.pixels.data()), bake.pixels.size());
+    }
+
+    void writeCache(const std::string& path, unsigned long long key, const BakedAtlas& bake) {
+        FileHeader header = FileHeader();
+        header.magic = FILE_MAGIC;
+        header.version = FILE_VERSION;
+        header.key = key;
+        header.width = bake.width;
+        header.height = bake.height;
+        header.fontCount = static_cast<unsigned int>(bake.fonts.size());
+        header.rectCount = static_cast<unsigned int>(bake.rects.size() / 2);
+        header.uvWhitePixel = bake.uvWhitePixel;
+        memcpy(header.uvLines, bake.uvLines, sizeof(header.uvLines));
+
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        bool written = static_cast<bool>(file.write(reinterpret_cast<const char*>(&header), sizeof(header)));
+        for (const BakedFont& font : bake.fonts) {
+            FontRecord record = { font.size, font.ascent, font.descent, static_cast<unsigned int>(font.glyphs.size()) };
+            written = written && file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            for (const ImFontGlyph& glyph : font.glyphs) {
+                GlyphRecord glyphRecord = { glyph.Codepoint, static_cast<unsigned int>(glyph.Visible | (glyph.Colored << 1)), glyph.AdvanceX,
+                    glyph.X0, glyph.Y0, glyph.X1, glyph.Y1, glyph.U0, glyph.V0, glyph.U1, glyph.V1 };
+                written = written && file.write(reinterpret_cast<const char*>(&glyphRecord), sizeof(glyphRecord));
+            }
+        }
+        if (!bake.rects.empty()) written = written && file.write(reinterpret_cast<const char*>(bake.rects.data()), bake.rects.size() * sizeof(unsigned short));
+        written = written && file.write(reinterpret_cast<const char*>(bake.pixels.data()), bake.pixels.size());
+        if (!written) {
+            std::cerr << "ERROR::FONT_ATLAS_CACHE::WRITE_FAILED: " << path << std::endl;
+            file.close();
+            std::remove(path.c_str());
+        }
+    }
+}
+
+void buildFontAtlas(ImFontAtlas& atlas, const std::string& cacheDirectory, FontAtlasStats& stats) {
+    auto start = std::chrono::high_resolution_clock::now();
+    memset(&stats, 0, sizeof(stats));
+    if (atlas.Sources.Size == 0) atlas.AddFontDefault();
+
+    if (atlas.CustomRects.Size > 0) {
+        atlas.Build();
+    }
+    else {
+        const unsigned long long key = atlasKey(atlas);
+        std::string path;
+        if (!cacheDirectory.empty()) {
+#ifdef _WIN32
+            _mkdir(cacheDirectory.c_str());
+#else
+            mkdir(cacheDirectory.c_str(), 0755);
+#endif
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.fontatlas", key);
+            path = cacheDirectory + "/" + name;
+        }
+
+        BakedAtlas bake;
+        stats.cached = !path.empty() && readCache(path, key, static_cast<unsigned int>(atlas.Fonts.Size), bake) && installBake(atlas, bake);
+        if (!stats.cached) {
+            bake = BakedAtlas();
+            stats.bakeJobs = bakeInParallel(atlas, bake);
+            if (stats.bakeJobs > 0 && installBake(atlas, bake)) {
+                if (!path.empty()) writeCache(path, key, bake);
+            }
+            else {
+                std::cerr << "ERROR::FONT_ATLAS_CACHE::BAKE_FAILED: building the atlas in one piece" << std::endl;
+                stats.bakeJobs = 0;
+                atlas.Build();
+            }
+        }
+    }
+
+    stats.width = atlas.TexWidth;
+    stats.height = atlas.TexHeight;
+    for (const ImFont* font : atlas.Fonts) stats.glyphs += font->Glyphs.Size;
+    stats.buildMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
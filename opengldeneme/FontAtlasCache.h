@@ -0,0 +1,28 @@
+#pragma once
+// FontAtlasCache.h
+// Builds the ImGui font atlas without rasterizing the fonts on every launch. The baked result
+// (alpha pixels, glyph tables and the positions of the cursor and line rectangles) is saved
+// under a key hashed from the font data, sizes, glyph ranges and build settings of every source,
+// and a later launch with the same fonts loads it straight into the atlas. On a miss the
+// requested codepoints of each font are split into chunks, each baked into a small atlas of its
+// own on the job system, and their glyphs are then packed together into one texture.
+#ifndef FONT_ATLAS_CACHE_H
+#define FONT_ATLAS_CACHE_H
+
+#include "imgui/imgui.h"
+#include <string>
+
+struct FontAtlasStats {
+    bool cached;            // loaded from the cache file
+    unsigned int bakeJobs;  // glyph range chunks baked in parallel on a miss
+    unsigned int glyphs;
+    int width, height;
+    float buildMs;          // hashing the sources, then loading or baking
+};
+
+// Call after the fonts are added and before the backend uploads the texture. An empty directory
+// bakes without the cache. Atlases with custom rectangles of their own are built by ImGui as
+// usual. Every font needs a space glyph, which each chunk bakes to keep its font non-empty.
+void buildFontAtlas(ImFontAtlas& atlas, const std::string& cacheDirectory, FontAtlasStats& stats);
+
+#endif
@@ -0,0 +1,73 @@
+// FramePacing.cpp
+#include "FramePacing.h"
+#include <GLFW/glfw3.h>
+#include <thread>
+
+namespace {
+    // FrameLimiter's sleeps are stopped this early and the rest is spun.
+    const int SPIN_MICROSECONDS = 2000;
+}
+
+FrameLimiter::FrameLimiter() : running(false) {}
+
+void FrameLimiter::wait(float targetFps) {
+    if (targetFps <= 0.0f) {
+        running = false;
+        return;
+    }
+    typedef std::chrono::steady_clock Clock;
+    Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+    Clock::time_point now = Clock::now();
+    // Starting, or a whole period behind: pace from now on rather than catching up
+    if (!running || now > nextFrame + period) nextFrame = now;
+    running = true;
+
+    Clock::time_point spinFrom = nextFrame - std::chrono::microseconds(SPIN_MICROSECONDS);
+    if (now < spinFrom) std::this_thread::sleep_for(spinFrom - now);
+    while (Clock::now() < nextFrame) std::this_thread::yield();
+    nextFrame += period;
+}
+
+PresentQueue::PresentQueue() : latency(0.0f) {}
+
+void PresentQueue::shutdown() {
+    for (const auto& frame : frames) glDeleteSync(frame.fence);
+    frames.clear();
+}
+
+void PresentQueue::afterSwap(QueueThrottle throttle, double inputTime) {
+    if (throttle == QUEUE_THROTTLE_FINISH) {
+        shutdown();
+        glFinish();
+        addSample(inputTime, glfwGetTime());
+        return;
+    }
+
+    Frame frame = { glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), inputTime };
+    frames.push_back(frame);
+    // Throttled, the previous frame must be done before this thread records the next one
+    size_t keep = throttle == QUEUE_THROTTLE_FENCE ? 1 : MAX_TRACKED_FRAMES;
+    while (frames.size() > keep) {
+        const Frame& oldest = frames.front();
+        if (throttle == QUEUE_THROTTLE_FENCE) {
+            glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            addSample(oldest.inputTime, glfwGetTime());
+        }
+        glDeleteSync(oldest.fence);
+        frames.pop_front();
+    }
+    // Frames that finished since the last swap; measured at most a frame late
+    while (!frames.empty()) {
+        const Frame& oldest = frames.front();
+        GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        addSample(oldest.inputTime, glfwGetTime());
+        glDeleteSync(oldest.fence);
+        frames.pop_front();
+    }
+}
+
+void PresentQueue::addSample(double inputTime, double doneTime) {
+    float sample = static_cast<float>((doneTime - inputTime) * 1000.0);
+    latency = latency > 0.0f ? latency + 0.1f * (sample - latency) : sample;
+}
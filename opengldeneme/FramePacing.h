@@ -0,0 +1,60 @@
+#pragma once
+// FramePacing.h
+// Low-latency frame pacing. FrameLimiter holds the main loop to a target rate: it sleeps through
+// most of the wait and spins the rest, because a sleep can overshoot by a scheduler tick.
+// PresentQueue runs on the render thread after every swap: it can stop the driver from queueing
+// frames ahead, and it notes when each frame's commands finished on the GPU, which together with
+// the time its input was sampled gives the input-to-present estimate.
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <deque>
+
+enum QueueThrottle {
+    QUEUE_THROTTLE_OFF,    // the driver queues as many frames as it likes
+    QUEUE_THROTTLE_FENCE,  // wait for the previous frame before going on: one frame in flight
+    QUEUE_THROTTLE_FINISH  // glFinish after every swap: none in flight
+};
+
+class FrameLimiter {
+public:
+    FrameLimiter();
+
+    // Returns once the next frame at targetFps is due; right away when targetFps is 0.
+    void wait(float targetFps);
+
+private:
+    std::chrono::steady_clock::time_point nextFrame;
+    bool running;
+};
+
+class PresentQueue {
+public:
+    // Frames tracked when not throttled; older ones are dropped unmeasured.
+    static const size_t MAX_TRACKED_FRAMES = 4;
+
+    PresentQueue();
+
+    void shutdown();
+
+    // Right after glfwSwapBuffers() for a frame whose input was sampled at inputTime (glfwGetTime()).
+    void afterSwap(QueueThrottle throttle, double inputTime);
+    // Smoothed time from input sampling to the GPU finishing the frame, in ms. With vsync the
+    // image still waits for the next refresh, so this is a lower bound there.
+    float latencyMs() const { return latency; }
+
+private:
+    struct Frame {
+        GLsync fence;
+        double inputTime;
+    };
+
+    void addSample(double inputTime, double doneTime);
+
+    std::deque<Frame> frames;
+    float latency;
+};
+
+#endif
@@ -0,0 +1,20 @@
+// FrameScheduler.cpp
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler()
+    : enabled(true), dirty(true), idle(false), quietFrames(0), drawn(0), skipped(0) {}
+
+void FrameScheduler::setEnabled(bool value) {
+    enabled = value;
+    dirty = true;
+}
+
+bool FrameScheduler::shouldDraw(bool sceneChanged, bool rendererBusy) {
+    if (!enabled || dirty || sceneChanged || rendererBusy) quietFrames = 0;
+    else if (quietFrames < SETTLE_FRAMES) quietFrames++;
+    dirty = false;
+    idle = quietFrames >= SETTLE_FRAMES;
+    if (idle) skipped++;
+    else drawn++;
+    return !idle;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// FrameScheduler.h
+// Decides per frame whether anything would look different from the frame on screen. While
+// nothing does (camera, robot, lights and settings unchanged, no input, the renderer done with
+// streaming and compiles), the main loop stops drawing and sleeps in glfwWaitEventsTimeout; the
+// window keeps showing the last presented frame. Input and animation wake it up again.
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+// Longest sleep while idle; events end it early.
+const double FRAME_IDLE_WAIT_SECONDS = 0.5;
+
+class FrameScheduler {
+public:
+    // Frames still drawn after the last change: ImGui needs one or two to settle hover and
+    // focus state, and the render thread's feedback arrives a frame or two late.
+    static const int SETTLE_FRAMES = 3;
+
+    FrameScheduler();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    // Something the frame snapshot doesn't show happened (input, window damage); the next
+    // frames are drawn. Called from GLFW callbacks on the main thread.
+    void markDirty() { dirty = true; }
+
+    // For the frame just built: sceneChanged is whether it differs from the last drawn one,
+    // rendererBusy whether the renderer still has work that changes the image by itself.
+    // Returns false when the frame can be skipped.
+    bool shouldDraw(bool sceneChanged, bool rendererBusy);
+    bool isIdle() const { return idle; }
+
+    unsigned long long drawnFrames() const { return drawn; }
+    unsigned long long skippedFrames() const { return skipped; }
+
+private:
+    bool enabled;
+    bool dirty;
+    bool idle;
+    int quietFrames;
+    unsigned long long drawn;
+    unsigned long long skipped;
+};
+
+#endif
@@ -0,0 +1,46 @@
+// Frustum.cpp
+#include "Frustum.h"
+
+Frustum::Frustum() {
+    for (int i = 0; i < 6; ++i) planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    extract(viewProjection);
+}
+
+// Gribb/Hartmann plane extraction. GLM is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+void Frustum::extract(const glm::mat4& m) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+    for (int i = 0; i < 6; ++i) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < 6; ++i) {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersectsBox(const glm::vec3& minCorner, const glm::vec3& maxCorner) const {
+    for (int i = 0; i < 6; ++i) {
+        // Test the corner furthest along the plane normal.
+        glm::vec3 positive(planes[i].x >= 0.0f ? maxCorner.x : minCorner.x,
+            planes[i].y >= 0.0f ? maxCorner.y : minCorner.y,
+            planes[i].z >= 0.0f ? maxCorner.z : minCorner.z);
+        if (glm::dot(glm::vec3(planes[i]), positive) + planes[i].w < 0.0f) return false;
+    }
+    return true;
+}
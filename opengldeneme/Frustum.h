@@ -0,0 +1,20 @@
+#pragma once
+// Frustum.h
+// View frustum planes extracted from a view-projection matrix, for culling.
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+class Frustum {
+public:
+    glm::vec4 planes[6]; // left, right, bottom, top, near, far; normals point inwards
+
+    Frustum();
+    explicit Frustum(const glm::mat4& viewProjection);
+    void extract(const glm::mat4& viewProjection);
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+    bool intersectsBox(const glm::vec3& minCorner, const glm::vec3& maxCorner) const;
+};
+
+#endif
@@ -0,0 +1,64 @@
+// GLExtensions.cpp
+#include "GLExtensions.h"
+#include <set>
+#include <string>
+
+bool GLExtensions::s3tc = false;
+bool GLExtensions::bptc = false;
+bool GLExtensions::anisotropic = false;
+bool GLExtensions::programBinary = false;
+bool GLExtensions::parallelShaderCompile = false;
+
+GLGetProgramBinaryProc GLExtensions::getProgramBinary = nullptr;
+GLProgramBinaryProc GLExtensions::loadProgramBinary = nullptr;
+GLProgramParameteriProc GLExtensions::programParameteri = nullptr;
+GLMaxShaderCompilerThreadsProc GLExtensions::maxShaderCompilerThreads = nullptr;
+
+static std::set<std::string>& extensionSet() {
+    static std::set<std::string> extensions;
+    return extensions;
+}
+
+void GLExtensions::init(GLADloadproc load) {
+    std::set<std::string>& extensions = extensionSet();
+    extensions.clear();
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name) extensions.insert(name);
+    }
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    int version = major * 10 + minor;
+
+    s3tc = has("GL_EXT_texture_compression_s3tc");
+    bptc = version >= 42 || has("GL_ARB_texture_compression_bptc");
+    anisotropic = version >= 46 || has("GL_EXT_texture_filter_anisotropic") || has("GL_ARB_texture_filter_anisotropic");
+
+    programBinary = false;
+    if (version >= 41 || has("GL_ARB_get_program_binary")) {
+        getProgramBinary = reinterpret_cast<GLGetProgramBinaryProc>(load("glGetProgramBinary"));
+        loadProgramBinary = reinterpret_cast<GLProgramBinaryProc>(load("glProgramBinary"));
+        programParameteri = reinterpret_cast<GLProgramParameteriProc>(load("glProgramParameteri"));
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        programBinary = getProgramBinary && loadProgramBinary && programParameteri && formats > 0;
+    }
+
+    // The KHR and ARB versions share their enums, only the entry point name differs.
+    maxShaderCompilerThreads = nullptr;
+    if (has("GL_KHR_parallel_shader_compile")) {
+        maxShaderCompilerThreads = reinterpret_cast<GLMaxShaderCompilerThreadsProc>(load("glMaxShaderCompilerThreadsKHR"));
+    }
+    else if (has("GL_ARB_parallel_shader_compile")) {
+        maxShaderCompilerThreads = reinterpret_cast<GLMaxShaderCompilerThreadsProc>(load("glMaxShaderCompilerThreadsARB"));
+    }
+    parallelShaderCompile = maxShaderCompilerThreads != nullptr;
+}
+
+bool GLExtensions::has(const char* name) {
+    return extensionSet().count(name) != 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+// GLExtensions.h
+// Runtime queries for OpenGL extensions beyond the GL 3.3 core profile glad was generated for.
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// Enums from extensions that the generated glad header doesn't carry.
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Entry points from extensions, loaded by init() when the extension is present.
+typedef void (APIENTRYP GLGetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP GLProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP GLProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP GLMaxShaderCompilerThreadsProc)(GLuint count);
+
+class GLExtensions {
+public:
+    // Reads the extension list of the current context and loads extension entry points through
+    // the same loader glad used. Call once after gladLoadGLLoader().
+    static void init(GLADloadproc load);
+    static bool has(const char* name);
+
+    static bool s3tc;         // BC1/BC3
+    static bool bptc;         // BC7
+    static bool anisotropic;
+    static bool programBinary; // GL_ARB_get_program_binary with at least one binary format
+    static bool parallelShaderCompile; // GL_KHR/ARB_parallel_shader_compile, GL_COMPLETION_STATUS_KHR can be polled
+
+    static GLGetProgramBinaryProc getProgramBinary;
+    static GLProgramBinaryProc loadProgramBinary;
+    static GLProgramParameteriProc programParameteri;
+    static GLMaxShaderCompilerThreadsProc maxShaderCompilerThreads;
+};
+
+#endif
@@ -0,0 +1,438 @@
+// GLState.cpp
+#include "GLState.h"
+#include <cstring>
+#include <iostream>
+
+unsigned int GLStateCounters::totalIssued() const {
+    unsigned int total = 0;
+    for (int i = 0; i < GLSTATE_CALL_COUNT; ++i) total += issued[i];
+    return total;
+}
+
+unsigned int GLStateCounters::totalElided() const {
+    unsigned int total = 0;
+    for (int i = 0; i < GLSTATE_CALL_COUNT; ++i) total += elided[i];
+    return total;
+}
+
+GLState& GLState::get() {
+    static GLState instance;
+    return instance;
+}
+
+GLState::GLState() : fullscreenVertexArray(0) {
+#ifdef _DEBUG
+    validation = true;
+#else
+    validation = false;
+#endif
+    memset(&current, 0, sizeof(current));
+    memset(&lastFrame, 0, sizeof(lastFrame));
+    invalidate();
+}
+
+void GLState::invalidate() {
+    program.known = false;
+    vertexArray.known = false;
+    for (int i = 0; i < BUFFER_TARGET_COUNT; ++i) buffers[i].known = false;
+    activeUnit.known = false;
+    for (int u = 0; u < MAX_TEXTURE_UNITS; ++u) {
+        for (int t = 0; t < TEXTURE_TARGET_COUNT; ++t) textures[u][t].known = false;
+        samplers[u].known = false;
+    }
+    drawFramebuffer.known = false;
+    readFramebuffer.known = false;
+    for (int i = 0; i < CAP_COUNT; ++i) caps[i].known = false;
+    for (int i = 0; i < 4; ++i) {
+        blendFuncs[i].known = false;
+        viewportRect[i].known = false;
+    }
+    blendEq.known = false;
+    depthFn.known = false;
+    depthWrite.known = false;
+    colorWriteMask.known = false;
+    cullMode.known = false;
+    frontMode.known = false;
+}
+
+void GLState::beginFrame() {
+    memset(&current, 0, sizeof(current));
+}
+
+void GLState::endFrame() {
+    if (validation) validate();
+    lastFrame = current;
+}
+
+// Counts the call and returns true when it can be skipped.
+bool GLState::elide(GLStateCall kind, bool redundant) {
+    if (redundant) current.elided[kind]++;
+    else current.issued[kind]++;
+    return redundant;
+}
+
+void GLState::checkShadow(const char* what, GLint expected, GLenum query) {
+    if (!validation) return;
+    GLint actual = 0;
+    glGetIntegerv(query, &actual);
+    if (actual != expected) {
+        std::cerr << "ERROR::GLSTATE::SHADOW_MISMATCH " << what << ": shadow " << expected << ", driver " << actual << std::endl;
+    }
+}
+
+bool GLState::checkCapability(int index) {
+    static const GLenum capEnums[CAP_COUNT] = {
+        GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST,
+        GL_POLYGON_OFFSET_FILL, GL_FRAMEBUFFER_SRGB, GL_PRIMITIVE_RESTART
+    };
+    if (!caps[index].known) return true;
+    bool actual = glIsEnabled(capEnums[index]) == GL_TRUE;
+    if (actual != caps[index].value) {
+        std::cerr << "ERROR::GLSTATE::SHADOW_MISMATCH capability 0x" << std::hex << capEnums[index] << std::dec
+            << ": shadow " << caps[index].value << ", driver " << actual << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GLState::validate() {
+    bool ok = true;
+    GLint value = 0;
+    GLint rect[4];
+#define GLSTATE_CHECK(slot, query, label) \
+    if ((slot).known) { glGetIntegerv(query, &value); if ((GLint)(slot).value != value) { ok = false; \
+        std::cerr << "ERROR::GLSTATE::SHADOW_MISMATCH " << label << ": shadow " << (GLint)(slot).value << ", driver " << value << std::endl; } }
+
+    GLSTATE_CHECK(program, GL_CURRENT_PROGRAM, "program");
+    GLSTATE_CHECK(vertexArray, GL_VERTEX_ARRAY_BINDING, "vertex array");
+    GLSTATE_CHECK(buffers[BUFFER_ARRAY], GL_ARRAY_BUFFER_BINDING, "array buffer");
+    GLSTATE_CHECK(buffers[BUFFER_ELEMENT_ARRAY], GL_ELEMENT_ARRAY_BUFFER_BINDING, "element buffer");
+    GLSTATE_CHECK(buffers[BUFFER_UNIFORM], GL_UNIFORM_BUFFER_BINDING, "uniform buffer");
+    GLSTATE_CHECK(buffers[BUFFER_PIXEL_PACK], GL_PIXEL_PACK_BUFFER_BINDING, "pixel pack buffer");
+    GLSTATE_CHECK(buffers[BUFFER_PIXEL_UNPACK], GL_PIXEL_UNPACK_BUFFER_BINDING, "pixel unpack buffer");
+    GLSTATE_CHECK(drawFramebuffer, GL_DRAW_FRAMEBUFFER_BINDING, "draw framebuffer");
+    GLSTATE_CHECK(readFramebuffer, GL_READ_FRAMEBUFFER_BINDING, "read framebuffer");
+    GLSTATE_CHECK(blendFuncs[0], GL_BLEND_SRC_RGB, "blend src rgb");
+    GLSTATE_CHECK(blendFuncs[1], GL_BLEND_DST_RGB, "blend dst rgb");
+    GLSTATE_CHECK(blendFuncs[2], GL_BLEND_SRC_ALPHA, "blend src alpha");
+    GLSTATE_CHECK(blendFuncs[3], GL_BLEND_DST_ALPHA, "blend dst alpha");
+    GLSTATE_CHECK(blendEq, GL_BLEND_EQUATION_RGB, "blend equation");
+    GLSTATE_CHECK(depthFn, GL_DEPTH_FUNC, "depth func");
+    GLSTATE_CHECK(depthWrite, GL_DEPTH_WRITEMASK, "depth mask");
+    GLSTATE_CHECK(cullMode, GL_CULL_FACE_MODE, "cull face");
+    GLSTATE_CHECK(frontMode, GL_FRONT_FACE, "front face");
+
+    if (activeUnit.known) {
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+        if ((GLint)(GL_TEXTURE0 + activeUnit.value) != value) {
+            ok = false;
+            std::cerr << "ERROR::GLSTATE::SHADOW_MISMATCH active texture: shadow " << activeUnit.value << ", driver " << value - GL_TEXTURE0 << std::endl;
+        }
+    }
+
+    // Texture and sampler bindings are per unit, so walk the units and put the active one back.
+    static const GLenum textureQueries[TEXTURE_TARGET_COUNT] = {
+        GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_3D, GL_TEXTURE_BINDING_2D_ARRAY,
+        GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_BUFFER
+    };
+    GLint savedUnit = 0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &savedUnit);
+    for (int u = 0; u < MAX_TEXTURE_UNITS; ++u) {
+        bool any = samplers[u].known;
+        for (int t = 0; t < TEXTURE_TARGET_COUNT; ++t) any = any || textures[u][t].known;
+        if (!any) continue;
+        glActiveTexture(GL_TEXTURE0 + u);
+        for (int t = 0; t < TEXTURE_TARGET_COUNT; ++t) {
+            GLSTATE_CHECK(textures[u][t], textureQueries[t], "texture unit " << u << " target " << t);
+        }
+        GLSTATE_CHECK(samplers[u], GL_SAMPLER_BINDING, "sampler unit " << u);
+    }
+    glActiveTexture((GLenum)savedUnit);
+
+    if (colorWriteMask.known) {
+        GLboolean mask[4];
+        glGetBooleanv(GL_COLOR_WRITEMASK, mask);
+        unsigned int bits = (mask[0] ? 1u : 0u) | (mask[1] ? 2u : 0u) | (mask[2] ? 4u : 0u) | (mask[3] ? 8u : 0u);
+        if (bits != colorWriteMask.value) {
+            ok = false;
+            std::cerr << "ERROR::GLSTATE::SHADOW_MISMATCH color mask: shadow " << colorWriteMask.value << ", driver " << bits << std::endl;
+        }
+    }
+    if (viewportRect[0].known) {
+        glGetIntegerv(GL_VIEWPORT, rect);
+        for (int i = 0; i < 4; ++i) {
+            if (viewportRect[i].known && viewportRect[i].value != rect[i]) {
+                ok = false;
+                std::cerr << "ERROR::GLSTATE::SHADOW_MISMATCH viewport[" << i << "]: shadow " << viewportRect[i].value << ", driver " << rect[i] << std::endl;
+            }
+        }
+    }
+    for (int i = 0; i < CAP_COUNT; ++i) {
+        if (!checkCapability(i)) ok = false;
+    }
+#undef GLSTATE_CHECK
+    return ok;
+}
+
+int GLState::bufferIndex(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+    case GL_ELEMENT_ARRAY_BUFFER: return BUFFER_ELEMENT_ARRAY;
+    case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+    case GL_TEXTURE_BUFFER: return BUFFER_TEXTURE;
+    case GL_PIXEL_PACK_BUFFER: return BUFFER_PIXEL_PACK;
+    case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+    case GL_COPY_READ_BUFFER: return BUFFER_COPY_READ;
+    case GL_COPY_WRITE_BUFFER: return BUFFER_COPY_WRITE;
+    default: return -1;
+    }
+}
+
+int GLState::textureIndex(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_2D: return TEXTURE_2D;
+    case GL_TEXTURE_3D: return TEXTURE_3D;
+    case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+    case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+    case GL_TEXTURE_BUFFER: return TEXTURE_BUFFER;
+    default: return -1;
+    }
+}
+
+int GLState::capabilityIndex(GLenum cap) {
+    switch (cap) {
+    case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+    case GL_BLEND: return CAP_BLEND;
+    case GL_CULL_FACE: return CAP_CULL_FACE;
+    case GL_SCISSOR_TEST: return CAP_SCISSOR_TEST;
+    case GL_STENCIL_TEST: return CAP_STENCIL_TEST;
+    case GL_POLYGON_OFFSET_FILL: return CAP_POLYGON_OFFSET_FILL;
+    case GL_FRAMEBUFFER_SRGB: return CAP_FRAMEBUFFER_SRGB;
+    case GL_PRIMITIVE_RESTART: return CAP_PRIMITIVE_RESTART;
+    default: return -1;
+    }
+}
+
+void GLState::useProgram(GLuint id) {
+    if (elide(GLSTATE_PROGRAM, program.matches(id))) {
+        checkShadow("program", (GLint)id, GL_CURRENT_PROGRAM);
+        return;
+    }
+    glUseProgram(id);
+    program.set(id);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (elide(GLSTATE_VERTEX_ARRAY, vertexArray.matches(vao))) {
+        checkShadow("vertex array", (GLint)vao, GL_VERTEX_ARRAY_BINDING);
+        return;
+    }
+    glBindVertexArray(vao);
+    vertexArray.set(vao);
+    // The element buffer binding lives in the VAO, we don't know what the new one holds.
+    buffers[BUFFER_ELEMENT_ARRAY].known = false;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    int index = bufferIndex(target);
+    if (index < 0) {
+        elide(GLSTATE_BUFFER, false);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (elide(GLSTATE_BUFFER, buffers[index].matches(buffer))) {
+        if (target == GL_ARRAY_BUFFER) checkShadow("array buffer", (GLint)buffer, GL_ARRAY_BUFFER_BINDING);
+        else if (target == GL_ELEMENT_ARRAY_BUFFER) checkShadow("element buffer", (GLint)buffer, GL_ELEMENT_ARRAY_BUFFER_BINDING);
+        return;
+    }
+    glBindBuffer(target, buffer);
+    buffers[index].set(buffer);
+}
+
+void GLState::activeTexture(unsigned int unit) {
+    if (elide(GLSTATE_ACTIVE_TEXTURE, activeUnit.matches(unit))) {
+        checkShadow("active texture", (GLint)(GL_TEXTURE0 + unit), GL_ACTIVE_TEXTURE);
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit.set(unit);
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, GLuint texture) {
+    int index = textureIndex(target);
+    if (index < 0 || unit >= (unsigned int)MAX_TEXTURE_UNITS) {
+        activeTexture(unit);
+        elide(GLSTATE_TEXTURE, false);
+        glBindTexture(target, texture);
+        return;
+    }
+    // Callers upload to or set parameters on the texture right after binding it, so the unit
+    // has to be active even when the bind itself is redundant.
+    activeTexture(unit);
+    if (elide(GLSTATE_TEXTURE, textures[unit][index].matches(texture))) return;
+    glBindTexture(target, texture);
+    textures[unit][index].set(texture);
+}
+
+void GLState::bindSampler(unsigned int unit, GLuint sampler) {
+    if (unit < (unsigned int)MAX_TEXTURE_UNITS && elide(GLSTATE_SAMPLER, samplers[unit].matches(sampler))) return;
+    if (unit >= (unsigned int)MAX_TEXTURE_UNITS) elide(GLSTATE_SAMPLER, false);
+    glBindSampler(unit, sampler);
+    if (unit < (unsigned int)MAX_TEXTURE_UNITS) samplers[unit].set(sampler);
+}
+
+void GLState::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    bool drawSame = drawFramebuffer.matches(framebuffer);
+    bool readSame = readFramebuffer.matches(framebuffer);
+    bool redundant = (target == GL_DRAW_FRAMEBUFFER) ? drawSame
+        : (target == GL_READ_FRAMEBUFFER) ? readSame
+        : (drawSame && readSame);
+    if (elide(GLSTATE_FRAMEBUFFER, redundant)) {
+        if (target != GL_READ_FRAMEBUFFER) checkShadow("draw framebuffer", (GLint)framebuffer, GL_DRAW_FRAMEBUFFER_BINDING);
+        return;
+    }
+    glBindFramebuffer(target, framebuffer);
+    if (target != GL_READ_FRAMEBUFFER) drawFramebuffer.set(framebuffer);
+    if (target != GL_DRAW_FRAMEBUFFER) readFramebuffer.set(framebuffer);
+}
+
+void GLState::setCapability(GLenum cap, bool enabled) {
+    int index = capabilityIndex(cap);
+    if (index >= 0 && elide(GLSTATE_CAPABILITY, caps[index].matches(enabled))) {
+        if (validation) checkCapability(index);
+        return;
+    }
+    if (index < 0) elide(GLSTATE_CAPABILITY, false);
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+    if (index >= 0) caps[index].set(enabled);
+}
+
+void GLState::blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+    bool redundant = blendFuncs[0].matches(srcRGB) && blendFuncs[1].matches(dstRGB)
+        && blendFuncs[2].matches(srcAlpha) && blendFuncs[3].matches(dstAlpha);
+    if (elide(GLSTATE_BLEND, redundant)) {
+        checkShadow("blend src rgb", (GLint)srcRGB, GL_BLEND_SRC_RGB);
+        checkShadow("blend dst rgb", (GLint)dstRGB, GL_BLEND_DST_RGB);
+        return;
+    }
+    glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    blendFuncs[0].set(srcRGB);
+    blendFuncs[1].set(dstRGB);
+    blendFuncs[2].set(srcAlpha);
+    blendFuncs[3].set(dstAlpha);
+}
+
+void GLState::blendEquation(GLenum mode) {
+    if (elide(GLSTATE_BLEND, blendEq.matches(mode))) {
+        checkShadow("blend equation", (GLint)mode, GL_BLEND_EQUATION_RGB);
+        return;
+    }
+    glBlendEquation(mode);
+    blendEq.set(mode);
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (elide(GLSTATE_DEPTH, depthFn.matches(func))) {
+        checkShadow("depth func", (GLint)func, GL_DEPTH_FUNC);
+        return;
+    }
+    glDepthFunc(func);
+    depthFn.set(func);
+}
+
+void GLState::depthMask(bool write) {
+    if (elide(GLSTATE_DEPTH, depthWrite.matches(write))) {
+        checkShadow("depth mask", write ? GL_TRUE : GL_FALSE, GL_DEPTH_WRITEMASK);
+        return;
+    }
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+    depthWrite.set(write);
+}
+
+void GLState::colorMask(bool r, bool g, bool b, bool a) {
+    unsigned int bits = (r ? 1u : 0u) | (g ? 2u : 0u) | (b ? 4u : 0u) | (a ? 8u : 0u);
+    if (elide(GLSTATE_BLEND, colorWriteMask.matches(bits))) return;
+    glColorMask(r, g, b, a);
+    colorWriteMask.set(bits);
+}
+
+void GLState::cullFace(GLenum mode) {
+    if (elide(GLSTATE_CULL, cullMode.matches(mode))) {
+        checkShadow("cull face", (GLint)mode, GL_CULL_FACE_MODE);
+        return;
+    }
+    glCullFace(mode);
+    cullMode.set(mode);
+}
+
+void GLState::frontFace(GLenum mode) {
+    if (elide(GLSTATE_CULL, frontMode.matches(mode))) {
+        checkShadow("front face", (GLint)mode, GL_FRONT_FACE);
+        return;
+    }
+    glFrontFace(mode);
+    frontMode.set(mode);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    bool redundant = viewportRect[0].matches(x) && viewportRect[1].matches(y)
+        && viewportRect[2].matches(width) && viewportRect[3].matches(height);
+    if (elide(GLSTATE_VIEWPORT, redundant)) return;
+    glViewport(x, y, width, height);
+    viewportRect[0].set(x);
+    viewportRect[1].set(y);
+    viewportRect[2].set(width);
+    viewportRect[3].set(height);
+}
+
+void GLState::deleteProgram(GLuint id) {
+    if (id == 0) return;
+    glDeleteProgram(id);
+    // A bound program stays current until something else is bound, so only forget it.
+    if (program.matches(id)) program.known = false;
+}
+
+void GLState::deleteVertexArray(GLuint vao) {
+    if (vao == 0) return;
+    glDeleteVertexArrays(1, &vao);
+    if (vertexArray.matches(vao)) {
+        vertexArray.set(0);
+        buffers[BUFFER_ELEMENT_ARRAY].known = false;
+    }
+}
+
+void GLState::deleteBuffer(GLuint buffer) {
+    if (buffer == 0) return;
+    glDeleteBuffers(1, &buffer);
+    for (int i = 0; i < BUFFER_TARGET_COUNT; ++i) {
+        if (buffers[i].matches(buffer)) buffers[i].set(0);
+    }
+}
+
+void GLState::deleteTexture(GLuint texture) {
+    if (texture == 0) return;
+    glDeleteTextures(1, &texture);
+    for (int u = 0; u < MAX_TEXTURE_UNITS; ++u) {
+        for (int t = 0; t < TEXTURE_TARGET_COUNT; ++t) {
+            if (textures[u][t].matches(texture)) textures[u][t].set(0);
+        }
+    }
+}
+
+void GLState::deleteFramebuffer(GLuint framebuffer) {
+    if (framebuffer == 0) return;
+    glDeleteFramebuffers(1, &framebuffer);
+    if (drawFramebuffer.matches(framebuffer)) drawFramebuffer.set(0);
+    if (readFramebuffer.matches(framebuffer)) readFramebuffer.set(0);
+}
+
+void GLState::bindFullscreenVertexArray() {
+    if (!fullscreenVertexArray) glGenVertexArrays(1, &fullscreenVertexArray);
+    bindVertexArray(fullscreenVertexArray);
+}
+
+void GLState::shutdown() {
+    deleteVertexArray(fullscreenVertexArray);
+    fullscreenVertexArray = 0;
+}
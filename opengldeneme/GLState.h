@@ -0,0 +1,151 @@
+#pragma once
+// GLState.h
+// Shadow copy of the OpenGL binding and fixed-function state.
+// Every call goes through here so redundant binds/enables are skipped instead of reaching the driver.
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Kinds of state calls, used to break the per-frame counters down.
+enum GLStateCall {
+    GLSTATE_PROGRAM,
+    GLSTATE_VERTEX_ARRAY,
+    GLSTATE_BUFFER,
+    GLSTATE_ACTIVE_TEXTURE,
+    GLSTATE_TEXTURE,
+    GLSTATE_SAMPLER,
+    GLSTATE_FRAMEBUFFER,
+    GLSTATE_CAPABILITY,
+    GLSTATE_BLEND,
+    GLSTATE_DEPTH,
+    GLSTATE_CULL,
+    GLSTATE_VIEWPORT,
+    GLSTATE_CALL_COUNT
+};
+
+struct GLStateCounters {
+    unsigned int issued[GLSTATE_CALL_COUNT];
+    unsigned int elided[GLSTATE_CALL_COUNT];
+
+    unsigned int totalIssued() const;
+    unsigned int totalElided() const;
+};
+
+class GLState {
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    static GLState& get();
+
+    // Forget everything we know; the next call of each kind reaches the driver.
+    // Call after code that touches GL behind our back (e.g. the ImGui backend).
+    void invalidate();
+
+    // Per-frame bookkeeping. endFrame() runs a full validation sweep in debug mode.
+    void beginFrame();
+    void endFrame();
+    const GLStateCounters& frameCounters() const { return lastFrame; }
+
+    // Debug mode: every elided call and every endFrame() compares the shadow with glGet*.
+    void setValidation(bool enabled) { validation = enabled; }
+    bool validationEnabled() const { return validation; }
+    bool validate();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void activeTexture(unsigned int unit);
+    // Leaves `unit` active whether or not the bind is elided, so the texture can be edited next.
+    void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+    void bindSampler(unsigned int unit, GLuint sampler);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+    void enable(GLenum cap) { setCapability(cap, true); }
+    void disable(GLenum cap) { setCapability(cap, false); }
+    void setCapability(GLenum cap, bool enabled);
+
+    void blendFunc(GLenum src, GLenum dst) { blendFuncSeparate(src, dst, src, dst); }
+    void blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+    void blendEquation(GLenum mode);
+    void depthFunc(GLenum func);
+    void depthMask(bool write);
+    void colorMask(bool r, bool g, bool b, bool a);
+    void cullFace(GLenum mode);
+    void frontFace(GLenum mode);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deleting an object implicitly unbinds it, so the shadow has to follow.
+    void deleteProgram(GLuint program);
+    void deleteVertexArray(GLuint vao);
+    void deleteBuffer(GLuint buffer);
+    void deleteTexture(GLuint texture);
+    void deleteFramebuffer(GLuint framebuffer);
+
+    // Fullscreen passes draw one triangle from gl_VertexID, but the core profile still wants a
+    // vertex array bound; they all share this empty one, created on first use.
+    void bindFullscreenVertexArray();
+    // Releases the objects GLState owns itself, while the context is still current.
+    void shutdown();
+
+    GLuint currentProgram() const { return program.known ? program.value : 0; }
+
+private:
+    template <typename T>
+    struct Slot {
+        T value;
+        bool known;
+        bool matches(const T& v) const { return known && value == v; }
+        void set(const T& v) { value = v; known = true; }
+    };
+
+    enum {
+        BUFFER_ARRAY, BUFFER_ELEMENT_ARRAY, BUFFER_UNIFORM, BUFFER_TEXTURE,
+        BUFFER_PIXEL_PACK, BUFFER_PIXEL_UNPACK, BUFFER_COPY_READ, BUFFER_COPY_WRITE,
+        BUFFER_TARGET_COUNT
+    };
+    enum {
+        TEXTURE_2D, TEXTURE_3D, TEXTURE_2D_ARRAY, TEXTURE_CUBE_MAP, TEXTURE_BUFFER,
+        TEXTURE_TARGET_COUNT
+    };
+    enum {
+        CAP_DEPTH_TEST, CAP_BLEND, CAP_CULL_FACE, CAP_SCISSOR_TEST, CAP_STENCIL_TEST,
+        CAP_POLYGON_OFFSET_FILL, CAP_FRAMEBUFFER_SRGB, CAP_PRIMITIVE_RESTART,
+        CAP_COUNT
+    };
+
+    GLState();
+    bool elide(GLStateCall kind, bool redundant);
+    void checkShadow(const char* what, GLint expected, GLenum query);
+    bool checkCapability(int index);
+
+    static int bufferIndex(GLenum target);
+    static int textureIndex(GLenum target);
+    static int capabilityIndex(GLenum cap);
+
+    Slot<GLuint> program;
+    Slot<GLuint> vertexArray;
+    Slot<GLuint> buffers[BUFFER_TARGET_COUNT];
+    Slot<unsigned int> activeUnit;
+    Slot<GLuint> textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+    Slot<GLuint> samplers[MAX_TEXTURE_UNITS];
+    Slot<GLuint> drawFramebuffer;
+    Slot<GLuint> readFramebuffer;
+    Slot<bool> caps[CAP_COUNT];
+    Slot<GLenum> blendFuncs[4];
+    Slot<GLenum> blendEq;
+    Slot<GLenum> depthFn;
+    Slot<bool> depthWrite;
+    Slot<unsigned int> colorWriteMask;
+    Slot<GLenum> cullMode;
+    Slot<GLenum> frontMode;
+    Slot<GLint> viewportRect[4];
+
+    GLuint fullscreenVertexArray;
+
+    bool validation;
+    GLStateCounters current;
+    GLStateCounters lastFrame;
+};
+
+#endif
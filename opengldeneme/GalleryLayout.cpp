@@ -0,0 +1,62 @@
+// GalleryLayout.cpp
+#include "GalleryLayout.h"
+#include <algorithm>
+#include <cmath>
+
+GalleryLayout buildGalleryLayout(int stressExhibits) {
+    GalleryLayout layout;
+    layout.exhibits.push_back({ "Statue of Hercules", "A famous Roman copy of a Greek original.", glm::vec3(-4.0f, 0.5f, -4.0f), glm::vec3(1.0f), glm::vec3(0.7f, 0.7f, 0.7f), "textures/hercules.dds", "sculpture marble roman greek mythology" });
+    layout.exhibits.push_back({ "Ancient Vase", "A well-preserved vase from 500 BC.", glm::vec3(4.0f, 0.5f, -4.0f), glm::vec3(0.5f, 1.0f, 0.5f), glm::vec3(0.8f, 0.5f, 0.2f), "textures/vase.dds", "ceramics pottery greek" });
+    layout.exhibits.push_back({ "Sarcophagus Lid", "Detailed carvings depict scenes of mythology.", glm::vec3(-4.0f, 0.25f, 4.0f), glm::vec3(2.0f, 0.5f, 1.0f), glm::vec3(0.6f, 0.6f, 0.5f), "textures/sarcophagus.dds", "relief stone funerary mythology" });
+    layout.exhibits.push_back({ "Mosaic Panel", "A colorful mosaic showing daily life.", glm::vec3(4.0f, 1.0f, 4.0f), glm::vec3(1.5f, 1.5f, 0.2f), glm::vec3(0.5f, 0.7f, 0.8f), "textures/mosaic.dds", "mosaic roman floor" });
+    layout.exhibits.push_back({ "Gold Coin Hoard", "A collection of rare gold coins.", glm::vec3(0.0f, 0.25f, -6.0f), glm::vec3(0.5f), glm::vec3(0.9f, 0.8f, 0.2f), "textures/coins.dds", "coins gold numismatics treasure" });
+
+    layout.floorCenter = glm::vec3(0.0f, -0.5f, 0.0f);
+    layout.floorSize = glm::vec3(20.0f, 0.1f, 20.0f);
+    layout.floorColor = glm::vec3(0.5f, 0.5f, 0.5f);
+    layout.mainLightPos = glm::vec3(0.0f, 10.0f, 0.0f);
+    layout.mainLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
+
+    if (stressExhibits > 0) {
+        // Fills a hall behind the main room with plain exhibits, each with its own track light.
+        const float spacing = 2.5f;
+        int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(stressExhibits))));
+        for (int i = 0; i < stressExhibits; ++i) {
+            int row = i / columns;
+            int column = i % columns;
+            glm::vec3 position((column - (columns - 1) * 0.5f) * spacing, 0.5f, -10.0f - row * spacing);
+            glm::vec3 color(0.4f + 0.5f * ((i * 7) % 10) / 9.0f, 0.4f + 0.5f * ((i * 3) % 10) / 9.0f, 0.4f + 0.5f * ((i * 5) % 10) / 9.0f);
+            layout.exhibits.push_back({ "Exhibit " + std::to_string(i + 1), "Part of the stress test hall.", position, glm::vec3(0.8f), color, "", "stress" });
+        }
+        int rows = (stressExhibits + columns - 1) / columns;
+        float hallWidth = std::max(20.0f, columns * spacing + 4.0f);
+        float hallBack = -10.0f - rows * spacing;
+        layout.floorSize = glm::vec3(hallWidth, 0.1f, 10.0f - hallBack);
+        layout.floorCenter = glm::vec3(0.0f, -0.5f, (10.0f + hallBack) * 0.5f);
+    }
+    return layout;
+}
+
+GalleryLight trackLightFor(const glm::vec3& exhibitPosition) {
+    GalleryLight light;
+    light.position = exhibitPosition + glm::vec3(0.0f, 3.0f, 1.5f);
+    light.direction = glm::normalize(exhibitPosition - light.position);
+    light.color = glm::vec3(1.0f, 0.85f, 0.6f); // Warm gallery spot
+    light.range = 6.0f;
+    light.cosInnerCutOff = std::cos(glm::radians(15.0f));
+    light.cosOuterCutOff = std::cos(glm::radians(TRACK_LIGHT_OUTER_DEGREES));
+    light.shadowIndex = -1;
+    return light;
+}
+
+GalleryLight mainLightFor(const glm::vec3& position, const glm::vec3& color) {
+    GalleryLight light;
+    light.position = position;
+    light.color = color;
+    light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    light.range = 1e4f;
+    light.cosInnerCutOff = -1.0f;
+    light.cosOuterCutOff = -1.0f;
+    light.shadowIndex = -1;
+    return light;
+}
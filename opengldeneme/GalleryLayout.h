@@ -0,0 +1,55 @@
+#pragma once
+// GalleryLayout.h
+// The static hall: exhibit placement, floor, track lights and the main light.
+// Shared by the viewer and the offline bake tool, so it has no OpenGL dependency.
+#ifndef GALLERY_LAYOUT_H
+#define GALLERY_LAYOUT_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+struct GalleryLight {
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec3 direction;   // spot direction, ignored for point lights
+    float range;           // light has no effect past this distance
+    float cosInnerCutOff;  // spot cone; use cosOuterCutOff = -1 for a point light
+    float cosOuterCutOff;
+    int shadowIndex;       // ShadowMaps data index, -1 for no shadow
+};
+
+struct ExhibitLayout {
+    std::string name;
+    std::string description;
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec3 color;
+    std::string texturePath; // scanned artwork (BC-compressed DDS), empty for plain color
+    std::string tags;        // space separated, searched by the catalog
+};
+
+struct GalleryLayout {
+    std::vector<ExhibitLayout> exhibits;
+    glm::vec3 floorCenter;
+    glm::vec3 floorSize;
+    glm::vec3 floorColor;
+    glm::vec3 mainLightPos;
+    glm::vec3 mainLightColor;
+};
+
+// The five main exhibits, plus stressExhibits plain ones in a hall behind the main room.
+GalleryLayout buildGalleryLayout(int stressExhibits);
+
+// The track spotlight hanging above and in front of an exhibit.
+GalleryLight trackLightFor(const glm::vec3& exhibitPosition);
+const float TRACK_LIGHT_OUTER_DEGREES = 22.0f;
+
+// The main light as a gallery light: a point light without range falloff.
+GalleryLight mainLightFor(const glm::vec3& position, const glm::vec3& color);
+
+// Radiance of light arriving from outside the hall when baking; stands in for the walls and
+// ceiling the scene doesn't model yet.
+const glm::vec3 HALL_ENVIRONMENT_RADIANCE(0.12f);
+
+#endif
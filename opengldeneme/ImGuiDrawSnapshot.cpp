@@ -0,0 +1,93 @@
+// ImGuiDrawSnapshot.cpp
+#include "ImGuiDrawSnapshot.h"
+#include <cstring>
+
+namespace {
+    // Resizes without ImVector's operator=, which frees the old buffer first.
+    template <typename T>
+    void copyVector(ImVector<T>& destination, const ImVector<T>& source) {
+        destination.resize(source.Size);
+        if (source.Size > 0) memcpy(destination.Data, source.Data, source.size_in_bytes());
+    }
+
+    // FNV-1a a word at a time, folding the high half back after each multiply so every bit of
+    // the word reaches the low bits too. Only has to notice changes, not resist attacks.
+    const ImU64 HASH_SEED = 0xCBF29CE484222325ull;
+    const ImU64 HASH_PRIME = 0x100000001B3ull;
+
+    ImU64 hashBytes(ImU64 hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        size_t words = size / sizeof(ImU64);
+        for (size_t i = 0; i < words; ++i) {
+            ImU64 word;
+            memcpy(&word, bytes + i * sizeof(ImU64), sizeof(word));
+            hash = (hash ^ word) * HASH_PRIME;
+            hash ^= hash >> 32;
+        }
+        for (size_t i = words * sizeof(ImU64); i < size; ++i) hash = (hash ^ bytes[i]) * HASH_PRIME;
+        return hash;
+    }
+
+    template <typename T>
+    ImU64 hashValue(ImU64 hash, const T& value) {
+        return hashBytes(hash, &value, sizeof(value));
+    }
+
+    ImU64 hashDrawData(const ImDrawData& data) {
+        ImU64 hash = HASH_SEED;
+        hash = hashValue(hash, data.DisplayPos);
+        hash = hashValue(hash, data.DisplaySize);
+        hash = hashValue(hash, data.FramebufferScale);
+        for (int i = 0; i < data.CmdListsCount; ++i) {
+            const ImDrawList* list = data.CmdLists[i];
+            hash = hashValue(hash, list->VtxBuffer.Size);
+            hash = hashBytes(hash, list->VtxBuffer.Data, list->VtxBuffer.size_in_bytes());
+            hash = hashValue(hash, list->IdxBuffer.Size);
+            hash = hashBytes(hash, list->IdxBuffer.Data, list->IdxBuffer.size_in_bytes());
+            // Field by field, the struct's padding isn't ours to rely on
+            for (const ImDrawCmd& command : list->CmdBuffer) {
+                hash = hashValue(hash, command.ClipRect);
+                hash = hashValue(hash, command.TextureId);
+                hash = hashValue(hash, command.VtxOffset);
+                hash = hashValue(hash, command.IdxOffset);
+                hash = hashValue(hash, command.ElemCount);
+                hash = hashValue(hash, command.UserCallback);
+                hash = hashValue(hash, command.UserCallbackData);
+            }
+        }
+        return hash;
+    }
+}
+
+ImGuiDrawSnapshot::ImGuiDrawSnapshot() : contentHash(0) {
+}
+
+ImGuiDrawSnapshot::~ImGuiDrawSnapshot() {
+    for (ImDrawList* list : lists) IM_DELETE(list);
+}
+
+void ImGuiDrawSnapshot::capture(const ImDrawData* source) {
+    data.Clear();
+    contentHash = 0;
+    if (!source || !source->Valid) return;
+    while (lists.Size < source->CmdListsCount) lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+
+    for (int i = 0; i < source->CmdListsCount; ++i) {
+        const ImDrawList* from = source->CmdLists[i];
+        ImDrawList* to = lists[i];
+        copyVector(to->CmdBuffer, from->CmdBuffer);
+        copyVector(to->IdxBuffer, from->IdxBuffer);
+        copyVector(to->VtxBuffer, from->VtxBuffer);
+        to->Flags = from->Flags;
+        data.CmdLists.push_back(to);
+    }
+    data.Valid = true;
+    data.CmdListsCount = source->CmdListsCount;
+    data.TotalIdxCount = source->TotalIdxCount;
+    data.TotalVtxCount = source->TotalVtxCount;
+    data.DisplayPos = source->DisplayPos;
+    data.DisplaySize = source->DisplaySize;
+    data.FramebufferScale = source->FramebufferScale;
+    data.OwnerViewport = nullptr;
+    contentHash = hashDrawData(data);
+}
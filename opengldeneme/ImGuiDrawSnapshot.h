@@ -0,0 +1,32 @@
+#pragma once
+// ImGuiDrawSnapshot.h
+// A copy of ImGui's draw data that stays valid after the next ImGui::NewFrame(), so the render
+// thread can draw one frame's UI while the main thread builds the next. The draw lists are kept
+// between captures and only grow, so a steady UI copies without allocating. Each capture is also
+// hashed, so the renderer can tell an unchanged UI from a new one without comparing the data.
+#ifndef IMGUI_DRAW_SNAPSHOT_H
+#define IMGUI_DRAW_SNAPSHOT_H
+
+#include "imgui/imgui.h"
+
+class ImGuiDrawSnapshot {
+public:
+    ImGuiDrawSnapshot();
+    ~ImGuiDrawSnapshot();
+
+    // Copies the output of ImGui::Render(). Draw callbacks are copied as they are; their data
+    // pointers must stay valid until the copy is drawn.
+    void capture(const ImDrawData* source);
+    // For ImGui_ImplOpenGL3_RenderDrawData(); null before the first capture.
+    ImDrawData* drawData() { return data.Valid ? &data : nullptr; }
+    // Of the vertices, indices, commands and display size of the last capture; equal hashes mean
+    // the UI draws the same pixels, as long as the textures it draws keep their contents.
+    ImU64 hash() const { return contentHash; }
+
+private:
+    ImDrawData data;
+    ImVector<ImDrawList*> lists; // owned, reused by later captures
+    ImU64 contentHash;
+};
+
+#endif
@@ -0,0 +1,144 @@
+// IrradianceVolume.cpp
+#include "IrradianceVolume.h"
+#include "GLState.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+IrradianceVolume::IrradianceVolume()
+    : dims(0), origin(0.0f), spacing(1.0f), randomSeed(1), lastBakeMs(0.0f) {
+    textures[0] = textures[1] = textures[2] = 0;
+}
+
+void IrradianceVolume::init(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float probeSpacing,
+    const PathTracer& tracer) {
+    shutdown();
+    glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    for (int axis = 0; axis < 3; ++axis) {
+        dims[axis] = glm::clamp(static_cast<int>(std::ceil(extent[axis] / probeSpacing)) + 1, 2, MAX_PROBES_PER_AXIS);
+        spacing[axis] = std::max(extent[axis] / (dims[axis] - 1), 1e-3f);
+    }
+    origin = boundsMin;
+
+    // Fibonacci sphere: evenly spread directions, the same for every probe.
+    directions.resize(DIRECTIONS);
+    const float goldenAngle = 2.39996323f;
+    for (int i = 0; i < DIRECTIONS; ++i) {
+        float z = 1.0f - (2.0f * i + 1.0f) / DIRECTIONS;
+        float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        directions[i] = glm::vec3(r * std::cos(goldenAngle * i), r * std::sin(goldenAngle * i), z);
+    }
+
+    int count = static_cast<int>(probeCount());
+    coefficients.assign(count * 3, glm::vec4(0.0f));
+    queue.clear();
+    queued.assign(count, false);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    JobSystem::get().parallelFor(0, count, PROBES_PER_JOB, [&](int first, int last) {
+        for (int index = first; index < last; ++index) {
+            TraceRandom random(static_cast<unsigned int>(index) * 2654435761u + 1u);
+            bakeProbe(tracer, index, random);
+        }
+    });
+    lastBakeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::vector<glm::vec4> channel(count);
+    glGenTextures(3, textures);
+    for (int c = 0; c < 3; ++c) {
+        for (int i = 0; i < count; ++i) channel[i] = coefficients[i * 3 + c];
+        GLState::get().bindTexture(RED_UNIT + c, GL_TEXTURE_3D, textures[c]);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, dims.x, dims.y, dims.z, 0, GL_RGBA, GL_FLOAT, channel.data());
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+}
+
+void IrradianceVolume::shutdown() {
+    GLState& state = GLState::get();
+    for (int c = 0; c < 3; ++c) {
+        if (textures[c]) state.deleteTexture(textures[c]);
+        textures[c] = 0;
+    }
+    queue.clear();
+}
+
+glm::vec3 IrradianceVolume::probePosition(int index) const {
+    int x = index % dims.x;
+    int y = (index / dims.x) % dims.y;
+    int z = index / (dims.x * dims.y);
+    return origin + spacing * glm::vec3(x, y, z);
+}
+
+// Projects the traced radiance onto L1 SH and folds in the clamped-cosine convolution and 1/pi,
+// so the shader's c0 + dot(c1, n) is directly the diffuse incoming light the lightmap stores.
+// With N uniform samples: c0 = Y0^2 * 4pi/N * sum(L) = sum(L) / N and
+// c1 = (2/3) * Y1^2 * 4pi/N * sum(L w) = 2/N * sum(L w).
+void IrradianceVolume::bakeProbe(const PathTracer& tracer, int index, TraceRandom& random) {
+    glm::vec3 radiance[DIRECTIONS];
+    tracer.traceRadiance(probePosition(index), directions.data(), radiance, DIRECTIONS, BOUNCES, random);
+
+    glm::vec3 sum(0.0f);
+    glm::vec3 weighted[3] = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) };
+    for (int i = 0; i < DIRECTIONS; ++i) {
+        sum += radiance[i];
+        for (int c = 0; c < 3; ++c) weighted[c] += radiance[i][c] * directions[i];
+    }
+    for (int c = 0; c < 3; ++c) {
+        coefficients[index * 3 + c] = glm::vec4(sum[c] / DIRECTIONS, weighted[c] * (2.0f / DIRECTIONS));
+    }
+}
+
+void IrradianceVolume::uploadProbe(int index) {
+    int x = index % dims.x;
+    int y = (index / dims.x) % dims.y;
+    int z = index / (dims.x * dims.y);
+    for (int c = 0; c < 3; ++c) {
+        GLState::get().bindTexture(RED_UNIT + c, GL_TEXTURE_3D, textures[c]);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, x, y, z, 1, 1, 1, GL_RGBA, GL_FLOAT, &coefficients[index * 3 + c]);
+    }
+}
+
+void IrradianceVolume::invalidate(const glm::vec3& position, float radius) {
+    if (!isReady()) return;
+    glm::ivec3 low = glm::max(glm::ivec3(glm::floor((position - radius - origin) / spacing)), glm::ivec3(0));
+    glm::ivec3 high = glm::min(glm::ivec3(glm::ceil((position + radius - origin) / spacing)), dims - 1);
+    for (int z = low.z; z <= high.z; ++z) {
+        for (int y = low.y; y <= high.y; ++y) {
+            for (int x = low.x; x <= high.x; ++x) {
+                int index = x + dims.x * (y + dims.y * z);
+                if (queued[index] || glm::distance(probePosition(index), position) > radius) continue;
+                queued[index] = true;
+                queue.push_back(index);
+            }
+        }
+    }
+}
+
+void IrradianceVolume::update(const PathTracer& tracer, int maxProbes) {
+    if (queue.empty()) return;
+    TraceRandom random(randomSeed++);
+    for (int i = 0; i < maxProbes && !queue.empty(); ++i) {
+        int index = queue.front();
+        queue.pop_front();
+        queued[index] = false;
+        bakeProbe(tracer, index, random);
+        uploadProbe(index);
+    }
+}
+
+void IrradianceVolume::apply(Shader& shader) const {
+    GLState& state = GLState::get();
+    shader.use();
+    for (int c = 0; c < 3; ++c) state.bindTexture(RED_UNIT + c, GL_TEXTURE_3D, textures[c]);
+    shader.setInt("probeRed", RED_UNIT);
+    shader.setInt("probeGreen", GREEN_UNIT);
+    shader.setInt("probeBlue", BLUE_UNIT);
+    shader.setVec3("probeGridOrigin", origin);
+    shader.setVec3("probeGridSpacing", spacing);
+    shader.setVec3("probeGridSize", glm::vec3(dims));
+}
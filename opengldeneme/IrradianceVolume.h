@@ -0,0 +1,66 @@
+#pragma once
+// IrradianceVolume.h
+// Grid of irradiance probes over the hall for objects without a lightmap (the robot). Each probe
+// stores the indirect light around it as L1 spherical harmonics, baked on the CPU with the path
+// tracer, and the shader interpolates them trilinearly from three 3D textures (one per color
+// channel). When an exhibit moves, the probes around it are queued and re-baked a few per frame.
+#ifndef IRRADIANCE_VOLUME_H
+#define IRRADIANCE_VOLUME_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <deque>
+#include <vector>
+#include "PathTracer.h"
+#include "Shader.h"
+
+class IrradianceVolume {
+public:
+    static const int MAX_PROBES_PER_AXIS = 64;
+    static const int DIRECTIONS = 64;     // rays per probe, spread evenly over the sphere
+    static const int BOUNCES = 3;
+    static const int PROBES_PER_JOB = 8;
+
+    // Texture units of the red, green and blue coefficient volumes.
+    static const int RED_UNIT = 7;
+    static const int GREEN_UNIT = 8;
+    static const int BLUE_UNIT = 9;
+
+    IrradianceVolume();
+
+    // Places probes spacing apart (fewer if an axis would exceed MAX_PROBES_PER_AXIS) over the box,
+    // bakes all of them on the job system and uploads the result.
+    void init(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float spacing, const PathTracer& tracer);
+    void shutdown();
+    bool isReady() const { return textures[0] != 0; }
+
+    // Queues every probe within radius of position for re-baking.
+    void invalidate(const glm::vec3& position, float radius);
+    // Re-bakes and uploads up to maxProbes queued probes.
+    void update(const PathTracer& tracer, int maxProbes);
+
+    void apply(Shader& shader) const;
+
+    unsigned int probeCount() const { return static_cast<unsigned int>(dims.x * dims.y * dims.z); }
+    unsigned int pendingProbes() const { return static_cast<unsigned int>(queue.size()); }
+    const glm::ivec3& gridSize() const { return dims; }
+    float bakeMilliseconds() const { return lastBakeMs; }
+
+private:
+    void bakeProbe(const PathTracer& tracer, int index, TraceRandom& random);
+    void uploadProbe(int index);
+    glm::vec3 probePosition(int index) const;
+
+    GLuint textures[3];
+    glm::ivec3 dims;
+    glm::vec3 origin;
+    glm::vec3 spacing;
+    std::vector<glm::vec3> directions;
+    std::vector<glm::vec4> coefficients;  // 3 per probe: (c0, c1) for red, green, blue
+    std::deque<int> queue;
+    std::vector<bool> queued;
+    unsigned int randomSeed;
+    float lastBakeMs;
+};
+
+#endif
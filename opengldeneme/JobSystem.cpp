@@ -0,0 +1,161 @@
+// JobSystem.cpp
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+    // Queue index of the current thread: its own deque for workers, the shared one otherwise.
+    thread_local int workerIndex = -1;
+}
+
+JobSystem& JobSystem::get() {
+    static JobSystem instance;
+    return instance;
+}
+
+JobSystem::JobSystem() : queuedJobs(0), stopping(false) {
+    queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+void JobSystem::init(int workerCount) {
+    shutdown();
+    if (workerCount < 0) workerCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) - 1;
+    // The shared queue stays last, along with whatever shutdown() left in it.
+    for (int i = 0; i < workerCount; ++i) queues.insert(queues.begin(), std::unique_ptr<WorkQueue>(new WorkQueue()));
+    stopping = false;
+    for (int i = 0; i < workerCount; ++i) workers.push_back(std::thread(&JobSystem::workerLoop, this, static_cast<unsigned int>(i)));
+}
+
+void JobSystem::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    // Jobs still queued have nobody to run them now, so they move to the shared queue.
+    WorkQueue& shared = *queues.back();
+    for (size_t i = 0; i + 1 < queues.size(); ++i) {
+        shared.jobs.insert(shared.jobs.end(), queues[i]->jobs.begin(), queues[i]->jobs.end());
+    }
+    queues.erase(queues.begin(), queues.end() - 1);
+}
+
+void JobSystem::push(const Job& job) {
+    WorkQueue& queue = workerIndex >= 0 ? *queues[workerIndex] : *queues.back();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    // Taking the mutex orders this against a worker between its check and its sleep.
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wake.notify_one();
+}
+
+// Newest job of our own deque first (its data is still in cache), then the oldest of the
+// shared queue and of the other workers'.
+bool JobSystem::popOrSteal(Job& job) {
+    if (queuedJobs.load(std::memory_order_acquire) <= 0) return false;
+    const int count = static_cast<int>(queues.size());
+    if (workerIndex >= 0) {
+        WorkQueue& own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    const int start = workerIndex >= 0 ? workerIndex + 1 : 0;
+    for (int i = 0; i < count; ++i) {
+        int victim = (start + i) % count;
+        if (victim == workerIndex) continue;
+        WorkQueue& queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The waiter may destroy the counter as soon as pending reaches zero, so that comes last.
+void JobSystem::execute(Job& job) {
+    job.function();
+    JobCounter& counter = *job.counter;
+    if (counter.running.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::vector<Job> ready;
+        {
+            std::lock_guard<std::mutex> lock(counter.continuationMutex);
+            ready.swap(counter.continuations);
+        }
+        for (const Job& next : ready) push(next);
+    }
+    counter.pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::run(const std::function<void()>& function, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    counter.running.fetch_add(1, std::memory_order_relaxed);
+    push({ function, &counter });
+}
+
+void JobSystem::runAfter(JobCounter& dependency, const std::function<void()>& function, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    counter.running.fetch_add(1, std::memory_order_relaxed);
+    {
+        // Checked under the lock, so a job finishing now either sees this continuation or
+        // has already dropped running to zero and we submit it ourselves
+        std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+        if (dependency.running.load(std::memory_order_acquire) > 0) {
+            dependency.continuations.push_back({ function, &counter });
+            return;
+        }
+    }
+    push({ function, &counter });
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    Job job;
+    while (!counter.isDone()) {
+        if (popOrSteal(job)) execute(job);
+        else std::this_thread::yield(); // the last jobs are running elsewhere
+    }
+}
+
+void JobSystem::parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& body) {
+    grain = std::max(grain, 1);
+    if (end - begin <= grain) {
+        if (end > begin) body(begin, end);
+        return;
+    }
+    JobCounter counter;
+    for (int first = begin; first < end; first += grain) {
+        int last = std::min(first + grain, end);
+        run([&body, first, last]() { body(first, last); }, counter);
+    }
+    wait(counter);
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+    workerIndex = static_cast<int>(index);
+    Job job;
+    for (;;) {
+        if (popOrSteal(job)) {
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
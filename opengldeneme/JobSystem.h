@@ -0,0 +1,88 @@
+#pragma once
+// JobSystem.h
+// Work-stealing job system for CPU work that splits across cores (culling, light assignment,
+// probe baking). Every worker has its own deque: it pushes and pops its own jobs at the back,
+// and when it runs dry it steals from the front of another one. Threads outside the pool submit
+// to a shared queue. Jobs report to a JobCounter, which is the handle that is waited on and
+// depended on; waiting runs other jobs instead of blocking, so the waiting thread always helps.
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+struct Job {
+    std::function<void()> function;
+    JobCounter* counter;
+};
+
+// Number of unfinished jobs in a group. A counter must outlive its jobs and must not get new
+// jobs once something depends on it finishing.
+class JobCounter {
+public:
+    JobCounter() : running(0), pending(0) {}
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> running;       // jobs whose function hasn't returned
+    std::atomic<int> pending;       // the same, but only dropped once the job is done with the counter
+    std::mutex continuationMutex;
+    std::vector<Job> continuations; // submitted when running reaches zero
+};
+
+class JobSystem {
+public:
+    // init() argument for one worker per core besides the caller.
+    static const int DEFAULT_WORKERS = -1;
+
+    static JobSystem& get();
+
+    // Starts workerCount threads, or DEFAULT_WORKERS. Until then, and with no workers, jobs run
+    // on the thread that waits for them.
+    void init(int workerCount);
+    void shutdown();
+    // Workers plus the thread that waits.
+    unsigned int threadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    void run(const std::function<void()>& function, JobCounter& counter);
+    // Queues function once dependency is done; counter covers it from now on.
+    void runAfter(JobCounter& dependency, const std::function<void()>& function, JobCounter& counter);
+    // Runs queued jobs until counter is done.
+    void wait(JobCounter& counter);
+
+    // Calls body(first, last) on consecutive ranges of at most grain indices that cover
+    // [begin, end), in parallel, and returns once all of them are done.
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& body);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    JobSystem();
+    ~JobSystem();
+
+    void push(const Job& job);
+    bool popOrSteal(Job& job);
+    void execute(Job& job);
+    void workerLoop(unsigned int index);
+
+    std::vector<std::unique_ptr<WorkQueue> > queues; // one per worker, then the shared one
+    std::vector<std::thread> workers;
+    std::atomic<int> queuedJobs;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,49 @@
+// Lightmap.cpp
+#include "Lightmap.h"
+#include "GLState.h"
+#include <iostream>
+
+Lightmap::Lightmap() : texture(0), atlasWidth(0), atlasHeight(0) {
+}
+
+bool Lightmap::load(const std::string& path) {
+    LightmapData data;
+    std::string error;
+    if (!readLightmapFile(path, data, error)) {
+        std::cerr << "ERROR::LIGHTMAP::LOAD_FAILED: " << path << " (" << error << ")" << std::endl;
+        return false;
+    }
+    shutdown();
+
+    glGenTextures(1, &texture);
+    GLState::get().bindTexture(LIGHTMAP_UNIT, GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, data.width, data.height, 0, GL_RGB, GL_FLOAT, data.texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    atlasWidth = data.width;
+    atlasHeight = data.height;
+    charts.swap(data.charts);
+    return true;
+}
+
+void Lightmap::shutdown() {
+    if (texture) GLState::get().deleteTexture(texture);
+    texture = 0;
+    charts.clear();
+}
+
+int Lightmap::chartIndex(const std::string& name) const {
+    for (size_t i = 0; i < charts.size(); ++i)
+        if (charts[i].name == name) return static_cast<int>(i);
+    return -1;
+}
+
+void Lightmap::apply(Shader& shader) const {
+    shader.use();
+    GLState::get().bindTexture(LIGHTMAP_UNIT, GL_TEXTURE_2D, texture);
+    shader.setInt("lightmap", LIGHTMAP_UNIT);
+}
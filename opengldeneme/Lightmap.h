@@ -0,0 +1,42 @@
+#pragma once
+// Lightmap.h
+// Baked indirect lighting loaded from the bake tool's output. The atlas is uploaded as a half
+// float texture; objects look up their chart by name and pass its face rectangles to the shader,
+// which picks the rectangle for each vertex from the dominant axis of its normal.
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "LightmapFile.h"
+#include "Shader.h"
+
+class Lightmap {
+public:
+    // Texture unit the shader samples the atlas from.
+    static const int LIGHTMAP_UNIT = 6;
+
+    Lightmap();
+
+    bool load(const std::string& path);
+    void shutdown();
+    bool isLoaded() const { return texture != 0; }
+
+    // Chart of an object (exhibit name or "Floor"), -1 if it was not baked.
+    int chartIndex(const std::string& name) const;
+    const glm::vec4* faceRects(int chart) const { return charts[chart].faceRects; }
+
+    void apply(Shader& shader) const;
+
+    unsigned int width() const { return atlasWidth; }
+    unsigned int height() const { return atlasHeight; }
+
+private:
+    GLuint texture;
+    unsigned int atlasWidth, atlasHeight;
+    std::vector<LightmapChart> charts;
+};
+
+#endif
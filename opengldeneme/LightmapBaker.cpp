@@ -0,0 +1,223 @@
+// LightmapBaker.cpp
+#include "LightmapBaker.h"
+#include "CubeVertices.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+LightmapBaker::LightmapBaker(const LightmapBakeSettings& settings) : settings(settings) {
+    lastStats = LightmapBakeStats();
+}
+
+// One chart per object, one face rectangle per box side. The uv -> position map of each side is
+// affine, so it is solved once from the first triangle of the side and reused for every texel.
+void LightmapBaker::addChart(const std::string& name, const glm::mat4& model) {
+    int chart = static_cast<int>(chartNames.size());
+    chartNames.push_back(name);
+    glm::mat3 linear(model);
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+
+    const int stride = 8;
+    for (int side = 0; side < numCubeVertices / 6; ++side) {
+        const float* v0 = &cubeVertices[(side * 6) * stride];
+        const float* v1 = v0 + stride;
+        const float* v2 = v1 + stride;
+        glm::vec3 normal(v0[3], v0[4], v0[5]);
+        int faceIndex = lightmapFaceIndex(normal);
+        if (faceIndex == 3) continue; // bottom faces rest on the floor or face it; never seen
+
+        glm::vec3 p0(v0[0], v0[1], v0[2]), p1(v1[0], v1[1], v1[2]), p2(v2[0], v2[1], v2[2]);
+        glm::vec2 uv0(v0[6], v0[7]), uv1(v1[6], v1[7]), uv2(v2[6], v2[7]);
+        glm::vec2 d1 = uv1 - uv0, d2 = uv2 - uv0;
+        float det = d1.x * d2.y - d2.x * d1.y;
+        if (std::fabs(det) < 1e-6f) continue;
+        glm::vec3 axisS = ((p1 - p0) * d2.y - (p2 - p0) * d1.y) / det;
+        glm::vec3 axisT = ((p2 - p0) * d1.x - (p1 - p0) * d2.x) / det;
+        glm::vec3 origin = p0 - axisS * uv0.x - axisT * uv0.y;
+
+        Face face;
+        face.chart = chart;
+        face.face = faceIndex;
+        face.origin = glm::vec3(model * glm::vec4(origin, 1.0f));
+        face.axisS = linear * axisS;
+        face.axisT = linear * axisT;
+        face.normal = glm::normalize(normalMatrix * normal);
+        face.x = face.y = 0;
+        face.width = face.height = 0;
+        faces.push_back(face);
+    }
+}
+
+void LightmapBaker::sizeFaces(float texelsPerUnit) {
+    int largest = static_cast<int>(settings.maxSize / 4);
+    for (auto& face : faces) {
+        face.width = glm::clamp(static_cast<int>(std::ceil(glm::length(face.axisS) * texelsPerUnit)), 2, largest);
+        face.height = glm::clamp(static_cast<int>(std::ceil(glm::length(face.axisT) * texelsPerUnit)), 2, largest);
+    }
+}
+
+// Shelf packing, tallest faces first, into an atlas size texels wide.
+bool LightmapBaker::pack(unsigned int size) {
+    std::vector<size_t> order(faces.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return faces[a].height > faces[b].height; });
+
+    int padding = settings.padding;
+    int x = 0, y = 0, shelfHeight = 0;
+    for (size_t index : order) {
+        Face& face = faces[index];
+        int cellWidth = face.width + 2 * padding;
+        int cellHeight = face.height + 2 * padding;
+        if (cellWidth > static_cast<int>(size)) return false;
+        if (x + cellWidth > static_cast<int>(size)) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + cellHeight > static_cast<int>(size)) return false;
+        face.x = x + padding;
+        face.y = y + padding;
+        x += cellWidth;
+        shelfHeight = std::max(shelfHeight, cellHeight);
+    }
+    return true;
+}
+
+void LightmapBaker::traceFaces(const PathTracer& tracer, LightmapData& result, std::vector<unsigned char>& covered, unsigned int threadCount) {
+    // Work is handed out a face row at a time through an atomic counter.
+    std::vector<std::pair<unsigned int, int> > rows;
+    for (unsigned int i = 0; i < faces.size(); ++i)
+        for (int row = 0; row < faces[i].height; ++row) rows.push_back(std::make_pair(i, row));
+
+    std::atomic<size_t> nextRow(0);
+    std::atomic<size_t> finishedRows(0);
+    auto worker = [&]() {
+        for (;;) {
+            size_t r = nextRow.fetch_add(1);
+            if (r >= rows.size()) break;
+            const Face& face = faces[rows[r].first];
+            int row = rows[r].second;
+            TraceRandom random(static_cast<unsigned int>(r * 2654435761u + 1));
+            float t = (row + 0.5f) / face.height;
+            for (int column = 0; column < face.width; ++column) {
+                float s = (column + 0.5f) / face.width;
+                glm::vec3 position = face.origin + face.axisS * s + face.axisT * t;
+                glm::vec3 value = tracer.indirectLight(position, face.normal, settings.samples, settings.bounces, random);
+                size_t texel = static_cast<size_t>(face.y + row) * result.width + face.x + column;
+                result.texels[texel * 3 + 0] = value.r;
+                result.texels[texel * 3 + 1] = value.g;
+                result.texels[texel * 3 + 2] = value.b;
+                covered[texel] = 1;
+            }
+            finishedRows.fetch_add(1);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threadCount; ++i) pool.push_back(std::thread(worker));
+    while (finishedRows.load() < rows.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::cout << "\rBaking: " << (finishedRows.load() * 100 / std::max<size_t>(rows.size(), 1)) << "%" << std::flush;
+    }
+    std::cout << std::endl;
+    for (auto& thread : pool) thread.join();
+}
+
+// Grows every face into its padding so bilinear filtering never blends in unbaked texels.
+void LightmapBaker::dilate(LightmapData& result, std::vector<unsigned char>& covered) const {
+    int width = static_cast<int>(result.width), height = static_cast<int>(result.height);
+    for (int pass = 0; pass < settings.padding; ++pass) {
+        std::vector<unsigned char> next = covered;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t texel = static_cast<size_t>(y) * width + x;
+                if (covered[texel]) continue;
+                glm::vec3 sum(0.0f);
+                int count = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                        size_t neighbour = static_cast<size_t>(ny) * width + nx;
+                        if (!covered[neighbour]) continue;
+                        sum += glm::vec3(result.texels[neighbour * 3], result.texels[neighbour * 3 + 1], result.texels[neighbour * 3 + 2]);
+                        count++;
+                    }
+                }
+                if (count == 0) continue;
+                sum /= static_cast<float>(count);
+                result.texels[texel * 3 + 0] = sum.r;
+                result.texels[texel * 3 + 1] = sum.g;
+                result.texels[texel * 3 + 2] = sum.b;
+                next[texel] = 1;
+            }
+        }
+        covered.swap(next);
+    }
+}
+
+bool LightmapBaker::bake(const GalleryLayout& layout, LightmapData& result, std::string& error) {
+    auto start = std::chrono::high_resolution_clock::now();
+    chartNames.clear();
+    faces.clear();
+    addChart("Floor", glm::scale(glm::translate(glm::mat4(1.0f), layout.floorCenter), layout.floorSize));
+    for (const auto& exhibit : layout.exhibits)
+        addChart(exhibit.name, glm::scale(glm::translate(glm::mat4(1.0f), exhibit.position), exhibit.scale));
+
+    // Smallest power-of-two width that holds every face; lower the density if even maxSize does not.
+    float density = settings.texelsPerUnit;
+    unsigned int size = 0;
+    for (;;) {
+        sizeFaces(density);
+        for (unsigned int candidate = 256; candidate <= settings.maxSize; candidate *= 2) {
+            if (pack(candidate)) {
+                size = candidate;
+                break;
+            }
+        }
+        if (size != 0) break;
+        density *= 0.75f;
+        if (density < 0.25f) {
+            error = "charts do not fit into the atlas";
+            return false;
+        }
+    }
+    int usedHeight = 0;
+    for (const auto& face : faces) usedHeight = std::max(usedHeight, face.y + face.height + settings.padding);
+
+    PathTracer tracer;
+    tracer.addLayout(layout, settings.trackLights);
+    tracer.setEnvironment(settings.environment);
+    tracer.build();
+
+    result.width = size;
+    result.height = static_cast<unsigned int>((usedHeight + 3) & ~3);
+    result.texels.assign(static_cast<size_t>(result.width) * result.height * 3, 0.0f);
+    result.charts.resize(chartNames.size());
+    for (size_t i = 0; i < chartNames.size(); ++i) {
+        result.charts[i].name = chartNames[i];
+        for (int f = 0; f < LIGHTMAP_FACES; ++f) result.charts[i].faceRects[f] = glm::vec4(0.0f);
+    }
+    for (const auto& face : faces) {
+        result.charts[face.chart].faceRects[face.face] = glm::vec4(
+            static_cast<float>(face.x) / result.width, static_cast<float>(face.y) / result.height,
+            static_cast<float>(face.width) / result.width, static_cast<float>(face.height) / result.height);
+    }
+
+    unsigned int threadCount = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned char> covered(static_cast<size_t>(result.width) * result.height, 0);
+    traceFaces(tracer, result, covered, threadCount);
+    dilate(result, covered);
+
+    lastStats.texels = 0;
+    for (const auto& face : faces) lastStats.texels += face.width * face.height;
+    lastStats.threads = threadCount;
+    lastStats.rays = tracer.raysTraced();
+    lastStats.texelsPerUnit = density;
+    lastStats.seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+// LightmapBaker.h
+// Offline lightmap bake for the static hall. Every box face of the floor and the exhibits gets
+// its own chart, sized by world area; the charts are shelf-packed into one atlas and each texel
+// is path traced on a pool of worker threads. Only indirect light is stored: the viewer still
+// shades direct light itself so the spotlights and shadows stay dynamic.
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "GalleryLayout.h"
+#include "LightmapFile.h"
+#include "PathTracer.h"
+
+struct LightmapBakeSettings {
+    float texelsPerUnit;
+    int samples;            // hemisphere samples per texel
+    int bounces;
+    int padding;            // texels around each face, filled by dilation
+    unsigned int maxSize;   // atlas size limit; density is lowered until everything fits
+    unsigned int threads;   // 0 = hardware concurrency
+    bool trackLights;
+    glm::vec3 environment;  // radiance leaving the hall, standing in for walls and ceiling
+
+    LightmapBakeSettings()
+        : texelsPerUnit(8.0f), samples(128), bounces(3), padding(2), maxSize(4096), threads(0),
+          trackLights(true), environment(HALL_ENVIRONMENT_RADIANCE) {}
+};
+
+struct LightmapBakeStats {
+    unsigned int texels;    // texels traced (dilated padding not included)
+    unsigned int threads;
+    unsigned long long rays;
+    float texelsPerUnit;    // density actually used
+    float seconds;
+};
+
+class LightmapBaker {
+public:
+    explicit LightmapBaker(const LightmapBakeSettings& settings);
+
+    bool bake(const GalleryLayout& layout, LightmapData& result, std::string& error);
+    const LightmapBakeStats& stats() const { return lastStats; }
+
+private:
+    struct Face {
+        int chart;
+        int face;              // LIGHTMAP_FACES index
+        glm::vec3 origin;      // world position at face uv (0, 0)
+        glm::vec3 axisS;       // world offset for uv (1, 0)
+        glm::vec3 axisT;
+        glm::vec3 normal;
+        int x, y;              // atlas texel rectangle, padding excluded
+        int width, height;
+    };
+
+    void addChart(const std::string& name, const glm::mat4& model);
+    void sizeFaces(float texelsPerUnit);
+    bool pack(unsigned int size);
+    void traceFaces(const PathTracer& tracer, LightmapData& result, std::vector<unsigned char>& covered, unsigned int threadCount);
+    void dilate(LightmapData& result, std::vector<unsigned char>& covered) const;
+
+    LightmapBakeSettings settings;
+    std::vector<std::string> chartNames;
+    std::vector<Face> faces;
+    LightmapBakeStats lastStats;
+};
+
+#endif
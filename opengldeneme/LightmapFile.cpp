@@ -0,0 +1,97 @@
+// LightmapFile.cpp
+#include "LightmapFile.h"
+#include <cmath>
+#include <fstream>
+
+namespace {
+
+const unsigned int FILE_MAGIC = 0x504D4C56; // "VLMP"
+const unsigned int FILE_VERSION = 1;
+const unsigned int MAX_NAME_LENGTH = 1024;
+
+struct FileHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int width;
+    unsigned int height;
+    unsigned int chartCount;
+};
+
+} // namespace
+
+int lightmapFaceIndex(const glm::vec3& normal) {
+    glm::vec3 a = glm::abs(normal);
+    if (a.x >= a.y && a.x >= a.z) return normal.x >= 0.0f ? 0 : 1;
+    if (a.y >= a.z) return normal.y >= 0.0f ? 2 : 3;
+    return normal.z >= 0.0f ? 4 : 5;
+}
+
+bool readLightmapFile(const std::string& path, LightmapData& data, std::string& error) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        error = "cannot open file";
+        return false;
+    }
+
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != FILE_MAGIC) {
+        error = "not a lightmap file";
+        return false;
+    }
+    if (header.version != FILE_VERSION) {
+        error = "unsupported lightmap version";
+        return false;
+    }
+    if (header.width == 0 || header.height == 0 || header.width > 16384 || header.height > 16384) {
+        error = "bad lightmap size";
+        return false;
+    }
+
+    data.width = header.width;
+    data.height = header.height;
+    data.charts.resize(header.chartCount);
+    for (auto& chart : data.charts) {
+        unsigned int length = 0;
+        if (!file.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > MAX_NAME_LENGTH) {
+            error = "truncated chart table";
+            return false;
+        }
+        chart.name.resize(length);
+        if (length > 0) file.read(&chart.name[0], length);
+        file.read(reinterpret_cast<char*>(chart.faceRects), sizeof(chart.faceRects));
+        if (!file) {
+            error = "truncated chart table";
+            return false;
+        }
+    }
+
+    data.texels.resize(static_cast<size_t>(data.width) * data.height * 3);
+    if (!file.read(reinterpret_cast<char*>(data.texels.data()), data.texels.size() * sizeof(float))) {
+        error = "truncated texel data";
+        return false;
+    }
+    return true;
+}
+
+bool writeLightmapFile(const std::string& path, const LightmapData& data, std::string& error) {
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot create file";
+        return false;
+    }
+
+    FileHeader header = { FILE_MAGIC, FILE_VERSION, data.width, data.height, static_cast<unsigned int>(data.charts.size()) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& chart : data.charts) {
+        unsigned int length = static_cast<unsigned int>(chart.name.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(chart.name.data(), length);
+        file.write(reinterpret_cast<const char*>(chart.faceRects), sizeof(chart.faceRects));
+    }
+    file.write(reinterpret_cast<const char*>(data.texels.data()), data.texels.size() * sizeof(float));
+    if (!file) {
+        error = "write failed";
+        return false;
+    }
+    return true;
+}
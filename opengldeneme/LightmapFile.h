@@ -0,0 +1,31 @@
+#pragma once
+// LightmapFile.h
+// On-disk format of a baked lightmap atlas, written by the bake tool and read by the viewer.
+// Every baked object owns one chart with a rectangle per box face; texels are linear RGB floats.
+#ifndef LIGHTMAP_FILE_H
+#define LIGHTMAP_FILE_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Box faces in the order used by the charts: +X, -X, +Y, -Y, +Z, -Z.
+const int LIGHTMAP_FACES = 6;
+int lightmapFaceIndex(const glm::vec3& normal);
+
+struct LightmapChart {
+    std::string name;                     // exhibit name, or "Floor"
+    glm::vec4 faceRects[LIGHTMAP_FACES];  // atlas (u0, v0, du, dv) per face; zero size if not baked
+};
+
+struct LightmapData {
+    unsigned int width;
+    unsigned int height;
+    std::vector<LightmapChart> charts;
+    std::vector<float> texels;            // width * height RGB, row 0 at v = 0
+};
+
+bool readLightmapFile(const std::string& path, LightmapData& data, std::string& error);
+bool writeLightmapFile(const std::string& path, const LightmapData& data, std::string& error);
+
+#endif
@@ -5,13 +5,48 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
 #include <cmath> // For M_PI, cos, sin if not using GLM for everything
 
 #include "Shader.h"
+#include "ShaderVariants.h"
+#include "ShaderCompiler.h"
+#include "ProgramCache.h"
+#include "GLState.h"
+#include "GLExtensions.h"
+#include "TextureManager.h"
+#include "RenderStats.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "ClusteredLighting.h"
+#include "ShadowMaps.h"
+#include "Lightmap.h"
+#include "IrradianceVolume.h"
+#include "PathTracer.h"
+#include "Overdraw.h"
+#include "DeferredRenderer.h"
+#include "DynamicResolution.h"
+#include "RenderGraph.h"
+#include "ScreenCapture.h"
+#include "BatchRender.h"
+#include "Benchmark.h"
+#include "FrameScheduler.h"
+#include "FramePacing.h"
+#include "TripleBuffer.h"
+#include "ImGuiDrawSnapshot.h"
+#include "SearchIndex.h"
+#include "UILayer.h"
+#include "FontAtlasCache.h"
 #include "Camera.h"
 #include "Mesh.h" // Our simplified mesh
 #include "CubeVertices.h"
@@ -39,20 +74,79 @@ bool mouseCaptured = true; // Start with mouse captured for camera control
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Fixed-rate simulation: the robot advances in SIMULATION_STEP ticks however long a frame takes,
+// and is drawn interpolated between the last two ticks
+const float SIMULATION_STEP = 1.0f / 120.0f;
+const int MAX_SIMULATION_STEPS = 24; // per frame; a longer hitch slows the simulation down instead
+float simulationAccumulator = 0.0f;
+int simulationStepsLastFrame = 0;
+
+// Offline batch rendering of the tour (--batch-render), see BatchRender.h
+const float MAX_TOUR_SECONDS = 600.0f;
+const unsigned int MAX_DEFAULT_BATCH_WORKERS = 4; // they share one GPU, so more rarely pays off
+const int MAX_SETTLE_RENDERS = 240; // draws of a frame while its textures stream in and shaders compile
+
 // Museum Objects
 struct MuseumObject {
     std::string name;
     std::string description;
+    std::string tags;
     glm::vec3 position;
     glm::vec3 scale;
     glm::vec3 color;
     Mesh* mesh; // Each object will use a mesh (e.g., a cube for now)
     bool scanned;
+    std::string texturePath; // scanned artwork (BC-compressed DDS), empty for plain color
+    TextureHandle texture;
+    int lightmapChart;       // chart in the baked lightmap, -1 if not baked
 };
 std::vector<MuseumObject> museumObjects;
 int currentScannedObjectIndex = -1; // -1 means no object info displayed
 
+// Exhibit catalog: a window listing the exhibits, searched as you type
+const size_t MAX_CATALOG_RESULTS = 10000; // more matches than this and the list says to keep typing
+SearchIndex exhibitIndex;  // document i is museumObjects[i]
+bool showCatalog = false;
+char catalogQuery[128] = "";
+std::vector<unsigned int> catalogResults;
+bool catalogComplete = true; // catalogResults holds every match
+float catalogSearchMs = 0.0f;
+
+// UI font: Latin with the Turkish letters, Greek and punctuation from the first file found, Arabic
+// merged into it from another; ImGui's built-in font if there is none. Baked once, then cached.
+const float UI_FONT_SIZE = 16.0f;
+const char* const UI_FONT_FILES[] = { "fonts/NotoSans-Regular.ttf", "C:/Windows/Fonts/segoeui.ttf" };
+const char* const UI_ARABIC_FONT_FILES[] = { "fonts/NotoSansArabic-Regular.ttf", "C:/Windows/Fonts/segoeui.ttf" };
+const ImWchar UI_FONT_RANGES[] = {
+    0x0020, 0x00FF, // Basic Latin, Latin-1 Supplement
+    0x0100, 0x017F, // Latin Extended-A: the dotless i, g with breve, s with cedilla
+    0x0370, 0x03FF, // Greek and Coptic
+    0x2000, 0x206F, // General Punctuation, for the ellipsis
+    0 };
+const ImWchar UI_ARABIC_RANGES[] = {
+    0x0600, 0x06FF, 0x0750, 0x077F, // Arabic, Arabic Supplement
+    0xFB50, 0xFDFF, 0xFE70, 0xFEFF, // presentation forms
+    0 };
+FontAtlasStats fontAtlasStats;
+
+// What the renderer needs of an exhibit; the render thread gets a copy in every frame snapshot
+struct ExhibitInstance {
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec3 color;
+    Mesh* mesh;
+    TextureHandle texture;
+    int lightmapChart;
+};
+
 // Robot
+// The part of the robot the renderer interpolates between simulation ticks
+struct RobotPose {
+    glm::vec3 position;
+    float orientation;
+    float armAngle;
+};
+
 struct Robot {
     glm::vec3 position;
     glm::vec3 initialPosition;
@@ -64,8 +158,10 @@ struct Robot {
     bool autoMode;
     bool returningHome;
     float moveSpeed;
+    RobotPose previousPose; // pose at the start of the last simulation tick
 };
 Robot robot;
+RobotPose robotRenderPose;
 
 // Lighting
 glm::vec3 mainLightPos(0.0f, 10.0f, 0.0f);
@@ -76,21 +172,448 @@ glm::vec3 spotLightPos = glm::vec3(0.0f, 5.0f, 0.0f); // Will be updated by robo
 glm::vec3 spotLightDir = glm::vec3(0.0f, -1.0f, 0.0f); // Points straight down
 bool spotLightOn = false;
 
+// Gallery track lights, one per exhibit, shaded through the light clusters
+ClusteredLighting clusteredLighting;
+bool trackLightsOn = true;
+std::vector<GalleryLight> galleryLights;
+
+// Shadows: the main light, the robot's spotlight and the track lights closest to the camera
+ShadowMaps shadowMaps;
+bool shadowsOn = true;
+const unsigned int MAX_TRACK_LIGHT_SHADOWS = 24;
+const unsigned int MAIN_LIGHT_SHADOW_KEY = 0;
+const unsigned int ROBOT_SPOT_SHADOW_KEY = 1;
+const unsigned int TRACK_LIGHT_SHADOW_KEY = 100; // + exhibit index
+std::vector<ShadowCaster> staticCasters;  // exhibits
+std::vector<ShadowCaster> dynamicCasters; // robot
+
+// Floor, grows when --stress adds exhibits behind the main room
+glm::vec3 floorCenter;
+glm::vec3 floorSize;
+
+// Baked indirect light from the bake tool, replaces the flat ambient term where available
+Lightmap lightmap;
+bool bakedLightingOn = true;
+int floorLightmapChart = -1;
+bool lightmapStale = false; // an exhibit moved since the bake
+
+// Irradiance probes light everything without a lightmap; the probes around an exhibit moved in
+// the editor are re-baked a few per frame against the updated scene
+PathTracer sceneTracer;
+IrradianceVolume irradianceVolume;
+bool probesOn = true;
+const float PROBE_SPACING = 1.5f;
+const int PROBE_UPDATES_PER_FRAME = 8;
+int editedExhibit = 0;
+glm::vec3 editStartPosition;
+
+// Object shader variants; each draw uses the one with only the features it needs
+ShaderVariants objectShaders("shaders/basic.vert", "shaders/basic.frag");
+unsigned int textureFeature = 0;
+unsigned int clusteredLightsFeature = 0;
+unsigned int shadowsFeature = 0;
+unsigned int lightmapFeature = 0;
+unsigned int probesFeature = 0;
+unsigned int gbufferFeature = 0;
+// Surface response for every object until materials are authored: roughness, metalness
+const glm::vec2 DEFAULT_MATERIAL(0.5f, 0.0f);
+
+// One mesh draw, collected first and then submitted grouped by shader variant
+struct DrawPacket {
+    unsigned int variant;
+    Mesh* mesh;
+    glm::mat4 model;
+    glm::vec3 color;
+    TextureHandle texture;
+    int lightmapChart;
+};
+std::vector<DrawPacket> drawPackets;
+
+// Depth prepass: depth from the position stream first, then shading with GL_EQUAL so
+// basic.frag runs once per pixel. The overdraw view and counter show whether it pays off.
+bool depthPrepassOn = false;
+bool overdrawViewOn = false;
+float overdrawViewMax = 8.0f;
+OverdrawView overdrawView;
+FragmentCounter shadedFragments;
+
+// Deferred path: the objects fill a G-buffer with their GBUFFER variants, then one full-screen
+// pass lights every pixel. Switchable at runtime to compare against forward shading.
+bool deferredOn = false;
+DeferredRenderer deferredRenderer;
+ShaderVariants lightingShaders("shaders/fullscreen.vert", "shaders/basic.frag");
+unsigned int deferredFeature = 0;
+unsigned int deferredClustersFeature = 0;
+unsigned int deferredShadowsFeature = 0;
+
+// Dynamic resolution: the scene is drawn smaller when the GPU misses the target frame time
+DynamicResolutionSettings dynamicResolutionSettings;
+DynamicResolution dynamicResolution;
+
+// The frame's passes and the pool their offscreen targets come from
+RenderGraph renderGraph;
+UILayer uiLayer;
+
+// Exhibit textures
+TextureManager textureManager;
+
+// Performance overlay / benchmark
+bool showPerformanceOverlay = true;
+bool validateGLState = false;
+bool streamUiGeometry = true;   // ImGui geometry through the backend's fenced ring instead of glBufferData per draw list
+bool cacheUiLayer = true;       // UI drawn into a texture kept while ImGui's output stays the same
+Benchmark benchmark;
+
+// Render thread: this thread runs input, simulation and the UI and publishes a FrameSnapshot per
+// frame; the render thread owns the GL context, draws the newest snapshot and sends back what the
+// UI shows about the renderer as a RenderFeedback. Nothing else is shared between the two.
+bool renderThreadOn = true;
+
+// Job system: --jobs counts the calling thread, so 1 runs every job on it
+int jobWorkers = JobSystem::DEFAULT_WORKERS;
+bool jobScalingBenchmark = false;
+
+struct ExhibitMove {
+    int index;
+    glm::vec3 oldPosition;
+};
+
+// Everything in a frame snapshot that decides what the frame looks like, apart from the UI
+struct SceneSnapshot {
+    int framebufferWidth, framebufferHeight;
+    glm::vec3 cameraPosition;
+    glm::mat4 view;
+    float zoom;
+    RobotPose robotPose;
+    glm::vec3 mainLightPos;
+    glm::vec3 mainLightColor;
+    bool spotLightOn;
+    glm::vec3 spotLightPos;
+    glm::vec3 spotLightDir;
+    bool trackLightsOn, shadowsOn, bakedLightingOn, probesOn;
+    bool deferredOn, depthPrepassOn, overdrawViewOn;
+    float overdrawViewMax;
+    DynamicResolutionSettings dynamicResolution;
+    std::vector<ExhibitInstance> exhibits;
+};
+
+struct FrameSnapshot : SceneSnapshot {
+    bool quit;
+    bool validateGLState;
+    bool streamUiGeometry;
+    bool cacheUiLayer;
+    int swapInterval;
+    QueueThrottle queueThrottle;
+    double inputTime;                      // when the input this frame shows was sampled
+    bool screenshot;
+    bool recording;
+    CaptureFormat captureFormat;
+    float captureFps;
+    std::vector<ExhibitMove> exhibitMoves; // editor drags finished since the previous snapshot
+    ImGuiDrawSnapshot ui;
+};
+
+bool sameExhibit(const ExhibitInstance& a, const ExhibitInstance& b) {
+    return a.position == b.position && a.scale == b.scale && a.color == b.color && a.mesh == b.mesh
+        && a.texture == b.texture && a.lightmapChart == b.lightmapChart;
+}
+
+bool sameScene(const SceneSnapshot& a, const SceneSnapshot& b) {
+    if (a.exhibits.size() != b.exhibits.size()) return false;
+    for (size_t i = 0; i < a.exhibits.size(); ++i) {
+        if (!sameExhibit(a.exhibits[i], b.exhibits[i])) return false;
+    }
+    return a.framebufferWidth == b.framebufferWidth && a.framebufferHeight == b.framebufferHeight
+        && a.cameraPosition == b.cameraPosition && a.view == b.view && a.zoom == b.zoom
+        && a.robotPose.position == b.robotPose.position && a.robotPose.orientation == b.robotPose.orientation
+        && a.robotPose.armAngle == b.robotPose.armAngle
+        && a.mainLightPos == b.mainLightPos && a.mainLightColor == b.mainLightColor
+        && a.spotLightOn == b.spotLightOn && a.spotLightPos == b.spotLightPos && a.spotLightDir == b.spotLightDir
+        && a.trackLightsOn == b.trackLightsOn && a.shadowsOn == b.shadowsOn && a.bakedLightingOn == b.bakedLightingOn
+        && a.probesOn == b.probesOn && a.deferredOn == b.deferredOn && a.depthPrepassOn == b.depthPrepassOn
+        && a.overdrawViewOn == b.overdrawViewOn && a.overdrawViewMax == b.overdrawViewMax
+        && a.dynamicResolution.enabled == b.dynamicResolution.enabled && a.dynamicResolution.targetFrameMs == b.dynamicResolution.targetFrameMs
+        && a.dynamicResolution.minScale == b.dynamicResolution.minScale && a.dynamicResolution.sharpen == b.dynamicResolution.sharpen;
+}
+
+struct RenderFeedback {
+    FrameStats frame;
+    ShadowMapStats shadows;
+    unsigned int lights, lightListEntries, maxLightsInCluster;
+    float lightAssignMs;
+    unsigned int probes, pendingProbes;
+    glm::ivec3 probeGrid;
+    float probeBakeMs;
+    bool lightmapStale;
+    float shadedFragmentsPerPixel;
+    size_t gbufferBytes;
+    RenderGraphStats renderGraph;
+    std::string renderPasses;
+    ScreenCaptureStats capture;
+    UILayerStats uiLayer;
+    float gpuFrameMs;
+    float renderScale;
+    int renderWidth, renderHeight;
+    GLStateCounters glCounters;
+    TextureManagerStats textures;
+    unsigned int shaderVariants, programsCompiling;
+    ProgramCacheStats programCache;
+    float inputLatencyMs;
+};
+
+TripleBuffer<FrameSnapshot> frameSnapshots;
+TripleBuffer<RenderFeedback> renderFeedback;
+std::vector<ExhibitMove> pendingExhibitMoves;
+
+// Latency mode: swap interval (-1 leaves the driver's default), frame limiter on this thread,
+// queue throttling on the render thread, and mouse look sampled again just before the snapshot
+int swapInterval = -1;
+float frameLimitFps = 0.0f;
+int queueThrottle = QUEUE_THROTTLE_OFF;
+bool lateLatchInput = false;
+double inputSampleTime = 0.0; // glfwGetTime() of the last event poll
+FrameLimiter frameLimiter;
+PresentQueue presentQueue;
+
+// Tour capture: F12 saves a screenshot, F9 starts and stops recording. Read back on the render thread.
+ScreenCapture screenCapture;
+bool screenshotRequested = false;
+bool recordingOn = false;
+int captureFormat = CAPTURE_PNG_SEQUENCE;
+float captureFps = 60.0f;
+
+// Idle scheduling for kiosks: frames that would repeat the one on screen are not drawn
+FrameScheduler frameScheduler;
+SceneSnapshot lastDrawnScene;
+
+// Work the renderer finishes over several frames on its own, changing the image as it goes
+bool rendererBusy(const RenderFeedback& rendered) {
+    return rendered.textures.pendingLoads > 0 || rendered.textures.uploadsLastFrame > 0
+        || rendered.programsCompiling > 0 || rendered.pendingProbes > 0 || rendered.capture.pendingReadbacks > 0;
+}
+
 
 // Callback functions
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 
-void initMuseumObjects(Mesh* cubeMesh) {
-    museumObjects.push_back({ "Statue of Hercules", "A famous Roman copy of a Greek original.", glm::vec3(-4.0f, 0.5f, -4.0f), glm::vec3(1.0f), glm::vec3(0.7f, 0.7f, 0.7f), cubeMesh, false });
-    museumObjects.push_back({ "Ancient Vase", "A well-preserved vase from 500 BC.", glm::vec3(4.0f, 0.5f, -4.0f), glm::vec3(0.5f, 1.0f, 0.5f), glm::vec3(0.8f, 0.5f, 0.2f), cubeMesh, false });
-    museumObjects.push_back({ "Sarcophagus Lid", "Detailed carvings depict scenes of mythology.", glm::vec3(-4.0f, 0.25f, 4.0f), glm::vec3(2.0f, 0.5f, 1.0f), glm::vec3(0.6f, 0.6f, 0.5f), cubeMesh, false });
-    museumObjects.push_back({ "Mosaic Panel", "A colorful mosaic showing daily life.", glm::vec3(4.0f, 1.0f, 4.0f), glm::vec3(1.5f, 1.5f, 0.2f), glm::vec3(0.5f, 0.7f, 0.8f), cubeMesh, false });
-    museumObjects.push_back({ "Gold Coin Hoard", "A collection of rare gold coins.", glm::vec3(0.0f, 0.25f, -6.0f), glm::vec3(0.5f), glm::vec3(0.9f, 0.8f, 0.2f), cubeMesh, false });
+// Keeps the catalog's search index in step with an exhibit's text.
+void indexExhibit(unsigned int index) {
+    const MuseumObject& obj = museumObjects[index];
+    exhibitIndex.set(index, obj.name + "\n" + obj.description + "\n" + obj.tags);
+}
+
+void initMuseumObjects(Mesh* cubeMesh, const GalleryLayout& layout) {
+    for (const auto& exhibit : layout.exhibits) {
+        museumObjects.push_back({ exhibit.name, exhibit.description, exhibit.tags, exhibit.position, exhibit.scale, exhibit.color, cubeMesh, false, exhibit.texturePath, 0, -1 });
+        indexExhibit(static_cast<unsigned int>(museumObjects.size() - 1));
+    }
+    floorCenter = layout.floorCenter;
+    floorSize = layout.floorSize;
+}
+
+// Shadow caster for a mesh built from the unit cube, with its world-space bounds.
+ShadowCaster makeCaster(Mesh* mesh, const glm::mat4& model) {
+    ShadowCaster caster = { mesh, model, glm::vec3(1e30f), glm::vec3(-1e30f) };
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 local((corner & 1) ? 0.5f : -0.5f, (corner & 2) ? 0.5f : -0.5f, (corner & 4) ? 0.5f : -0.5f);
+        glm::vec3 world = glm::vec3(model * glm::vec4(local, 1.0f));
+        caster.boundsMin = glm::min(caster.boundsMin, world);
+        caster.boundsMax = glm::max(caster.boundsMax, world);
+    }
+    return caster;
+}
+
+glm::mat4 exhibitModel(const ExhibitInstance& exhibit) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), exhibit.position);
+    return glm::scale(model, exhibit.scale);
+}
+
+// Per-exhibit result of the parallel cull: the serial pass that follows it turns the visible
+// ones into draw packets and texture requests, neither of which is thread-safe.
+struct ExhibitVisibility {
+    bool visible;
+    glm::mat4 model;
+    float pixelSize; // on-screen size of the largest side, for texture streaming
+};
+const int EXHIBITS_PER_JOB = 256;
+
+void cullExhibits(const std::vector<ExhibitInstance>& exhibits, const Frustum& frustum, const glm::vec3& cameraPosition,
+    float pixelsPerUnit, std::vector<ExhibitVisibility>& result) {
+    result.resize(exhibits.size());
+    JobSystem::get().parallelFor(0, static_cast<int>(exhibits.size()), EXHIBITS_PER_JOB, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            const ExhibitInstance& exhibit = exhibits[i];
+            ExhibitVisibility& visibility = result[i];
+            glm::vec3 halfExtent = exhibit.scale * 0.5f;
+            visibility.visible = frustum.intersectsBox(exhibit.position - halfExtent, exhibit.position + halfExtent);
+            if (!visibility.visible) continue;
+            visibility.model = exhibitModel(exhibit);
+            float distance = std::max(glm::distance(cameraPosition, exhibit.position), 0.1f);
+            float extent = std::max(exhibit.scale.x, std::max(exhibit.scale.y, exhibit.scale.z));
+            visibility.pixelSize = extent / distance * pixelsPerUnit;
+        }
+    });
+}
+std::vector<ExhibitVisibility> exhibitVisibility;
+
+// --job-scaling: times the exhibit cull from the start camera with 1, 2, ... up to the configured
+// number of job threads and prints the speedups, then restores the configured pool.
+void runJobScalingBenchmark(const std::vector<ExhibitInstance>& exhibits) {
+    const int REPEATS = 200;
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    Frustum frustum(projection * camera.GetViewMatrix());
+    float pixelsPerUnit = SCR_HEIGHT / (2.0f * tan(glm::radians(camera.Zoom) * 0.5f));
+    unsigned int maxThreads = JobSystem::get().threadCount();
+    std::vector<ExhibitVisibility> result;
+    double singleThreadMs = 0.0;
+    std::cout << "Job scaling, cull of " << exhibits.size() << " exhibits:" << std::endl;
+    for (unsigned int threads = 1; threads <= maxThreads; ++threads) {
+        JobSystem::get().init(static_cast<int>(threads) - 1);
+        cullExhibits(exhibits, frustum, camera.Position, pixelsPerUnit, result); // warm up
+        double start = glfwGetTime();
+        for (int i = 0; i < REPEATS; ++i) cullExhibits(exhibits, frustum, camera.Position, pixelsPerUnit, result);
+        double ms = (glfwGetTime() - start) * 1000.0 / REPEATS;
+        if (threads == 1) singleThreadMs = ms;
+        std::cout << "  " << threads << " threads: " << ms << " ms, " << singleThreadMs / ms << "x" << std::endl;
+        benchmark.setInfo("cullMs" + std::to_string(threads), std::to_string(ms));
+    }
+    JobSystem::get().init(jobWorkers);
+}
+
+void captureExhibits(std::vector<ExhibitInstance>& exhibits) {
+    exhibits.clear();
+    for (const auto& obj : museumObjects) {
+        exhibits.push_back({ obj.position, obj.scale, obj.color, obj.mesh, obj.texture, obj.lightmapChart });
+    }
+}
+
+void buildStaticCasters(const std::vector<ExhibitInstance>& exhibits) {
+    staticCasters.clear();
+    for (const auto& exhibit : exhibits) staticCasters.push_back(makeCaster(exhibit.mesh, exhibitModel(exhibit)));
+    shadowMaps.invalidateStatic();
+}
+
+// The scene the probes are baked against, built from the current exhibit positions.
+void rebuildSceneTracer(const std::vector<ExhibitInstance>& exhibits, const glm::vec3& lightPosition, const glm::vec3& lightColor) {
+    sceneTracer.clear();
+    sceneTracer.addBox(glm::scale(glm::translate(glm::mat4(1.0f), floorCenter), floorSize), glm::vec3(0.5f));
+    for (const auto& exhibit : exhibits) {
+        sceneTracer.addBox(exhibitModel(exhibit), exhibit.color);
+        sceneTracer.addLight(trackLightFor(exhibit.position));
+    }
+    sceneTracer.addLight(mainLightFor(lightPosition, lightColor));
+    sceneTracer.setEnvironment(HALL_ENVIRONMENT_RADIANCE);
+    sceneTracer.build();
+}
+
+// Exhibits dragged in the editor since the last frame: shadows and nearby probes are out of date.
+void applyExhibitMoves(const FrameSnapshot& frame) {
+    if (frame.exhibitMoves.empty()) return;
+    buildStaticCasters(frame.exhibits);
+    rebuildSceneTracer(frame.exhibits, frame.mainLightPos, frame.mainLightColor);
+    for (const auto& move : frame.exhibitMoves) {
+        const ExhibitInstance& exhibit = frame.exhibits[move.index];
+        // Its track light moves with it, so everything it could reach needs new indirect light
+        float radius = trackLightFor(exhibit.position).range + 0.5f * glm::length(exhibit.scale);
+        irradianceVolume.invalidate(move.oldPosition, radius);
+        irradianceVolume.invalidate(exhibit.position, radius);
+    }
+    lightmapStale = lightmap.isLoaded();
+}
+
+// Main thread: everything the renderer needs for this frame, plus the UI built for it.
+void captureFrame(FrameSnapshot& frame, GLFWwindow* window) {
+    frame.quit = false;
+    glfwGetFramebufferSize(window, &frame.framebufferWidth, &frame.framebufferHeight);
+    frame.cameraPosition = camera.Position;
+    frame.view = camera.GetViewMatrix();
+    frame.zoom = camera.Zoom;
+    frame.robotPose = robotRenderPose;
+    frame.mainLightPos = mainLightPos;
+    frame.mainLightColor = mainLightColor;
+    frame.spotLightOn = spotLightOn;
+    frame.spotLightPos = spotLightPos;
+    frame.spotLightDir = spotLightDir;
+    frame.trackLightsOn = trackLightsOn;
+    frame.shadowsOn = shadowsOn;
+    frame.bakedLightingOn = bakedLightingOn;
+    frame.probesOn = probesOn;
+    frame.deferredOn = deferredOn;
+    frame.depthPrepassOn = depthPrepassOn;
+    frame.overdrawViewOn = overdrawViewOn;
+    frame.overdrawViewMax = overdrawViewMax;
+    frame.dynamicResolution = dynamicResolutionSettings;
+    frame.validateGLState = validateGLState;
+    frame.streamUiGeometry = streamUiGeometry;
+    frame.cacheUiLayer = cacheUiLayer;
+    frame.swapInterval = swapInterval;
+    frame.queueThrottle = static_cast<QueueThrottle>(queueThrottle);
+    frame.inputTime = inputSampleTime;
+    frame.screenshot = screenshotRequested;
+    screenshotRequested = false;
+    frame.recording = recordingOn;
+    frame.captureFormat = static_cast<CaptureFormat>(captureFormat);
+    frame.captureFps = captureFps;
+    captureExhibits(frame.exhibits);
+    frame.exhibitMoves.swap(pendingExhibitMoves);
+    pendingExhibitMoves.clear();
+    frame.ui.capture(ImGui::GetDrawData());
+}
+
+// Render thread: the renderer's counters for the UI of a later frame.
+void publishFeedback(const FrameSnapshot& frame) {
+    int renderWidth = dynamicResolution.renderWidth(), renderHeight = dynamicResolution.renderHeight();
+    RenderFeedback& feedback = renderFeedback.writeSlot();
+    feedback.frame = RenderStats::get().lastFrame();
+    feedback.shadows = shadowMaps.stats();
+    feedback.lights = clusteredLighting.lightCount();
+    feedback.lightListEntries = clusteredLighting.assignedIndices();
+    feedback.maxLightsInCluster = clusteredLighting.maxLightsInCluster();
+    feedback.lightAssignMs = clusteredLighting.assignMilliseconds();
+    feedback.probes = irradianceVolume.probeCount();
+    feedback.pendingProbes = irradianceVolume.pendingProbes();
+    feedback.probeGrid = irradianceVolume.gridSize();
+    feedback.probeBakeMs = irradianceVolume.bakeMilliseconds();
+    feedback.lightmapStale = lightmapStale;
+    feedback.shadedFragmentsPerPixel = shadedFragments.samples() / static_cast<float>(std::max(1, renderWidth * renderHeight));
+    bool deferredFrame = frame.deferredOn && !frame.overdrawViewOn;
+    feedback.gbufferBytes = deferredFrame ? DeferredRenderer::gbufferBytes(frame.framebufferWidth, frame.framebufferHeight) : 0;
+    feedback.renderGraph = renderGraph.stats();
+    feedback.renderPasses = renderGraph.describe();
+    feedback.capture = screenCapture.stats();
+    feedback.uiLayer = uiLayer.stats();
+    feedback.gpuFrameMs = dynamicResolution.gpuMilliseconds();
+    feedback.renderScale = dynamicResolution.scale();
+    feedback.renderWidth = renderWidth;
+    feedback.renderHeight = renderHeight;
+    feedback.glCounters = GLState::get().frameCounters();
+    feedback.textures = textureManager.stats();
+    feedback.shaderVariants = static_cast<unsigned int>(objectShaders.variantCount());
+    feedback.programsCompiling = ShaderCompiler::get().pendingCount();
+    feedback.programCache = ProgramCache::get().stats();
+    feedback.inputLatencyMs = presentQueue.latencyMs();
+    renderFeedback.publish();
+}
+
+// Variant for an object's features. G-buffer variants fall back to the plain G-buffer program,
+// since the forward fallback doesn't write the G-buffer targets.
+unsigned int resolveObjectVariant(unsigned int features) {
+    if (!(features & gbufferFeature)) return objectShaders.resolve(features);
+    if (objectShaders.isReady(features)) return features;
+    objectShaders.request(features);
+    return gbufferFeature;
+}
+
+// Every packet through a position-only shader (depth prepass, overdraw count).
+void drawPacketGeometry(Shader& shader, const glm::mat4& projection, const glm::mat4& view) {
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    for (const auto& packet : drawPackets) packet.mesh->DrawGeometry(shader, packet.model);
 }
 
 void initRobot(Mesh* bodyMesh, Mesh* armMesh) {
@@ -104,6 +627,43 @@ void initRobot(Mesh* bodyMesh, Mesh* armMesh) {
     robot.autoMode = false;
     robot.returningHome = false;
     robot.moveSpeed = 2.0f;
+    robot.previousPose = { robot.position, robot.orientation, robot.armAngle };
+    robotRenderPose = robot.previousPose;
+}
+
+// Pose alpha of the way from the previous tick to the current one; turns take the short way round.
+RobotPose interpolateRobotPose(float alpha) {
+    const RobotPose& from = robot.previousPose;
+    float turn = std::remainder(robot.orientation - from.orientation, glm::two_pi<float>());
+    return { glm::mix(from.position, robot.position, alpha), from.orientation + turn * alpha,
+        glm::mix(from.armAngle, robot.armAngle, alpha) };
+}
+
+glm::mat4 robotBodyModel(const RobotPose& pose) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, pose.position);
+    model = glm::rotate(model, pose.orientation, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.8f)); // Robot body size
+    return model;
+}
+
+// Arm (simple rotating cylinder/cube on top)
+glm::mat4 robotArmModel(const RobotPose& pose) {
+    glm::mat4 armModel = glm::mat4(1.0f);
+    armModel = glm::translate(armModel, pose.position + glm::vec3(0.0f, 0.3f, 0.0f)); // Position arm on top of body
+    armModel = glm::rotate(armModel, pose.orientation, glm::vec3(0.0f, 1.0f, 0.0f)); // Align with body
+    armModel = glm::rotate(armModel, pose.armAngle, glm::vec3(1.0f, 0.0f, 0.0f)); // Arm "scan" rotation
+    armModel = glm::translate(armModel, glm::vec3(0.0f, 0.0f, 0.3f)); // Offset arm forward
+    armModel = glm::scale(armModel, glm::vec3(0.1f, 0.1f, 0.6f)); // Arm size
+    return armModel;
+}
+
+void startAutomaticTour() {
+    robot.autoMode = true;
+    robot.returningHome = false;
+    robot.currentTargetObjectIndex = 0; // Start with the first object
+    for (auto& obj : museumObjects) obj.scanned = false; // Reset scanned status
+    currentScannedObjectIndex = -1;
 }
 
 // Function to make robot move towards a target
@@ -168,9 +728,180 @@ void moveRobot(float dt) {
     }
 }
 
+// One fixed simulation tick.
+void simulationTick() {
+    robot.previousPose = { robot.position, robot.orientation, robot.armAngle };
+    if (robot.autoMode || robot.returningHome || robot.currentTargetObjectIndex != -1) {
+        moveRobot(SIMULATION_STEP);
+    }
+}
+
+// Draws the robot alpha of the way through the current tick, with the spotlight following it.
+void followRobot(float alpha) {
+    robotRenderPose = interpolateRobotPose(alpha);
+    // Update spotlight to be on the robot's arm or front
+    spotLightPos = robotRenderPose.position + glm::vec3(0, 0.5f, 0); // Above robot
+    float robotFrontX = sin(robotRenderPose.orientation);
+    float robotFrontZ = cos(robotRenderPose.orientation);
+    spotLightDir = glm::normalize(glm::vec3(robotFrontX, -0.5f, robotFrontZ)); // Pointing forward and slightly down
+}
+
+// Length of the automatic tour, found by running it tick by tick; the robot and the exhibits'
+// scanned flags are put back afterwards.
+float measureTourSeconds(float limitSeconds) {
+    Robot savedRobot = robot;
+    int savedScannedIndex = currentScannedObjectIndex;
+    std::vector<bool> savedScanned;
+    for (const auto& obj : museumObjects) savedScanned.push_back(obj.scanned);
+
+    startAutomaticTour();
+    int ticks = 0;
+    int maxTicks = static_cast<int>(limitSeconds / SIMULATION_STEP);
+    while ((robot.autoMode || robot.returningHome) && ticks < maxTicks) {
+        simulationTick();
+        ticks++;
+    }
+
+    robot = savedRobot;
+    currentScannedObjectIndex = savedScannedIndex;
+    for (size_t i = 0; i < museumObjects.size(); ++i) museumObjects[i].scanned = savedScanned[i];
+    return ticks * SIMULATION_STEP;
+}
+
+// Batch coordinator: runs this executable once per frame range and waits for the workers. They
+// share the cores, so each gets its share of job and encoder threads; --jobs counts the worker's
+// own thread, so a share of one core runs its jobs inline rather than starting a pool.
+int coordinateBatch(const BatchSettings& settings, int argc, char** argv) {
+    float seconds = settings.seconds;
+    if (seconds <= 0.0f && !settings.timelinePath.empty()) {
+        CameraTimeline timeline;
+        std::string error;
+        if (!timeline.load(settings.timelinePath, error)) {
+            std::cerr << "ERROR::BATCH::TIMELINE " << error << std::endl;
+            return 1;
+        }
+        seconds = timeline.duration();
+    }
+    if (seconds <= 0.0f) seconds = measureTourSeconds(MAX_TOUR_SECONDS);
+    unsigned int frameCount = std::max(1u, static_cast<unsigned int>(std::ceil(seconds * settings.fps)));
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int workerCount = settings.workers > 0 ? settings.workers : std::min(cores, MAX_DEFAULT_BATCH_WORKERS);
+    std::vector<BatchRange> ranges = splitBatchFrames(frameCount, workerCount);
+    unsigned int threadsPerWorker = std::max(1u, cores / static_cast<unsigned int>(ranges.size()));
+
+    std::string arguments = quoteBatchArgument(argv[0]);
+    for (int i = 1; i < argc; ++i) arguments += " " + quoteBatchArgument(argv[i]);
+    arguments += " --batch-seconds " + std::to_string(seconds) + " --jobs " + std::to_string(threadsPerWorker)
+        + " --capture-encoders " + std::to_string(threadsPerWorker);
+    std::vector<std::string> commands;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        commands.push_back(arguments + " --batch-worker " + std::to_string(ranges[i].first) + " "
+            + std::to_string(ranges[i].count) + " " + std::to_string(i));
+    }
+    std::cout << "Batch: " << frameCount << " frames (" << seconds << " s at " << settings.fps << " FPS, "
+        << settings.width << "x" << settings.height << ") on " << ranges.size() << " workers" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!runBatchWorkers(commands)) {
+        std::cerr << "ERROR::BATCH::WORKER_FAILED" << std::endl;
+        return 1;
+    }
+    if (settings.y4m) {
+        std::vector<std::string> segments;
+        for (size_t i = 0; i < ranges.size(); ++i) segments.push_back(batchSegmentName(settings.outputDirectory, static_cast<unsigned int>(i)) + ".y4m");
+        std::string error;
+        if (!joinY4mSegments(segments, settings.outputDirectory + "/tour.y4m", error)) {
+            std::cerr << "ERROR::BATCH::JOIN " << error << std::endl;
+            return 1;
+        }
+        for (const auto& segment : segments) std::remove(segment.c_str());
+    }
+    float wallSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Batch done in " << wallSeconds << " s, " << seconds / std::max(wallSeconds, 0.001f)
+        << "x real time" << std::endl;
+    return 0;
+}
+
+// Sends the robot to an exhibit and scans it again on arrival.
+void visitExhibit(int index) {
+    robot.autoMode = false;
+    robot.returningHome = false;
+    robot.currentTargetObjectIndex = index;
+    currentScannedObjectIndex = -1; // Clear previous scan info until new scan
+    museumObjects[index].scanned = false; // Allow re-scan
+}
+
+void searchCatalog() {
+    double start = glfwGetTime();
+    catalogComplete = exhibitIndex.search(catalogQuery, MAX_CATALOG_RESULTS, catalogResults);
+    catalogSearchMs = static_cast<float>((glfwGetTime() - start) * 1000.0);
+}
 
-void renderUI() {
-    ImGui_ImplOpenGL3_NewFrame();
+// Every exhibit, or the ones matching the search, as a list of which only the visible rows are
+// laid out, so it stays fast with hundreds of thousands of exhibits.
+void buildExhibitCatalog() {
+    ImGui::SetNextWindowSize(ImVec2(360.0f, 420.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Exhibit Catalog", &showCatalog)) {
+        ImGui::End();
+        return;
+    }
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::InputTextWithHint("##search", "Search names, descriptions and tags", catalogQuery, sizeof(catalogQuery))) searchCatalog();
+    bool filtered = catalogQuery[0] != '\0';
+    int rows = static_cast<int>(filtered ? catalogResults.size() : museumObjects.size());
+    if (filtered) {
+        ImGui::Text("%d%s matches in %.3f ms", rows, catalogComplete ? "" : "+", catalogSearchMs);
+        if (!catalogComplete) ImGui::TextWrapped("Showing the first %d, type more to narrow the search.", rows);
+    }
+    else {
+        ImGui::Text("%d exhibits", rows);
+    }
+
+    ImGui::BeginChild("##exhibits");
+    ImGuiListClipper clipper;
+    clipper.Begin(rows);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            int index = filtered ? static_cast<int>(catalogResults[row]) : row;
+            const MuseumObject& obj = museumObjects[index];
+            ImGui::PushID(index);
+            if (ImGui::Selectable(obj.name.c_str(), robot.currentTargetObjectIndex == index)) visitExhibit(index);
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s\n%s", obj.description.c_str(), obj.tags.c_str());
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
+
+// Small always-on-top window with frame time and the workload counters of the last rendered frame.
+void buildPerformanceOverlay(const RenderFeedback& rendered) {
+    const FrameStats& stats = rendered.frame;
+    ImGuiIO& io = ImGui::GetIO();
+    ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10.0f, 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.35f);
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings
+        | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+    if (ImGui::Begin("Performance Overlay", &showPerformanceOverlay, flags)) {
+        ImGui::Text("%.2f ms (%.0f FPS)", 1000.0f / io.Framerate, io.Framerate);
+        ImGui::Separator();
+        ImGui::Text("Draw calls: %u (%u instances)", stats.drawCalls, stats.instances);
+        ImGui::Text("Triangles: %llu", stats.triangles);
+        ImGui::Text("Uniform uploads: %u", stats.uniformUploads);
+        ImGui::Text("Buffer uploads: %llu bytes", stats.bufferBytesUploaded);
+        ImGui::Text("Switches: %u program, %u VAO, %u texture", stats.programSwitches, stats.vaoSwitches, stats.textureSwitches);
+        ImGui::Text("Objects: %u submitted, %u culled", stats.objectsSubmitted, stats.objectsCulled);
+        ImGui::Text("Lights: %u (assignment %.2f ms)", rendered.lights, rendered.lightAssignMs);
+        ImGui::Text("Input to present: %.1f ms", rendered.inputLatencyMs);
+        ImGui::Text("GPU: %.2f ms, scene %dx%d (%.0f%%)", rendered.gpuFrameMs, rendered.renderWidth, rendered.renderHeight,
+            rendered.renderScale * 100.0f);
+        if (benchmark.isRunning()) ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Benchmark running");
+    }
+    ImGui::End();
+}
+
+// Builds this frame's UI; the render thread draws it from the frame snapshot.
+void buildUI(const RenderFeedback& rendered) {
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
@@ -181,15 +912,41 @@ void renderUI() {
         ImGui::ColorEdit3("Main Light Color", glm::value_ptr(mainLightColor));
         ImGui::DragFloat3("Main Light Position", glm::value_ptr(mainLightPos), 0.1f);
         ImGui::Checkbox("Spotlight On/Off", &spotLightOn);
+        ImGui::Checkbox("Track Lights On/Off", &trackLightsOn);
+        ImGui::Checkbox("Shadows", &shadowsOn);
+        if (lightmap.isLoaded()) {
+            ImGui::Checkbox("Baked lighting", &bakedLightingOn);
+            ImGui::Text("Lightmap: %ux%u", lightmap.width(), lightmap.height());
+        }
+        else {
+            ImGui::Text("Lightmap: not baked (run the bake tool)");
+        }
+        const ShadowMapStats& shadowStats = rendered.shadows;
+        ImGui::Text("Shadow tiles: %u (%u static, %u dynamic updates, %u caster draws)", shadowStats.shadows,
+            shadowStats.staticRenders, shadowStats.dynamicRenders, shadowStats.casterDraws);
+        ImGui::Text("Clustered lights: %u (%u list entries, max %u per cluster)", rendered.lights,
+            rendered.lightListEntries, rendered.maxLightsInCluster);
+        ImGui::Text("Light assignment: %.3f ms", rendered.lightAssignMs);
+    }
+
+    if (ImGui::CollapsingHeader("Exhibit Editor")) {
+        ImGui::SliderInt("Exhibit", &editedExhibit, 0, static_cast<int>(museumObjects.size()) - 1);
+        MuseumObject& edited = museumObjects[editedExhibit];
+        ImGui::Text("%s", edited.name.c_str());
+        glm::vec3 before = edited.position;
+        ImGui::DragFloat3("Position", glm::value_ptr(edited.position), 0.05f);
+        if (ImGui::IsItemActivated()) editStartPosition = before;
+        if (ImGui::IsItemDeactivatedAfterEdit()) pendingExhibitMoves.push_back({ editedExhibit, editStartPosition });
+        ImGui::Checkbox("Irradiance probes", &probesOn);
+        const glm::ivec3& probeGrid = rendered.probeGrid;
+        ImGui::Text("Probes: %u (%dx%dx%d), baked in %.0f ms, %u queued", rendered.probes,
+            probeGrid.x, probeGrid.y, probeGrid.z, rendered.probeBakeMs, rendered.pendingProbes);
+        if (rendered.lightmapStale) ImGui::Text("Lightmap is out of date, run the bake tool again");
     }
 
     if (ImGui::CollapsingHeader("Robot Control")) {
         if (ImGui::Button("Start Automatic Tour (1-5 & Return)")) {
-            robot.autoMode = true;
-            robot.returningHome = false;
-            robot.currentTargetObjectIndex = 0; // Start with the first object
-            for (auto& obj : museumObjects) obj.scanned = false; // Reset scanned status
-            currentScannedObjectIndex = -1;
+            startAutomaticTour();
         }
         if (ImGui::Button("Stop Robot / Return Home")) {
             robot.autoMode = false;
@@ -197,28 +954,104 @@ void renderUI() {
             robot.currentTargetObjectIndex = -1; // No specific object target
         }
 
-        ImGui::Text("Manual Object Selection:");
-        for (int i = 0; i < museumObjects.size(); ++i) {
-            if (ImGui::Button(museumObjects[i].name.c_str())) {
-                robot.autoMode = false;
-                robot.returningHome = false;
-                robot.currentTargetObjectIndex = i;
-                currentScannedObjectIndex = -1; // Clear previous scan info until new scan
-                museumObjects[i].scanned = false; // Allow re-scan
-            }
-        }
+        ImGui::Checkbox("Exhibit catalog (manual object selection)", &showCatalog);
         ImGui::Text("Robot Position: (%.2f, %.2f, %.2f)", robot.position.x, robot.position.y, robot.position.z);
         ImGui::SliderFloat("Robot Arm Angle (Debug)", &robot.armAngle, 0.0f, glm::radians(90.0f));
+        ImGui::Text("Simulation: %.0f Hz, %d ticks this frame", 1.0f / SIMULATION_STEP, simulationStepsLastFrame);
 
     }
     if (ImGui::CollapsingHeader("Camera Control")) {
         ImGui::Text(mouseCaptured ? "Mouse Captured (Press M to release)" : "Mouse Released (Press M to capture)");
         ImGui::Text("Use WASDQE for movement, Mouse to look.");
     }
+    if (ImGui::CollapsingHeader("Capture")) {
+        if (ImGui::Button("Screenshot (F12)")) screenshotRequested = true;
+        ImGui::SameLine();
+        if (ImGui::Button(recordingOn ? "Stop recording (F9)" : "Record (F9)")) recordingOn = !recordingOn;
+        ImGui::Combo("Format", &captureFormat, "PNG sequence\0Y4M video\0");
+        ImGui::SliderFloat("Capture FPS", &captureFps, 24.0f, 60.0f, "%.0f");
+        const ScreenCaptureStats& captureStats = rendered.capture;
+        ImGui::Text("Frames: %u captured, %u written, %u dropped", captureStats.capturedFrames,
+            captureStats.writtenFrames, captureStats.droppedFrames);
+        ImGui::Text("Readback: %.2f ms, %u in flight, %u encoding", captureStats.readbackMs,
+            captureStats.pendingReadbacks, captureStats.queuedFrames);
+    }
+    if (ImGui::CollapsingHeader("Performance")) {
+        ImGui::Checkbox("Deferred shading", &deferredOn);
+        if (deferredOn) ImGui::Text("G-buffer: %.1f MB", rendered.gbufferBytes / (1024.0f * 1024.0f));
+        ImGui::Checkbox("Depth prepass", &depthPrepassOn);
+        ImGui::Checkbox("Dynamic resolution", &dynamicResolutionSettings.enabled);
+        if (dynamicResolutionSettings.enabled) {
+            float targetFps = 1000.0f / dynamicResolutionSettings.targetFrameMs;
+            if (ImGui::SliderFloat("Target GPU FPS", &targetFps, 20.0f, 144.0f, "%.0f")) dynamicResolutionSettings.targetFrameMs = 1000.0f / targetFps;
+            ImGui::SliderFloat("Minimum scale", &dynamicResolutionSettings.minScale, 0.25f, 1.0f, "%.2f");
+            ImGui::Checkbox("Sharpen upscale", &dynamicResolutionSettings.sharpen);
+        }
+        ImGui::Checkbox("Overdraw heat map", &overdrawViewOn);
+        if (overdrawViewOn) ImGui::SliderFloat("Heat map max", &overdrawViewMax, 2.0f, 16.0f, "%.0f");
+        ImGui::Text("Shaded fragments: %.2f per pixel", rendered.shadedFragmentsPerPixel);
+        const RenderGraphStats& graphStats = rendered.renderGraph;
+        ImGui::Text("Render graph: %u passes, %u culled", graphStats.passes, graphStats.culledPasses);
+        ImGui::Text("Targets: %u in %u textures, %.1f MB peak (%.1f MB unaliased), pool %.1f MB", graphStats.transientTargets,
+            graphStats.physicalTargets, graphStats.peakTransientBytes / (1024.0f * 1024.0f),
+            graphStats.unaliasedBytes / (1024.0f * 1024.0f), graphStats.poolBytes / (1024.0f * 1024.0f));
+        if (ImGui::TreeNode("Passes")) {
+            ImGui::TextUnformatted(rendered.renderPasses.c_str());
+            ImGui::TreePop();
+        }
+        const GLStateCounters& counters = rendered.glCounters;
+        ImGui::Text("GL state calls: %u issued, %u elided", counters.totalIssued(), counters.totalElided());
+        ImGui::Text("Program binds: %u issued, %u elided", counters.issued[GLSTATE_PROGRAM], counters.elided[GLSTATE_PROGRAM]);
+        ImGui::Text("VAO binds: %u issued, %u elided", counters.issued[GLSTATE_VERTEX_ARRAY], counters.elided[GLSTATE_VERTEX_ARRAY]);
+        ImGui::Text("Texture binds: %u issued, %u elided", counters.issued[GLSTATE_TEXTURE], counters.elided[GLSTATE_TEXTURE]);
+        const TextureManagerStats& textureStats = rendered.textures;
+        ImGui::Text("Textures: %u, %.1f / %.1f MB resident, %u loads pending", textureStats.textures,
+            textureStats.residentBytes / (1024.0f * 1024.0f), textureStats.budgetBytes / (1024.0f * 1024.0f), textureStats.pendingLoads);
+        ImGui::Text("Shader variants: %u, %u programs compiling%s", rendered.shaderVariants,
+            rendered.programsCompiling, GLExtensions::parallelShaderCompile ? " (parallel)" : "");
+        const ProgramCacheStats& programStats = rendered.programCache;
+        if (ProgramCache::get().enabled()) {
+            ImGui::Text("Program cache: %.0f%% hit rate (%u/%u), %u rejected", programStats.hitRate() * 100.0f,
+                programStats.hits, programStats.hits + programStats.misses, programStats.rejected);
+            ImGui::Text("Startup: %.1f ms loading, %.1f ms compiling, %.1f ms saved", programStats.loadMs, programStats.compileMs, programStats.savedMs);
+        }
+        else {
+            ImGui::Text("Program cache: off, %.1f ms compiling", programStats.compileMs);
+        }
+        if (fontAtlasStats.cached) {
+            ImGui::Text("Font atlas: %dx%d, %u glyphs, loaded from the cache in %.1f ms", fontAtlasStats.width,
+                fontAtlasStats.height, fontAtlasStats.glyphs, fontAtlasStats.buildMs);
+        }
+        else {
+            ImGui::Text("Font atlas: %dx%d, %u glyphs, baked in %u chunks in %.1f ms", fontAtlasStats.width,
+                fontAtlasStats.height, fontAtlasStats.glyphs, fontAtlasStats.bakeJobs, fontAtlasStats.buildMs);
+        }
+        ImGui::Checkbox("Show performance overlay", &showPerformanceOverlay);
+        ImGui::Checkbox("Validate GL state shadow", &validateGLState);
+        ImGui::Checkbox("Stream UI geometry", &streamUiGeometry);
+        ImGui::Checkbox("Cache UI layer", &cacheUiLayer);
+        if (cacheUiLayer) {
+            ImGui::SameLine();
+            ImGui::Text("%u redrawn, %u reused", rendered.uiLayer.redrawnFrames, rendered.uiLayer.cachedFrames);
+        }
+        ImGui::Separator();
+        int swapChoice = swapInterval + 1;
+        if (ImGui::Combo("Swap interval", &swapChoice, "Driver default\0Off\0Every refresh\0Every 2nd refresh\0")) swapInterval = swapChoice - 1;
+        ImGui::SliderFloat("Frame limit", &frameLimitFps, 0.0f, 240.0f, frameLimitFps > 0.0f ? "%.0f FPS" : "off");
+        ImGui::Combo("Queue throttle", &queueThrottle, "Off\0Fence (1 frame)\0glFinish\0");
+        ImGui::Checkbox("Late-latch mouse look", &lateLatchInput);
+        ImGui::Separator();
+        bool idleOn = frameScheduler.isEnabled();
+        if (ImGui::Checkbox("Sleep while nothing changes", &idleOn)) frameScheduler.setEnabled(idleOn);
+        ImGui::Text("Frames: %llu drawn, %llu skipped", frameScheduler.drawnFrames(), frameScheduler.skippedFrames());
+    }
 
 
     ImGui::End();
 
+    if (showPerformanceOverlay) buildPerformanceOverlay(rendered);
+    if (showCatalog) buildExhibitCatalog();
+
     // Object Information Pop-up
     if (currentScannedObjectIndex != -1 && museumObjects[currentScannedObjectIndex].scanned) {
         ImGui::Begin("Object Information", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
@@ -232,11 +1065,157 @@ void renderUI() {
     }
 
     ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
+const char* firstExistingFile(const char* const* paths, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (std::ifstream(paths[i]).good()) return paths[i];
+    }
+    return nullptr;
+}
+
+void addUiFonts(ImFontAtlas& atlas) {
+    const char* path = firstExistingFile(UI_FONT_FILES, sizeof(UI_FONT_FILES) / sizeof(UI_FONT_FILES[0]));
+    if (!path) {
+        atlas.AddFontDefault();
+        return;
+    }
+    atlas.AddFontFromFileTTF(path, UI_FONT_SIZE, nullptr, UI_FONT_RANGES);
+    const char* arabicPath = firstExistingFile(UI_ARABIC_FONT_FILES, sizeof(UI_ARABIC_FONT_FILES) / sizeof(UI_ARABIC_FONT_FILES[0]));
+    if (arabicPath) {
+        ImFontConfig config;
+        config.MergeMode = true;
+        atlas.AddFontFromFileTTF(arabicPath, UI_FONT_SIZE, &config, UI_ARABIC_RANGES);
+    }
 }
 
 
-int main() {
+int main(int argc, char** argv) {
+    // Command line: --benchmark [seconds] runs the automatic tour and writes a JSON report.
+    float benchmarkSeconds = 0.0f;
+    std::string benchmarkOutput = "benchmark.json";
+    size_t textureBudgetMB = 512;
+    int stressExhibits = 0;
+    std::string programCacheDirectory = "shadercache";
+    std::string fontCacheDirectory = "fontcache";
+    std::string lightmapPath;
+    std::string captureDirectory = "captures";
+    unsigned int captureEncoders = 0;
+    BatchSettings batch;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--benchmark") {
+            benchmarkSeconds = 30.0f;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchmarkSeconds = static_cast<float>(atof(argv[++i]));
+        }
+        else if (arg == "--benchmark-out" && i + 1 < argc) {
+            benchmarkOutput = argv[++i];
+        }
+        else if (arg == "--texture-budget-mb" && i + 1 < argc) {
+            textureBudgetMB = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if (arg == "--no-program-cache") {
+            programCacheDirectory.clear();
+        }
+        else if (arg == "--no-font-cache") {
+            fontCacheDirectory.clear();
+        }
+        else if (arg == "--stress" && i + 1 < argc) {
+            stressExhibits = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--depth-prepass") {
+            depthPrepassOn = true;
+        }
+        else if (arg == "--dynamic-resolution" && i + 1 < argc) {
+            dynamicResolutionSettings.enabled = true;
+            dynamicResolutionSettings.targetFrameMs = 1000.0f / std::max(1.0f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (arg == "--deferred") {
+            deferredOn = true;
+        }
+        else if (arg == "--no-render-thread") {
+            renderThreadOn = false;
+        }
+        else if (arg == "--no-idle") {
+            frameScheduler.setEnabled(false);
+        }
+        else if (arg == "--swap-interval" && i + 1 < argc) {
+            swapInterval = std::max(-1, atoi(argv[++i]));
+        }
+        else if (arg == "--fps-limit" && i + 1 < argc) {
+            frameLimitFps = std::max(0.0f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (arg == "--throttle" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            queueThrottle = mode == "finish" ? QUEUE_THROTTLE_FINISH : mode == "fence" ? QUEUE_THROTTLE_FENCE : QUEUE_THROTTLE_OFF;
+        }
+        else if (arg == "--late-latch") {
+            lateLatchInput = true;
+        }
+        else if (arg == "--low-latency") {
+            queueThrottle = QUEUE_THROTTLE_FENCE;
+            lateLatchInput = true;
+        }
+        else if (arg == "--jobs" && i + 1 < argc) {
+            jobWorkers = std::max(1, atoi(argv[++i])) - 1;
+        }
+        else if (arg == "--job-scaling") {
+            jobScalingBenchmark = true;
+        }
+        else if (arg == "--capture-dir" && i + 1 < argc) {
+            captureDirectory = argv[++i];
+        }
+        else if (arg == "--capture-encoders" && i + 1 < argc) {
+            captureEncoders = static_cast<unsigned int>(std::max(1, atoi(argv[++i])));
+        }
+        else if (arg == "--capture-fps" && i + 1 < argc) {
+            captureFps = std::max(1.0f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (arg == "--record" && i + 1 < argc) {
+            // Records from the first frame, e.g. with --benchmark to capture the tour
+            std::string format = argv[++i];
+            captureFormat = format == "y4m" ? CAPTURE_Y4M : CAPTURE_PNG_SEQUENCE;
+            recordingOn = true;
+        }
+        else if (arg == "--batch-render" && i + 1 < argc) {
+            batch.outputDirectory = argv[++i];
+        }
+        else if (arg == "--batch-size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &batch.width, &batch.height) != 2) batch.width = batch.height = 0;
+            batch.width = std::max(16, batch.width);
+            batch.height = std::max(16, batch.height);
+        }
+        else if (arg == "--batch-fps" && i + 1 < argc) {
+            batch.fps = std::max(1.0f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (arg == "--batch-seconds" && i + 1 < argc) {
+            batch.seconds = std::max(0.0f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (arg == "--batch-workers" && i + 1 < argc) {
+            batch.workers = static_cast<unsigned int>(std::max(1, atoi(argv[++i])));
+        }
+        else if (arg == "--batch-timeline" && i + 1 < argc) {
+            batch.timelinePath = argv[++i];
+        }
+        else if (arg == "--batch-format" && i + 1 < argc) {
+            batch.y4m = std::string(argv[++i]) == "y4m";
+        }
+        else if (arg == "--batch-worker" && i + 3 < argc) {
+            // Added by the coordinator: first frame, frame count, segment number
+            batch.worker = true;
+            batch.range.first = static_cast<unsigned int>(std::max(0, atoi(argv[++i])));
+            batch.range.count = static_cast<unsigned int>(std::max(0, atoi(argv[++i])));
+            batch.segment = static_cast<unsigned int>(std::max(0, atoi(argv[++i])));
+        }
+        else if (arg == "--lightmap" && i + 1 < argc) {
+            lightmapPath = argv[++i];
+        }
+    }
+
+    // Batch rendering draws offscreen and on this thread only
+    bool batchRender = !batch.outputDirectory.empty();
+    if (batchRender) renderThreadOn = false;
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
@@ -250,6 +1229,7 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+    if (batchRender) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Virtual Museum Assignment", nullptr, nullptr);
     if (window == nullptr) {
         std::cerr << "Failed to create GLFW window\n";
@@ -257,10 +1237,15 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetKeyCallback(window, key_callback);
+    // The rest only wake the frame scheduler; ImGui chains its own callbacks onto these
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { frameScheduler.markDirty(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { frameScheduler.markDirty(); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { frameScheduler.markDirty(); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { frameScheduler.markDirty(); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { frameScheduler.markDirty(); });
 
     // Capture mouse cursor
     if (mouseCaptured) {
@@ -273,10 +1258,37 @@ int main() {
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
-
-    // Build and compile our shader program
-    Shader objectShader("shaders/basic.vert", "shaders/basic.frag");
+    GLExtensions::init((GLADloadproc)glfwGetProcAddress);
+    JobSystem::get().init(jobWorkers);
+    ProgramCache::get().init(programCacheDirectory);
+    ShaderCompiler::get().init();
+    GLState& glState = GLState::get();
+    glState.enable(GL_DEPTH_TEST);
+
+    // Build our shader programs: the plain variant now as the fallback, every other keyword
+    // combination in the background while the first frames render with it
+    textureFeature = objectShaders.addKeyword("USE_TEXTURE");
+    clusteredLightsFeature = objectShaders.addKeyword("CLUSTERED_LIGHTS");
+    shadowsFeature = objectShaders.addKeyword("SHADOWS");
+    lightmapFeature = objectShaders.addKeyword("LIGHTMAP");
+    probesFeature = objectShaders.addKeyword("IRRADIANCE_PROBES");
+    gbufferFeature = objectShaders.addKeyword("GBUFFER");
+    objectShaders.setFallback(0);
+    for (unsigned int mask = 1; mask <= (textureFeature | clusteredLightsFeature | shadowsFeature | lightmapFeature | probesFeature); ++mask) {
+        if ((mask & lightmapFeature) && (mask & probesFeature)) continue; // an object uses one or the other
+        objectShaders.request(mask);
+    }
+    // The deferred path's programs are only built once it is first switched on
+    deferredFeature = lightingShaders.addKeyword("DEFERRED");
+    deferredClustersFeature = lightingShaders.addKeyword("CLUSTERED_LIGHTS");
+    deferredShadowsFeature = lightingShaders.addKeyword("SHADOWS");
+    Shader shadowShader("shaders/shadow.vert", "shaders/shadow.frag");
+    Shader depthShader("shaders/depth.vert", "shaders/depth.frag");
+    Shader overdrawShader("shaders/depth.vert", "shaders/overdraw.frag");
+    Shader heatmapShader("shaders/fullscreen.vert", "shaders/overdraw_heatmap.frag");
+    Shader upscaleShader("shaders/fullscreen.vert", "shaders/upscale.frag");
+    Shader uiCompositeShader("shaders/fullscreen.vert", "shaders/ui_composite.frag");
+    bool shaderStartupReported = false;
 
     // Setup Mesh data (using the hardcoded cube)
     std::vector<float> cubeVertexData(cubeVertices, cubeVertices + sizeof(cubeVertices) / sizeof(float));
@@ -286,109 +1298,607 @@ int main() {
     // Room (a large cube acting as the floor/walls)
     Mesh roomMesh(cubeVertexData); // Using cube for simplicity
 
-    initMuseumObjects(&cubeMesh);
+    initMuseumObjects(&cubeMesh, buildGalleryLayout(stressExhibits));
+
+    // Exhibit textures: only the mip tails are uploaded here, the rest streams in on demand
+    unsigned int textureWorkers = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+    if (batch.worker) textureWorkers = std::min(textureWorkers, JobSystem::get().threadCount());
+    textureManager.init(textureBudgetMB * 1024 * 1024, textureWorkers);
+    screenCapture.init(captureEncoders, batchRender ? batch.outputDirectory : captureDirectory);
+    for (auto& obj : museumObjects) {
+        if (!obj.texturePath.empty()) obj.texture = textureManager.load(obj.texturePath);
+    }
     initRobot(&cubeMesh, &cubeMesh); // Using cube for robot body and arm for now
 
+    // Baked lighting is optional: the default file is only loaded if the bake tool has written it
+    bool explicitLightmap = !lightmapPath.empty();
+    if (!explicitLightmap) {
+        lightmapPath = stressExhibits > 0 ? "lightmaps/museum_stress" + std::to_string(stressExhibits) + ".lightmap" : "lightmaps/museum.lightmap";
+    }
+    if ((explicitLightmap || std::ifstream(lightmapPath.c_str()).good()) && lightmap.load(lightmapPath)) {
+        floorLightmapChart = lightmap.chartIndex("Floor");
+        for (auto& obj : museumObjects) obj.lightmapChart = lightmap.chartIndex(obj.name);
+    }
+
+    clusteredLighting.init();
+    shadowMaps.init();
+    std::vector<ExhibitInstance> exhibits;
+    captureExhibits(exhibits);
+    buildStaticCasters(exhibits);
+
+    // Probe grid from just above the floor to under the track lights
+    rebuildSceneTracer(exhibits, mainLightPos, mainLightColor);
+    glm::vec3 probesMin = floorCenter - 0.5f * floorSize;
+    glm::vec3 probesMax = floorCenter + 0.5f * floorSize;
+    probesMin.y = floorCenter.y + 0.5f * floorSize.y + 0.25f;
+    probesMax.y = 3.5f;
+    irradianceVolume.init(probesMin, probesMax, PROBE_SPACING, sceneTracer);
+    if (jobScalingBenchmark) runJobScalingBenchmark(exhibits);
+
     ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    ImGuiIO& io = ImGui::GetIO();
     ImGui::StyleColorsDark();
+    addUiFonts(*io.Fonts);
+    buildFontAtlas(*io.Fonts, fontCacheDirectory, fontAtlasStats);
 
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
+    ImGui_ImplOpenGL3_SetBackupState(false); // GLState re-establishes the scene state each frame
+    ImGui_ImplOpenGL3_CreateDeviceObjects();  // uploads the font atlas while this thread still has the context
+    validateGLState = glState.validationEnabled();
+
+    if (benchmarkSeconds > 0.0f) {
+        benchmark.setInfo("scene", "museum");
+        benchmark.setInfo("exhibits", std::to_string(museumObjects.size()));
+        benchmark.setInfo("depthPrepass", depthPrepassOn ? "on" : "off");
+        benchmark.setInfo("renderPath", deferredOn ? "deferred" : "forward");
+        benchmark.setInfo("renderThread", renderThreadOn ? "on" : "off");
+        benchmark.setInfo("idleScheduler", frameScheduler.isEnabled() ? "on" : "off");
+        benchmark.setInfo("swapInterval", std::to_string(swapInterval));
+        benchmark.setInfo("fpsLimit", std::to_string(frameLimitFps));
+        benchmark.setInfo("queueThrottle", std::to_string(queueThrottle));
+        benchmark.setInfo("lateLatch", lateLatchInput ? "on" : "off");
+        benchmark.setInfo("jobThreads", std::to_string(JobSystem::get().threadCount()));
+        benchmark.setInfo("programCacheHitRate", std::to_string(ProgramCache::get().stats().hitRate()));
+        benchmark.start(benchmarkSeconds, benchmarkOutput);
+        startAutomaticTour();
+    }
 
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        processInput(window);
-
-        // Update robot movement/logic
-        if (robot.autoMode || robot.returningHome || robot.currentTargetObjectIndex != -1) {
-            moveRobot(deltaTime);
+    // Draws one snapshot; runs on whichever thread owns the GL context
+    auto renderFrame = [&](FrameSnapshot& frame) {
+        // ImGui leaves blending and scissoring on and depth testing off; put the scene state back.
+        glState.beginFrame();
+        RenderStats::get().beginFrame();
+        if (frame.validateGLState != glState.validationEnabled()) glState.setValidation(frame.validateGLState);
+        applyExhibitMoves(frame);
+        dynamicResolution.beginFrame(frame.dynamicResolution, frame.framebufferWidth, frame.framebufferHeight);
+        if (!batchRender) {
+            if (frame.recording && !screenCapture.isRecording()) screenCapture.startRecording(frame.captureFormat, frame.captureFps);
+            else if (!frame.recording && screenCapture.isRecording()) screenCapture.stopRecording();
+            if (frame.screenshot) screenCapture.screenshot();
         }
-        // Update spotlight to be on the robot's arm or front
-        spotLightPos = robot.position + glm::vec3(0, 0.5f, 0); // Above robot
-        float robotFrontX = sin(robot.orientation);
-        float robotFrontZ = cos(robot.orientation);
-        spotLightDir = glm::normalize(glm::vec3(robotFrontX, -0.5f, robotFrontZ)); // Pointing forward and slightly down
 
+        // Track lights above each exhibit plus the robot's spotlight
+        galleryLights.clear();
+        if (frame.trackLightsOn) {
+            for (const auto& obj : frame.exhibits) galleryLights.push_back(trackLightFor(obj.position));
+        }
+        if (frame.spotLightOn) {
+            GalleryLight light;
+            light.position = frame.spotLightPos;
+            light.direction = frame.spotLightDir;
+            light.color = glm::vec3(1.0f, 1.0f, 0.8f); // Yellowish spotlight
+            light.range = 10.0f;
+            light.cosInnerCutOff = glm::cos(glm::radians(12.5f));
+            light.cosOuterCutOff = glm::cos(glm::radians(17.5f));
+            light.shadowIndex = -1;
+            galleryLights.push_back(light);
+        }
 
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // The frame is a render graph: passes declare what they read and write, passes nothing
+        // reads from are culled (the overdraw view needs neither shadows nor light lists), and the
+        // offscreen targets come from the graph's pool
+        int fbWidth = frame.framebufferWidth, fbHeight = frame.framebufferHeight;
+        // The scene has its own resolution, below the window's while dynamic resolution scales it down
+        int renderWidth = dynamicResolution.renderWidth(), renderHeight = dynamicResolution.renderHeight();
+        renderGraph.reset();
+        renderGraph.setBackbufferClear(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+        RenderGraph::Resource shadowAtlas = renderGraph.importExternal("Shadow atlas");
+        RenderGraph::Resource lightLists = renderGraph.importExternal("Light lists");
+        glState.enable(GL_DEPTH_TEST);
+        glState.disable(GL_BLEND);
+        glState.disable(GL_SCISSOR_TEST);
+
+        glm::mat4 projection = glm::perspective(glm::radians(frame.zoom), (float)fbWidth / (float)std::max(fbHeight, 1), 0.1f, 100.0f);
+        glm::mat4 view = frame.view;
+
+        // Shadow maps go first, they use their own framebuffers and viewports
+        int mainLightShadow = -1;
+        if (frame.shadowsOn) {
+            int shadowPass = renderGraph.addPass("Shadows", 0, 0, [&](RenderGraph&) {
+                // Main light: a downward projection wide enough for the whole floor
+                float floorAngle = 0.0f, floorDistance = 0.0f;
+                for (int corner = 0; corner < 4; ++corner) {
+                    glm::vec3 point = floorCenter + glm::vec3((corner & 1) ? 0.5f : -0.5f, 0.0f, (corner & 2) ? 0.5f : -0.5f) * floorSize;
+                    glm::vec3 toPoint = point - frame.mainLightPos;
+                    floorAngle = std::max(floorAngle, glm::degrees(std::acos(glm::clamp(-toPoint.y / glm::length(toPoint), -1.0f, 1.0f))));
+                    floorDistance = std::max(floorDistance, glm::length(toPoint));
+                }
+                shadowMaps.requestShadow(MAIN_LIGHT_SHADOW_KEY, frame.mainLightPos, glm::vec3(0.0f, -1.0f, 0.0f),
+                    glm::clamp(2.0f * floorAngle + 5.0f, 30.0f, 140.0f), floorDistance + 1.0f, 2, 2);
+                if (frame.spotLightOn) {
+                    shadowMaps.requestShadow(ROBOT_SPOT_SHADOW_KEY, frame.spotLightPos, frame.spotLightDir, 2.0f * 17.5f + 4.0f, 10.0f, 1, 1);
+                }
+                // Track lights are static, so after their first render only the robot passing by costs anything
+                std::vector<std::pair<float, unsigned int> > nearestTrackLights;
+                if (frame.trackLightsOn) {
+                    for (unsigned int i = 0; i < frame.exhibits.size(); ++i) {
+                        nearestTrackLights.push_back(std::make_pair(glm::distance(frame.cameraPosition, galleryLights[i].position), i));
+                    }
+                    size_t count = std::min<size_t>(MAX_TRACK_LIGHT_SHADOWS, nearestTrackLights.size());
+                    std::partial_sort(nearestTrackLights.begin(), nearestTrackLights.begin() + count, nearestTrackLights.end());
+                    nearestTrackLights.resize(count);
+                    for (const auto& nearest : nearestTrackLights) {
+                        const GalleryLight& light = galleryLights[nearest.second];
+                        shadowMaps.requestShadow(TRACK_LIGHT_SHADOW_KEY + nearest.second, light.position, light.direction,
+                            2.0f * TRACK_LIGHT_OUTER_DEGREES + 4.0f, light.range, 1, 4);
+                    }
+                }
 
-        objectShader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        objectShader.setMat4("projection", projection);
-        objectShader.setMat4("view", view);
-        objectShader.setVec3("viewPos", camera.Position);
+                dynamicCasters.clear();
+                dynamicCasters.push_back(makeCaster(robot.bodyMesh, robotBodyModel(frame.robotPose)));
+                dynamicCasters.push_back(makeCaster(robot.armMesh, robotArmModel(frame.robotPose)));
+                shadowMaps.render(shadowShader, staticCasters, dynamicCasters);
 
-        // Main light properties
-        objectShader.setVec3("lightPos", mainLightPos);
-        objectShader.setVec3("lightColor", mainLightColor);
+                mainLightShadow = shadowMaps.shadowIndex(MAIN_LIGHT_SHADOW_KEY);
+                for (const auto& nearest : nearestTrackLights) {
+                    galleryLights[nearest.second].shadowIndex = shadowMaps.shadowIndex(TRACK_LIGHT_SHADOW_KEY + nearest.second);
+                }
+                if (frame.spotLightOn) galleryLights.back().shadowIndex = shadowMaps.shadowIndex(ROBOT_SPOT_SHADOW_KEY);
+            });
+            renderGraph.write(shadowPass, shadowAtlas);
+        }
 
-        // Spotlight properties
-        objectShader.setVec3("spotLightPos", spotLightPos);
-        objectShader.setVec3("spotLightDir", spotLightDir);
-        objectShader.setFloat("spotLightCutOff", glm::cos(glm::radians(12.5f)));
-        objectShader.setFloat("spotLightOuterCutOff", glm::cos(glm::radians(17.5f)));
-        objectShader.setVec3("spotLightColor", glm::vec3(1.0f, 1.0f, 0.8f)); // Yellowish spotlight
-        objectShader.setBool("spotLightOn", spotLightOn);
+        // The light lists carry each light's shadow index, so they wait for the shadows
+        int lightPass = renderGraph.addPass("Light assignment", 0, 0, [&](RenderGraph&) {
+            clusteredLighting.update(galleryLights, view, projection, 0.1f, 100.0f, renderWidth, renderHeight);
+        });
+        if (frame.shadowsOn) renderGraph.read(lightPass, shadowAtlas);
+        renderGraph.write(lightPass, lightLists);
+
+        // Pick up finished programs; draws whose variant is still compiling use the fallback
+        ShaderCompiler::get().update();
+        if (!shaderStartupReported && ShaderCompiler::get().pendingCount() == 0) {
+            const ProgramCacheStats& programStats = ProgramCache::get().stats();
+            std::cout << "Shaders ready after " << glfwGetTime() << " s. Program cache: " << programStats.hits << " hits, "
+                << programStats.misses << " misses (" << programStats.rejected << " rejected), saved " << programStats.savedMs << " ms" << std::endl;
+            shaderStartupReported = true;
+        }
 
+        // Only pay for the cluster loop when there is something in it, and for shadow lookups when they're on
+        unsigned int lightingFeatures = galleryLights.empty() ? 0u : clusteredLightsFeature;
+        if (frame.shadowsOn) lightingFeatures |= shadowsFeature;
+        bool bakedLighting = frame.bakedLightingOn && lightmap.isLoaded();
+        irradianceVolume.update(sceneTracer, PROBE_UPDATES_PER_FRAME);
+        unsigned int probeLighting = (frame.probesOn && irradianceVolume.isReady()) ? probesFeature : 0u;
+        // The overdraw view counts forward fragments, so it always takes the forward path
+        bool deferredFrame = frame.deferredOn && !frame.overdrawViewOn;
+        unsigned int lightingVariant = 0;
+        if (deferredFrame) {
+            if (!lightingShaders.isReady(deferredFeature)) {
+                objectShaders.get(gbufferFeature); // fallback of the G-buffer variants
+                lightingShaders.setFallback(deferredFeature);
+            }
+            // Lights are evaluated once per pixel in the lighting pass, not per object
+            lightingVariant = lightingShaders.resolve(deferredFeature |
+                ((lightingFeatures & clusteredLightsFeature) ? deferredClustersFeature : 0u) |
+                ((lightingFeatures & shadowsFeature) ? deferredShadowsFeature : 0u));
+            lightingFeatures = gbufferFeature;
+        }
+        drawPackets.clear();
 
         // Render the room (a large flattened cube as floor, and optionally walls)
         glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -0.5f, 0.0f)); // Floor position
-        model = glm::scale(model, glm::vec3(20.0f, 0.1f, 20.0f)); // Large floor
-        roomMesh.Draw(objectShader, model, glm::vec3(0.5f, 0.5f, 0.5f), mainLightPos, camera.Position, mainLightColor);
+        model = glm::translate(model, floorCenter); // Floor position
+        model = glm::scale(model, floorSize); // Large floor
+        bool floorBaked = bakedLighting && floorLightmapChart >= 0;
+        drawPackets.push_back({ resolveObjectVariant(lightingFeatures | (floorBaked ? lightmapFeature : probeLighting)), &roomMesh, model,
+            glm::vec3(0.5f, 0.5f, 0.5f), 0, floorLightmapChart });
         // TODO: Add walls for the room
 
-        // Render museum objects
-        for (const auto& obj : museumObjects) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.position);
-            model = glm::scale(model, obj.scale);
-            obj.mesh->Draw(objectShader, model, obj.color, mainLightPos, camera.Position, mainLightColor);
+        // Render museum objects that intersect the view frustum
+        Frustum frustum(projection * view);
+        float pixelsPerUnit = renderHeight / (2.0f * tan(glm::radians(frame.zoom) * 0.5f)); // at distance 1
+        cullExhibits(frame.exhibits, frustum, frame.cameraPosition, pixelsPerUnit, exhibitVisibility);
+        unsigned int culledObjects = 0;
+        for (size_t i = 0; i < frame.exhibits.size(); ++i) {
+            const ExhibitInstance& obj = frame.exhibits[i];
+            const ExhibitVisibility& visibility = exhibitVisibility[i];
+            if (!visibility.visible) {
+                culledObjects++;
+                continue;
+            }
+            if (obj.texture) textureManager.requestResolution(obj.texture, visibility.pixelSize);
+            unsigned int features = lightingFeatures | (textureManager.isLoaded(obj.texture) ? textureFeature : 0u);
+            features |= (bakedLighting && obj.lightmapChart >= 0) ? lightmapFeature : probeLighting;
+            drawPackets.push_back({ resolveObjectVariant(features), obj.mesh, visibility.model, obj.color, obj.texture, obj.lightmapChart });
         }
+        RenderStats::get().recordObjects(static_cast<unsigned int>(frame.exhibits.size()) - culledObjects, culledObjects);
 
         // Render robot
-        // Body
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, robot.position);
-        model = glm::rotate(model, robot.orientation, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.8f)); // Robot body size
-        robot.bodyMesh->Draw(objectShader, model, glm::vec3(0.2f, 0.2f, 0.8f), mainLightPos, camera.Position, mainLightColor);
-
-        // Arm (simple rotating cylinder/cube on top)
-        glm::mat4 armModel = glm::mat4(1.0f);
-        armModel = glm::translate(armModel, robot.position + glm::vec3(0.0f, 0.3f, 0.0f)); // Position arm on top of body
-        armModel = glm::rotate(armModel, robot.orientation, glm::vec3(0.0f, 1.0f, 0.0f)); // Align with body
-        armModel = glm::rotate(armModel, robot.armAngle, glm::vec3(1.0f, 0.0f, 0.0f)); // Arm "scan" rotation
-        armModel = glm::translate(armModel, glm::vec3(0.0f, 0.0f, 0.3f)); // Offset arm forward
-        armModel = glm::scale(armModel, glm::vec3(0.1f, 0.1f, 0.6f)); // Arm size
-        robot.armMesh->Draw(objectShader, armModel, glm::vec3(0.1f, 0.5f, 0.1f), mainLightPos, camera.Position, mainLightColor);
-
-
-        // Render ImGui UI
-        renderUI();
+        drawPackets.push_back({ resolveObjectVariant(lightingFeatures | probeLighting), robot.bodyMesh, robotBodyModel(frame.robotPose), glm::vec3(0.2f, 0.2f, 0.8f), 0, -1 });
+        drawPackets.push_back({ resolveObjectVariant(lightingFeatures | probeLighting), robot.armMesh, robotArmModel(frame.robotPose), glm::vec3(0.1f, 0.5f, 0.1f), 0, -1 });
+
+        // Submit grouped by variant so each program is bound and set up once per frame
+        std::stable_sort(drawPackets.begin(), drawPackets.end(),
+            [](const DrawPacket& a, const DrawPacket& b) { return a.variant < b.variant; });
+
+        // Scene targets: the window itself, or window-sized targets the scene fills part of
+        bool scaling = dynamicResolution.isScaling();
+        RenderGraph::Resource sceneColor = scaling ? renderGraph.createTarget("Scene color", DynamicResolution::sceneColorDesc(fbWidth, fbHeight)) : RenderGraph::BACKBUFFER;
+        RenderGraph::Resource geometryDepth;
+        RenderGraph::Resource overdrawCount = RenderGraph::BACKBUFFER;
+        RenderGraph::Resource gbuffer[DeferredRenderer::TARGET_COUNT];
+        if (frame.overdrawViewOn) {
+            overdrawCount = renderGraph.createTarget("Overdraw count", OverdrawView::countDesc(fbWidth, fbHeight));
+            geometryDepth = renderGraph.createTarget("Overdraw depth", RenderTargetDesc::depth(fbWidth, fbHeight));
+        }
+        else if (deferredFrame) {
+            const char* const names[DeferredRenderer::TARGET_COUNT] = { "G-buffer albedo", "G-buffer normal", "G-buffer indirect" };
+            for (int i = 0; i < DeferredRenderer::TARGET_COUNT; ++i) {
+                gbuffer[i] = renderGraph.createTarget(names[i], DeferredRenderer::targetDesc(i, fbWidth, fbHeight));
+            }
+            geometryDepth = renderGraph.createTarget("G-buffer depth", RenderTargetDesc::depth(fbWidth, fbHeight));
+        }
+        else {
+            geometryDepth = scaling ? renderGraph.createTarget("Scene depth", RenderTargetDesc::depth(fbWidth, fbHeight)) : RenderGraph::BACKBUFFER;
+        }
 
+        if (frame.depthPrepassOn) {
+            int prepass = renderGraph.addPass("Depth prepass", renderWidth, renderHeight, [&](RenderGraph&) {
+                glState.colorMask(false, false, false, false);
+                drawPacketGeometry(depthShader, projection, view);
+                glState.colorMask(true, true, true, true);
+            });
+            renderGraph.write(prepass, geometryDepth);
+        }
+        // Shades the packets into the bound targets, testing against the prepass depth if there is one
+        auto drawScene = [&]() {
+            if (frame.depthPrepassOn) {
+                glState.depthMask(false);
+                glState.depthFunc(GL_EQUAL);
+            }
+            shadedFragments.begin();
+            Shader* shader = nullptr;
+            // The overdraw view replaces shading with a fragment count under the same depth state
+            if (frame.overdrawViewOn) drawPacketGeometry(overdrawShader, projection, view);
+            for (size_t i = 0; i < drawPackets.size() && !frame.overdrawViewOn; ++i) {
+                const DrawPacket& packet = drawPackets[i];
+                if (i == 0 || packet.variant != drawPackets[i - 1].variant) {
+                    shader = &objectShaders.get(packet.variant);
+                    shader->use();
+                    shader->setMat4("projection", projection);
+                    shader->setMat4("view", view);
+                    shader->setVec2("material", DEFAULT_MATERIAL);
+                    if (packet.variant & clusteredLightsFeature) clusteredLighting.apply(*shader);
+                    if (packet.variant & textureFeature) shader->setInt("diffuseMap", 0);
+                    if (packet.variant & shadowsFeature) {
+                        shadowMaps.apply(*shader);
+                        shader->setInt("mainLightShadow", mainLightShadow);
+                    }
+                    if (packet.variant & lightmapFeature) lightmap.apply(*shader);
+                    if (packet.variant & probesFeature) irradianceVolume.apply(*shader);
+                }
+                if (packet.variant & textureFeature) textureManager.bind(packet.texture, 0);
+                if (packet.variant & lightmapFeature) shader->setVec4Array("lightmapRects", lightmap.faceRects(packet.lightmapChart), LIGHTMAP_FACES);
+                packet.mesh->Draw(*shader, packet.model, packet.color, frame.mainLightPos, frame.cameraPosition, frame.mainLightColor);
+            }
+            shadedFragments.end();
+            glState.depthFunc(GL_LESS);
+            glState.depthMask(true);
+        };
+
+        if (frame.overdrawViewOn) {
+            int countPass = renderGraph.addPass("Overdraw count", renderWidth, renderHeight, [&](RenderGraph&) {
+                overdrawView.beginCount();
+                drawScene();
+                overdrawView.endCount();
+            });
+            if (frame.depthPrepassOn) renderGraph.read(countPass, geometryDepth);
+            renderGraph.write(countPass, overdrawCount);
+            renderGraph.write(countPass, geometryDepth);
+            int heatMapPass = renderGraph.addPass("Overdraw heat map", renderWidth, renderHeight, [&](RenderGraph& graph) {
+                overdrawView.drawHeatMap(heatmapShader, frame.overdrawViewMax, graph.texture(overdrawCount));
+            });
+            renderGraph.read(heatMapPass, overdrawCount);
+            renderGraph.write(heatMapPass, sceneColor);
+        }
+        else if (deferredFrame) {
+            int geometryPass = renderGraph.addPass("G-buffer", renderWidth, renderHeight, [&](RenderGraph&) { drawScene(); });
+            if (frame.depthPrepassOn) renderGraph.read(geometryPass, geometryDepth);
+            for (int i = 0; i < DeferredRenderer::TARGET_COUNT; ++i) renderGraph.write(geometryPass, gbuffer[i]);
+            renderGraph.write(geometryPass, geometryDepth);
+            int lightingPass = renderGraph.addPass("Deferred lighting", renderWidth, renderHeight, [&](RenderGraph& graph) {
+                Shader& lightingShader = lightingShaders.get(lightingVariant);
+                lightingShader.use();
+                lightingShader.setVec3("lightColor", frame.mainLightColor);
+                lightingShader.setVec3("lightPos", frame.mainLightPos);
+                lightingShader.setVec3("viewPos", frame.cameraPosition);
+                if (lightingVariant & deferredClustersFeature) clusteredLighting.apply(lightingShader);
+                if (lightingVariant & deferredShadowsFeature) {
+                    shadowMaps.apply(lightingShader);
+                    lightingShader.setInt("mainLightShadow", mainLightShadow);
+                }
+                GLuint targets[DeferredRenderer::TARGET_COUNT];
+                for (int i = 0; i < DeferredRenderer::TARGET_COUNT; ++i) targets[i] = graph.texture(gbuffer[i]);
+                deferredRenderer.light(lightingShader, projection, view, targets, graph.texture(geometryDepth));
+            });
+            for (int i = 0; i < DeferredRenderer::TARGET_COUNT; ++i) renderGraph.read(lightingPass, gbuffer[i]);
+            renderGraph.read(lightingPass, geometryDepth);
+            renderGraph.read(lightingPass, lightLists);
+            if (frame.shadowsOn) renderGraph.read(lightingPass, shadowAtlas);
+            renderGraph.write(lightingPass, sceneColor);
+        }
+        else {
+            int forwardPass = renderGraph.addPass("Forward", renderWidth, renderHeight, [&](RenderGraph&) { drawScene(); });
+            if (frame.depthPrepassOn) renderGraph.read(forwardPass, geometryDepth);
+            renderGraph.read(forwardPass, lightLists);
+            if (frame.shadowsOn) renderGraph.read(forwardPass, shadowAtlas);
+            renderGraph.write(forwardPass, sceneColor);
+            if (geometryDepth != sceneColor) renderGraph.write(forwardPass, geometryDepth);
+        }
+
+        // Scale the scene up, then the UI goes on top at the window's resolution
+        if (scaling) {
+            int upscalePass = renderGraph.addPass("Upscale", fbWidth, fbHeight, [&](RenderGraph& graph) {
+                dynamicResolution.upscale(upscaleShader, graph.texture(sceneColor));
+            });
+            renderGraph.read(upscalePass, sceneColor);
+            renderGraph.write(upscalePass, RenderGraph::BACKBUFFER);
+        }
+        // Capture reads the finished scene back, so recordings and screenshots leave out the UI
+        if (screenCapture.isActive() && !batchRender) {
+            int capturePass = renderGraph.addPass("Capture", 0, 0, [&](RenderGraph&) {
+                screenCapture.capture(fbWidth, fbHeight, glfwGetTime());
+            });
+            renderGraph.read(capturePass, RenderGraph::BACKBUFFER);
+            renderGraph.write(capturePass, RenderGraph::BACKBUFFER);
+        }
+        int uiPass = renderGraph.addPass("UI", fbWidth, fbHeight, [&](RenderGraph&) {
+            // The frame's own bookkeeping ends here: the ImGui backend changes state behind GLState's back
+            dynamicResolution.endFrame();
+            textureManager.update();
+            glState.endFrame();
+            RenderStats::get().endFrame();
+            ImGui_ImplOpenGL3_SetStreamingBuffer(frame.streamUiGeometry);
+            ImDrawData* drawData = frame.ui.drawData();
+            if (!frame.cacheUiLayer) {
+                uiLayer.shutdown();
+                if (drawData) ImGui_ImplOpenGL3_RenderDrawData(drawData);
+                // The backend no longer restores what it touched, so our shadow is stale from here on.
+                glState.invalidate();
+            }
+            else if (drawData) {
+                if (uiLayer.beginRedraw(frame.ui.hash(), fbWidth, fbHeight)) {
+                    ImGui_ImplOpenGL3_RenderDrawData(drawData);
+                    glState.invalidate();
+                    glState.bindFramebuffer(GL_FRAMEBUFFER, renderGraph.backbuffer());
+                    glState.viewport(0, 0, fbWidth, fbHeight);
+                }
+                uiLayer.composite(uiCompositeShader);
+            }
+        });
+        renderGraph.write(uiPass, RenderGraph::BACKBUFFER);
+
+        renderGraph.execute();
+        publishFeedback(frame);
+    };
+
+    // Takes the newest snapshot and draws it; false once the main loop has asked to quit.
+    int appliedSwapInterval = -1;
+    auto renderLatest = [&]() -> bool {
+        if (!frameSnapshots.acquire()) return true;
+        FrameSnapshot& frame = frameSnapshots.readSlot();
+        if (frame.quit) return false;
+        if (frame.swapInterval != appliedSwapInterval && frame.swapInterval >= 0) glfwSwapInterval(frame.swapInterval);
+        appliedSwapInterval = frame.swapInterval;
+        renderFrame(frame);
         glfwSwapBuffers(window);
+        presentQueue.afterSwap(frame.queueThrottle, frame.inputTime);
+        return true;
+    };
+
+    // Batch worker: draws its frames into an offscreen target and reads each one back once its
+    // textures and shaders are ready, so nothing depends on how fast this process happens to run
+    auto renderBatchFrames = [&]() -> int {
+        CameraTimeline timeline;
+        std::string error;
+        if (!batch.timelinePath.empty() && !timeline.load(batch.timelinePath, error)) {
+            std::cerr << "ERROR::BATCH::TIMELINE " << error << std::endl;
+            return 1;
+        }
+        GLuint targets[2], framebuffer;
+        glGenRenderbuffers(2, targets);
+        glBindRenderbuffer(GL_RENDERBUFFER, targets[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, batch.width, batch.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, targets[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, batch.width, batch.height);
+        glGenFramebuffers(1, &framebuffer);
+        glState.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, targets[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets[1]);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "ERROR::BATCH::FRAMEBUFFER_INCOMPLETE" << std::endl;
+            return 1;
+        }
+        renderGraph.setBackbuffer(framebuffer);
+        screenCapture.setSource(framebuffer);
+        screenCapture.setDropFrames(false);
+        screenCapture.startRecording(batch.y4m ? CAPTURE_Y4M : CAPTURE_PNG_SEQUENCE, batch.fps,
+            batch.y4m ? batchSegmentName(batch.outputDirectory, batch.segment) : batch.outputDirectory + "/tour", batch.range.first);
+
+        // Every worker replays the same ticks from the start of the tour, so frame f sees the same
+        // simulation state whichever worker draws it
+        startAutomaticTour();
+        long long ticks = 0;
+        FrameSnapshot frame;
+        for (unsigned int f = batch.range.first; f < batch.range.first + batch.range.count; ++f) {
+            double time = f / static_cast<double>(batch.fps);
+            double tickTime = time / SIMULATION_STEP;
+            long long targetTicks = static_cast<long long>(std::floor(tickTime + 1e-6));
+            for (; ticks < targetTicks; ++ticks) simulationTick();
+            followRobot(static_cast<float>(std::max(0.0, tickTime - targetTicks)));
+
+            captureFrame(frame, window);
+            frame.framebufferWidth = batch.width;
+            frame.framebufferHeight = batch.height;
+            frame.dynamicResolution.enabled = false;
+            glm::vec3 position, target;
+            float fov = ZOOM;
+            if (!timeline.empty()) {
+                timeline.evaluate(static_cast<float>(time), position, target, fov);
+            }
+            else {
+                // Behind and above the robot, looking past it
+                glm::vec3 forward(sin(robotRenderPose.orientation), 0.0f, cos(robotRenderPose.orientation));
+                position = robotRenderPose.position - forward * 3.0f + glm::vec3(0.0f, 1.8f, 0.0f);
+                target = robotRenderPose.position + forward * 1.5f + glm::vec3(0.0f, 0.3f, 0.0f);
+            }
+            frame.cameraPosition = position;
+            frame.view = glm::lookAt(position, target, glm::vec3(0.0f, 1.0f, 0.0f));
+            frame.zoom = fov;
+
+            for (int settle = 0; settle < MAX_SETTLE_RENDERS; ++settle) {
+                renderFrame(frame);
+                if (textureManager.stats().pendingLoads == 0 && ShaderCompiler::get().pendingCount() == 0
+                    && irradianceVolume.pendingProbes() == 0) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            screenCapture.capture(batch.width, batch.height, (f - batch.range.first) / static_cast<double>(batch.fps));
+            if ((f - batch.range.first) % 60 == 59) {
+                std::cout << "Batch worker " << batch.segment << ": " << f - batch.range.first + 1 << "/" << batch.range.count << std::endl;
+            }
+        }
+        screenCapture.stopRecording(); // the encoders finish in shutdown()
+        renderGraph.setBackbuffer(0);
+        screenCapture.setSource(0);
+        glState.deleteFramebuffer(framebuffer);
+        glDeleteRenderbuffers(2, targets);
+        return 0;
+    };
+    int exitCode = 0;
+    if (batchRender) {
+        exitCode = batch.worker ? renderBatchFrames() : coordinateBatch(batch, argc, argv);
+        glfwSetWindowShouldClose(window, true);
+    }
+
+    // From here on the render thread owns the GL context
+    std::thread renderThread;
+    if (renderThreadOn) {
+        glfwMakeContextCurrent(nullptr);
+        renderThread = std::thread([&]() {
+            glfwMakeContextCurrent(window);
+            do {
+                frameSnapshots.waitUntilPublished();
+            } while (renderLatest());
+            glfwMakeContextCurrent(nullptr);
+        });
+    }
+
+    // Main loop
+    while (!glfwWindowShouldClose(window)) {
+        frameLimiter.wait(frameLimitFps);
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // deltaTime is the duration of the previous frame; the render thread's latest counters go with it.
+        renderFeedback.acquire();
+        if (benchmark.isRunning() && benchmark.recordFrame(deltaTime, renderFeedback.readSlot().frame)) {
+            glfwSetWindowShouldClose(window, true);
+        }
+
+        processInput(window);
+
+        // Update robot movement/logic in fixed ticks, then draw it between the last two
+        simulationAccumulator += deltaTime;
+        simulationStepsLastFrame = 0;
+        while (simulationAccumulator >= SIMULATION_STEP && simulationStepsLastFrame < MAX_SIMULATION_STEPS) {
+            simulationTick();
+            simulationAccumulator -= SIMULATION_STEP;
+            simulationStepsLastFrame++;
+        }
+        simulationAccumulator = std::fmod(simulationAccumulator, SIMULATION_STEP); // time dropped after a long hitch
+        followRobot(simulationAccumulator / SIMULATION_STEP);
+
+        buildUI(renderFeedback.readSlot());
+
+        // A frame that would look like the one on screen isn't drawn: the loop sleeps until an
+        // event or the timeout instead, and the window keeps showing the last presented frame.
+        FrameSnapshot& frame = frameSnapshots.writeSlot();
+        if (lateLatchInput) {
+            // Mouse look moved while this frame was simulated and its UI built; take it into the view
+            glfwPollEvents();
+            inputSampleTime = glfwGetTime();
+        }
+        captureFrame(frame, window);
+        bool sceneChanged = !sameScene(frame, lastDrawnScene) || !frame.exhibitMoves.empty()
+            || benchmark.isRunning() || ImGui::GetIO().WantTextInput // text cursor blinks
+            || frame.recording || frame.screenshot;
+        if (!frameScheduler.shouldDraw(sceneChanged, rendererBusy(renderFeedback.readSlot()))) {
+            glfwWaitEventsTimeout(FRAME_IDLE_WAIT_SECONDS);
+            inputSampleTime = glfwGetTime();
+            lastFrame = static_cast<float>(glfwGetTime()); // the sleep doesn't count as frame time
+            continue;
+        }
+        lastDrawnScene = frame;
+
+        // Hand the frame over once the renderer has taken the previous one, so this thread works
+        // on frame N+1 while frame N is drawn
+        frameSnapshots.waitUntilRead();
+        frameSnapshots.publish();
+        if (!renderThreadOn) renderLatest();
         glfwPollEvents();
+        inputSampleTime = glfwGetTime();
+    }
+
+    if (renderThread.joinable()) {
+        frameSnapshots.writeSlot().quit = true;
+        frameSnapshots.waitUntilRead();
+        frameSnapshots.publish();
+        renderThread.join();
+        glfwMakeContextCurrent(window);
     }
 
+    textureManager.shutdown();
+    screenCapture.shutdown();
+    presentQueue.shutdown();
+    clusteredLighting.shutdown();
+    shadowMaps.shutdown();
+    lightmap.shutdown();
+    shadedFragments.shutdown();
+    lightingShaders.clear();
+    GLState::get().deleteProgram(depthShader.ID);
+    GLState::get().deleteProgram(overdrawShader.ID);
+    GLState::get().deleteProgram(heatmapShader.ID);
+    GLState::get().deleteProgram(upscaleShader.ID);
+    GLState::get().deleteProgram(uiCompositeShader.ID);
+    uiLayer.shutdown();
+    dynamicResolution.shutdown();
+    renderGraph.shutdown();
+    irradianceVolume.shutdown();
+    GLState::get().deleteProgram(shadowShader.ID);
+    objectShaders.clear();
+    GLState::get().shutdown();
+
     // Cleanup ImGui
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
     glfwTerminate();
-    return 0;
-}
-
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    JobSystem::get().shutdown();
+    return exitCode;
 }
 
 void processInput(GLFWwindow* window) {
@@ -412,6 +1922,9 @@ void processInput(GLFWwindow* window) {
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    frameScheduler.markDirty();
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS) screenshotRequested = true;
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS) recordingOn = !recordingOn;
     if (key == GLFW_KEY_M && action == GLFW_PRESS) {
         mouseCaptured = !mouseCaptured;
         if (mouseCaptured) {
@@ -426,6 +1939,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
+    frameScheduler.markDirty(); // also ImGui hover
     if (!mouseCaptured) return; // Only process if mouse is captured
 
     float xpos = static_cast<float>(xposIn);
@@ -448,6 +1962,7 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+    frameScheduler.markDirty();
     if (!ImGui::GetIO().WantCaptureMouse && mouseCaptured) { // Only process if ImGui doesn't want mouse and captured
         camera.ProcessMouseScroll(static_cast<float>(yoffset));
     }
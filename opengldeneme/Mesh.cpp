@@ -1,31 +1,53 @@
 // Mesh.cpp
 #include "Mesh.h"
+#include "GLState.h"
+#include "RenderStats.h"
 
 Mesh::Mesh(const std::vector<float>& vertexData) : vertices(vertexData) {
     setupMesh();
 }
 
 Mesh::~Mesh() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    GLState::get().deleteVertexArray(VAO);
+    GLState::get().deleteBuffer(VBO);
+    GLState::get().deleteVertexArray(positionVAO);
+    GLState::get().deleteBuffer(positionVBO);
 }
 
 void Mesh::setupMesh() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState& state = GLState::get();
+    state.bindVertexArray(VAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    RenderStats::get().recordBufferUpload(vertices.size() * sizeof(float));
 
     // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+    // Texture coordinate attribute
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    // Position-only stream: depth passes fetch 12 bytes per vertex instead of 32
+    std::vector<float> positions;
+    positions.reserve(vertices.size() / FLOATS_PER_VERTEX * 3);
+    for (size_t i = 0; i + 2 < vertices.size(); i += FLOATS_PER_VERTEX) {
+        positions.insert(positions.end(), vertices.begin() + i, vertices.begin() + i + 3);
+    }
+    glGenVertexArrays(1, &positionVAO);
+    glGenBuffers(1, &positionVBO);
+    state.bindVertexArray(positionVAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+    RenderStats::get().recordBufferUpload(positions.size() * sizeof(float));
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
 }
 
 void Mesh::Draw(Shader& shader, const glm::mat4& modelMatrix, const glm::vec3& color,
@@ -37,7 +59,18 @@ void Mesh::Draw(Shader& shader, const glm::mat4& modelMatrix, const glm::vec3& c
     shader.setVec3("lightPos", lightPos);
     shader.setVec3("viewPos", viewPos);
 
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 6); // 6 floats per vertex (pos + normal)
-    glBindVertexArray(0);
+    // No unbind afterwards: the next draw binds its own VAO and GLState skips it if it's the same one.
+    GLState::get().bindVertexArray(VAO);
+    GLsizei vertexCount = static_cast<GLsizei>(vertices.size() / FLOATS_PER_VERTEX); // pos + normal + uv
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    RenderStats::get().recordDraw(GL_TRIANGLES, vertexCount);
+}
+
+void Mesh::DrawGeometry(Shader& shader, const glm::mat4& modelMatrix) {
+    shader.use();
+    shader.setMat4("model", modelMatrix);
+    GLState::get().bindVertexArray(positionVAO);
+    GLsizei vertexCount = static_cast<GLsizei>(vertices.size() / FLOATS_PER_VERTEX);
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    RenderStats::get().recordDraw(GL_TRIANGLES, vertexCount);
 }
\ No newline at end of file
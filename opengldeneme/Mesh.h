@@ -13,13 +13,17 @@
 class Mesh {
 public:
     // Mesh Data
-    std::vector<float> vertices; // x, y, z, nx, ny, nz
+    static const int FLOATS_PER_VERTEX = 8;
+    std::vector<float> vertices; // x, y, z, nx, ny, nz, u, v
     unsigned int VAO, VBO;
+    unsigned int positionVAO, positionVBO; // tightly packed positions for depth-only passes
 
     Mesh(const std::vector<float>& vertexData);
     ~Mesh();
     void Draw(Shader& shader, const glm::mat4& model, const glm::vec3& color,
         const glm::vec3& lightPos, const glm::vec3& viewPos, const glm::vec3& lightColor);
+    // Positions only, for depth passes: sets just the model matrix and draws the position stream.
+    void DrawGeometry(Shader& shader, const glm::mat4& model);
 
 private:
     void setupMesh();
@@ -0,0 +1,72 @@
+// Overdraw.cpp
+#include "Overdraw.h"
+#include "GLState.h"
+#include "RenderStats.h"
+
+RenderTargetDesc OverdrawView::countDesc(int width, int height) {
+    return RenderTargetDesc(GL_R16F, width, height);
+}
+
+void OverdrawView::beginCount() {
+    GLState& state = GLState::get();
+    state.enable(GL_BLEND);
+    state.blendFunc(GL_ONE, GL_ONE);
+    state.blendEquation(GL_FUNC_ADD);
+}
+
+void OverdrawView::endCount() {
+    GLState::get().disable(GL_BLEND);
+}
+
+void OverdrawView::drawHeatMap(Shader& heatmapShader, float maxOverdraw, GLuint countTexture) {
+    GLState& state = GLState::get();
+    state.disable(GL_BLEND);
+    state.disable(GL_DEPTH_TEST);
+
+    heatmapShader.use();
+    state.bindTexture(COUNT_UNIT, GL_TEXTURE_2D, countTexture);
+    heatmapShader.setInt("overdrawCount", COUNT_UNIT);
+    heatmapShader.setFloat("maxOverdraw", maxOverdraw);
+    state.bindFullscreenVertexArray();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+    state.enable(GL_DEPTH_TEST);
+}
+
+FragmentCounter::FragmentCounter() : current(0), lastSamples(0) {
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries[i] = 0;
+        pending[i] = false;
+    }
+}
+
+void FragmentCounter::shutdown() {
+    if (queries[0]) glDeleteQueries(QUERY_COUNT, queries);
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries[i] = 0;
+        pending[i] = false;
+    }
+}
+
+void FragmentCounter::begin() {
+    if (!queries[0]) glGenQueries(QUERY_COUNT, queries);
+
+    // Collect finished queries oldest first; the current slot is the oldest and about to be
+    // reused, so if it is somehow still running we wait for it.
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        int slot = (current + i) % QUERY_COUNT;
+        if (!pending[slot]) continue;
+        GLuint available = 0;
+        if (i > 0) glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (i > 0 && !available) break;
+        glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT, &lastSamples);
+        pending[slot] = false;
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, queries[current]);
+}
+
+void FragmentCounter::end() {
+    glEndQuery(GL_SAMPLES_PASSED);
+    pending[current] = true;
+    current = (current + 1) % QUERY_COUNT;
+}
@@ -0,0 +1,53 @@
+#pragma once
+// Overdraw.h
+// Tools for deciding whether the depth prepass pays off in a scene. OverdrawView is a debug view:
+// the scene is drawn with a shader that outputs 1 per fragment into a float render graph target
+// with additive blending, then shown as a heat map. FragmentCounter measures the same thing every frame with an
+// occlusion query, read back a few frames late so it never stalls.
+#ifndef OVERDRAW_H
+#define OVERDRAW_H
+
+#include <glad/glad.h>
+#include "RenderGraph.h"
+#include "Shader.h"
+
+class OverdrawView {
+public:
+    // Texture unit the heat map pass samples the count target from.
+    static const int COUNT_UNIT = 0;
+
+    // The render graph target the fragments are counted into.
+    static RenderTargetDesc countDesc(int width, int height);
+
+    // Switches to additive blending. Draw the scene into the count target with the count
+    // shader, using the usual depth state, then call endCount().
+    void beginCount();
+    void endCount();
+    // Replaces the current framebuffer's contents with the heat map of countTexture, pixel for
+    // pixel, in the current viewport.
+    void drawHeatMap(Shader& heatmapShader, float maxOverdraw, GLuint countTexture);
+};
+
+class FragmentCounter {
+public:
+    static const int QUERY_COUNT = 3;
+
+    FragmentCounter();
+
+    void shutdown();
+
+    // Counts the samples that pass the depth test between begin() and end().
+    void begin();
+    void end();
+
+    // Latest available result, 0 until the first query has finished.
+    GLuint samples() const { return lastSamples; }
+
+private:
+    GLuint queries[QUERY_COUNT];
+    bool pending[QUERY_COUNT];
+    int current;
+    GLuint lastSamples;
+};
+
+#endif
@@ -0,0 +1,474 @@
+// PathTracer.cpp
+#include "PathTracer.h"
+#include "CubeVertices.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PATH_TRACER_SSE 1
+#endif
+
+namespace {
+
+// Four floats processed together. Comparisons return lane masks (all bits set or clear).
+#ifdef PATH_TRACER_SSE
+struct Float4 {
+    __m128 v;
+    Float4() {}
+    Float4(__m128 value) : v(value) {}
+    explicit Float4(float s) : v(_mm_set1_ps(s)) {}
+    static Float4 load(const float* p) { return _mm_loadu_ps(p); }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+};
+inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+inline Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+inline Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+inline Float4 vmin(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+inline Float4 vmax(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+inline Float4 lessThan(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline Float4 lessEqual(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline Float4 greaterThan(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Float4 greaterEqual(Float4 a, Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+inline Float4 select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline int laneMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+inline Float4 maskFromLanes(int lanes) {
+    return _mm_castsi128_ps(_mm_set_epi32((lanes & 8) ? -1 : 0, (lanes & 4) ? -1 : 0, (lanes & 2) ? -1 : 0, (lanes & 1) ? -1 : 0));
+}
+#else
+struct Float4 {
+    float v[4];
+    Float4() {}
+    explicit Float4(float s) { v[0] = v[1] = v[2] = v[3] = s; }
+    static Float4 load(const float* p) { Float4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+    void store(float* p) const { std::memcpy(p, v, sizeof(v)); }
+};
+inline unsigned int bitsOf(float f) { unsigned int u; std::memcpy(&u, &f, sizeof(u)); return u; }
+inline float floatOf(unsigned int u) { float f; std::memcpy(&f, &u, sizeof(f)); return f; }
+inline float maskValue(bool b) { return floatOf(b ? 0xFFFFFFFFu : 0u); }
+#define PATH_TRACER_LANES(expr) Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = (expr); return r
+inline Float4 operator+(Float4 a, Float4 b) { PATH_TRACER_LANES(a.v[i] + b.v[i]); }
+inline Float4 operator-(Float4 a, Float4 b) { PATH_TRACER_LANES(a.v[i] - b.v[i]); }
+inline Float4 operator*(Float4 a, Float4 b) { PATH_TRACER_LANES(a.v[i] * b.v[i]); }
+inline Float4 operator/(Float4 a, Float4 b) { PATH_TRACER_LANES(a.v[i] / b.v[i]); }
+inline Float4 operator&(Float4 a, Float4 b) { PATH_TRACER_LANES(floatOf(bitsOf(a.v[i]) & bitsOf(b.v[i]))); }
+inline Float4 operator|(Float4 a, Float4 b) { PATH_TRACER_LANES(floatOf(bitsOf(a.v[i]) | bitsOf(b.v[i]))); }
+inline Float4 vmin(Float4 a, Float4 b) { PATH_TRACER_LANES(b.v[i] < a.v[i] ? b.v[i] : a.v[i]); }
+inline Float4 vmax(Float4 a, Float4 b) { PATH_TRACER_LANES(b.v[i] > a.v[i] ? b.v[i] : a.v[i]); }
+inline Float4 lessThan(Float4 a, Float4 b) { PATH_TRACER_LANES(maskValue(a.v[i] < b.v[i])); }
+inline Float4 lessEqual(Float4 a, Float4 b) { PATH_TRACER_LANES(maskValue(a.v[i] <= b.v[i])); }
+inline Float4 greaterThan(Float4 a, Float4 b) { PATH_TRACER_LANES(maskValue(a.v[i] > b.v[i])); }
+inline Float4 greaterEqual(Float4 a, Float4 b) { PATH_TRACER_LANES(maskValue(a.v[i] >= b.v[i])); }
+inline Float4 select(Float4 mask, Float4 a, Float4 b) { PATH_TRACER_LANES(bitsOf(mask.v[i]) ? a.v[i] : b.v[i]); }
+inline int laneMask(Float4 mask) {
+    int lanes = 0;
+    for (int i = 0; i < 4; ++i) if (bitsOf(mask.v[i]) & 0x80000000u) lanes |= 1 << i;
+    return lanes;
+}
+inline Float4 maskFromLanes(int lanes) { PATH_TRACER_LANES(maskValue((lanes & (1 << i)) != 0)); }
+#undef PATH_TRACER_LANES
+#endif
+
+struct Vec3x4 {
+    Float4 x, y, z;
+};
+inline Vec3x4 operator-(const Vec3x4& a, const Vec3x4& b) { Vec3x4 r = { a.x - b.x, a.y - b.y, a.z - b.z }; return r; }
+inline Float4 dot(const Vec3x4& a, const Vec3x4& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3x4 cross(const Vec3x4& a, const Vec3x4& b) {
+    Vec3x4 r = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    return r;
+}
+inline Vec3x4 splat(const glm::vec3& v) { Vec3x4 r = { Float4(v.x), Float4(v.y), Float4(v.z) }; return r; }
+
+const float RAY_EPSILON = 1e-3f;
+const float NO_HIT = 1e30f;
+const float PI = 3.14159265358979f;
+
+// Cosine-weighted direction around n (Duff et al. orthonormal basis).
+glm::vec3 cosineDirection(const glm::vec3& n, float u1, float u2) {
+    float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + n.z);
+    float b = n.x * n.y * a;
+    glm::vec3 tangent(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    glm::vec3 bitangent(b, sign + n.y * n.y * a, -n.y);
+    float r = std::sqrt(u1);
+    float phi = 2.0f * PI * u2;
+    return tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + n * std::sqrt(std::max(0.0f, 1.0f - u1));
+}
+
+} // namespace
+
+// Four rays in SoA form, with the closest hit found so far for each lane.
+struct PathTracer::Packet {
+    Vec3x4 origin, direction, inverseDirection;
+    Float4 active;
+    Float4 t;
+    Float4 triangle; // index as float, -1 for a miss
+};
+
+PathTracer::PathTracer()
+    : environment(0.0f), gridOrigin(0.0f), cellSize(4.0f), gridWidth(0), gridDepth(0), rayCount(0) {
+}
+
+void PathTracer::addBox(const glm::mat4& model, const glm::vec3& albedo) {
+    const int stride = 8;
+    for (int i = 0; i < numCubeVertices; i += 3) {
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; ++k) {
+            const float* v = &cubeVertices[(i + k) * stride];
+            p[k] = glm::vec3(model * glm::vec4(v[0], v[1], v[2], 1.0f));
+        }
+        Triangle triangle;
+        triangle.v0 = p[0];
+        triangle.e1 = p[1] - p[0];
+        triangle.e2 = p[2] - p[0];
+        glm::vec3 normal = glm::cross(triangle.e1, triangle.e2);
+        float length = glm::length(normal);
+        if (length <= 0.0f) continue; // degenerate after scaling
+        triangle.normal = normal / length;
+        triangle.albedo = albedo;
+        triangles.push_back(triangle);
+    }
+}
+
+void PathTracer::addLight(const GalleryLight& light) {
+    lights.push_back(light);
+}
+
+void PathTracer::addLayout(const GalleryLayout& layout, bool trackLights) {
+    addBox(glm::scale(glm::translate(glm::mat4(1.0f), layout.floorCenter), layout.floorSize), layout.floorColor);
+    for (const auto& exhibit : layout.exhibits) {
+        addBox(glm::scale(glm::translate(glm::mat4(1.0f), exhibit.position), exhibit.scale), exhibit.color);
+        if (trackLights) addLight(trackLightFor(exhibit.position));
+    }
+    addLight(mainLightFor(layout.mainLightPos, layout.mainLightColor));
+}
+
+void PathTracer::clear() {
+    triangles.clear();
+    nodes.clear();
+    lights.clear();
+    lightCells.clear();
+    globalLights.clear();
+    gridWidth = gridDepth = 0;
+}
+
+void PathTracer::build() {
+    nodes.clear();
+    if (!triangles.empty()) {
+        nodes.reserve(triangles.size() * 2 / LEAF_TRIANGLES + 1);
+        nodes.resize(1);
+        buildNode(0, 0, static_cast<unsigned int>(triangles.size()));
+    }
+
+    // Bin the ranged lights into an XZ grid so a shading point only tests lights that can reach it.
+    lightCells.clear();
+    globalLights.clear();
+    glm::vec2 boundsMin(1e30f), boundsMax(-1e30f);
+    for (unsigned int i = 0; i < lights.size(); ++i) {
+        const GalleryLight& light = lights[i];
+        if (light.range > 100.0f) {
+            globalLights.push_back(i);
+            continue;
+        }
+        boundsMin = glm::min(boundsMin, glm::vec2(light.position.x, light.position.z) - light.range);
+        boundsMax = glm::max(boundsMax, glm::vec2(light.position.x, light.position.z) + light.range);
+    }
+    gridWidth = gridDepth = 0;
+    cellSize = 4.0f;
+    if (boundsMin.x > boundsMax.x) return;
+
+    gridOrigin = boundsMin;
+    gridWidth = std::min(256, static_cast<int>(std::ceil((boundsMax.x - boundsMin.x) / cellSize)) + 1);
+    gridDepth = std::min(256, static_cast<int>(std::ceil((boundsMax.y - boundsMin.y) / cellSize)) + 1);
+    cellSize = std::max(cellSize, std::max((boundsMax.x - boundsMin.x) / gridWidth, (boundsMax.y - boundsMin.y) / gridDepth));
+    lightCells.assign(gridWidth * gridDepth, std::vector<unsigned int>());
+    for (unsigned int i = 0; i < lights.size(); ++i) {
+        const GalleryLight& light = lights[i];
+        if (light.range > 100.0f) continue;
+        int x0 = std::max(0, static_cast<int>((light.position.x - light.range - gridOrigin.x) / cellSize));
+        int x1 = std::min(gridWidth - 1, static_cast<int>((light.position.x + light.range - gridOrigin.x) / cellSize));
+        int z0 = std::max(0, static_cast<int>((light.position.z - light.range - gridOrigin.y) / cellSize));
+        int z1 = std::min(gridDepth - 1, static_cast<int>((light.position.z + light.range - gridOrigin.y) / cellSize));
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                lightCells[z * gridWidth + x].push_back(i);
+    }
+}
+
+void PathTracer::buildNode(unsigned int index, unsigned int first, unsigned int count) {
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    glm::vec3 centroidMin(1e30f), centroidMax(-1e30f);
+    for (unsigned int i = first; i < first + count; ++i) {
+        const Triangle& t = triangles[i];
+        glm::vec3 a = t.v0, b = t.v0 + t.e1, c = t.v0 + t.e2;
+        boundsMin = glm::min(boundsMin, glm::min(a, glm::min(b, c)));
+        boundsMax = glm::max(boundsMax, glm::max(a, glm::max(b, c)));
+        glm::vec3 centroid = (a + b + c) / 3.0f;
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+    nodes[index].boundsMin = boundsMin;
+    nodes[index].boundsMax = boundsMax;
+
+    if (count <= static_cast<unsigned int>(LEAF_TRIANGLES)) {
+        nodes[index].leftOrFirst = first;
+        nodes[index].count = count;
+        return;
+    }
+
+    // Median split along the longest axis of the centroid bounds.
+    glm::vec3 extent = centroidMax - centroidMin;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    unsigned int half = count / 2;
+    std::nth_element(triangles.begin() + first, triangles.begin() + first + half, triangles.begin() + first + count,
+        [axis](const Triangle& a, const Triangle& b) {
+            return (3.0f * a.v0[axis] + a.e1[axis] + a.e2[axis]) < (3.0f * b.v0[axis] + b.e1[axis] + b.e2[axis]);
+        });
+
+    // Both children are allocated together, so the right child is always left + 1.
+    unsigned int left = static_cast<unsigned int>(nodes.size());
+    nodes.resize(nodes.size() + 2);
+    nodes[index].leftOrFirst = left;
+    nodes[index].count = 0;
+    buildNode(left, first, half);
+    buildNode(left + 1, first + half, count - half);
+}
+
+void PathTracer::intersectPacket(Packet& packet) const {
+    if (nodes.empty()) return;
+    unsigned int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    const Float4 zero(0.0f);
+    const Float4 epsilon(RAY_EPSILON);
+    const Float4 one(1.0f);
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        // Slab test for all four rays; the node is skipped only when every active lane misses it.
+        Float4 tx0 = (Float4(node.boundsMin.x) - packet.origin.x) * packet.inverseDirection.x;
+        Float4 tx1 = (Float4(node.boundsMax.x) - packet.origin.x) * packet.inverseDirection.x;
+        Float4 ty0 = (Float4(node.boundsMin.y) - packet.origin.y) * packet.inverseDirection.y;
+        Float4 ty1 = (Float4(node.boundsMax.y) - packet.origin.y) * packet.inverseDirection.y;
+        Float4 tz0 = (Float4(node.boundsMin.z) - packet.origin.z) * packet.inverseDirection.z;
+        Float4 tz1 = (Float4(node.boundsMax.z) - packet.origin.z) * packet.inverseDirection.z;
+        Float4 tNear = vmax(vmax(vmin(tx0, tx1), vmin(ty0, ty1)), vmax(vmin(tz0, tz1), zero));
+        Float4 tFar = vmin(vmin(vmax(tx0, tx1), vmax(ty0, ty1)), vmin(vmax(tz0, tz1), packet.t));
+        Float4 mask = lessEqual(tNear, tFar) & packet.active;
+        if (laneMask(mask) == 0) continue;
+
+        if (node.count == 0) {
+            if (stackSize + 2 > 64) continue; // cannot happen with a median-split tree of this size
+            stack[stackSize++] = node.leftOrFirst + 1;
+            stack[stackSize++] = node.leftOrFirst;
+            continue;
+        }
+
+        // Möller-Trumbore against every triangle in the leaf, four rays at a time.
+        for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+            const Triangle& triangle = triangles[i];
+            Vec3x4 e1 = splat(triangle.e1);
+            Vec3x4 e2 = splat(triangle.e2);
+            Vec3x4 p = cross(packet.direction, e2);
+            Float4 det = dot(e1, p);
+            Float4 inverseDet = one / det;
+            Vec3x4 s = packet.origin - splat(triangle.v0);
+            Float4 u = dot(s, p) * inverseDet;
+            Vec3x4 q = cross(s, e1);
+            Float4 v = dot(packet.direction, q) * inverseDet;
+            Float4 t = dot(e2, q) * inverseDet;
+            Float4 hit = mask & greaterThan(det * det, Float4(1e-18f))
+                & greaterEqual(u, zero) & greaterEqual(v, zero) & lessEqual(u + v, one)
+                & greaterThan(t, epsilon) & lessThan(t, packet.t);
+            if (laneMask(hit) == 0) continue;
+            packet.t = select(hit, t, packet.t);
+            packet.triangle = select(hit, Float4(static_cast<float>(i)), packet.triangle);
+        }
+    }
+}
+
+bool PathTracer::occluded(const glm::vec3& from, const glm::vec3& to) const {
+    rayCount.fetch_add(1, std::memory_order_relaxed);
+    if (nodes.empty()) return false;
+    glm::vec3 direction = to - from;
+    float maxT = 1.0f - RAY_EPSILON; // direction is not normalised: t = 1 is the target
+    glm::vec3 inverseDirection = 1.0f / direction;
+
+    unsigned int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+        glm::vec3 t0 = (node.boundsMin - from) * inverseDirection;
+        glm::vec3 t1 = (node.boundsMax - from) * inverseDirection;
+        glm::vec3 tMin = glm::min(t0, t1), tMax = glm::max(t0, t1);
+        float tNear = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float tFar = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxT));
+        if (!(tNear <= tFar)) continue;
+
+        if (node.count == 0) {
+            if (stackSize + 2 > 64) continue;
+            stack[stackSize++] = node.leftOrFirst + 1;
+            stack[stackSize++] = node.leftOrFirst;
+            continue;
+        }
+        for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+            const Triangle& triangle = triangles[i];
+            glm::vec3 p = glm::cross(direction, triangle.e2);
+            float det = glm::dot(triangle.e1, p);
+            if (std::fabs(det) < 1e-12f) continue;
+            float inverseDet = 1.0f / det;
+            glm::vec3 s = from - triangle.v0;
+            float u = glm::dot(s, p) * inverseDet;
+            if (u < 0.0f || u > 1.0f) continue;
+            glm::vec3 q = glm::cross(s, triangle.e1);
+            float v = glm::dot(direction, q) * inverseDet;
+            if (v < 0.0f || u + v > 1.0f) continue;
+            float t = glm::dot(triangle.e2, q) * inverseDet;
+            if (t > 0.0f && t < maxT) return true;
+        }
+    }
+    return false;
+}
+
+// Direct light at a surface point, using the same window falloff and spot cone as basic.frag.
+glm::vec3 PathTracer::directLight(const glm::vec3& position, const glm::vec3& normal) const {
+    glm::vec3 result(0.0f);
+    const std::vector<unsigned int>* cell = nullptr;
+    if (gridWidth > 0) {
+        int x = static_cast<int>(std::floor((position.x - gridOrigin.x) / cellSize));
+        int z = static_cast<int>(std::floor((position.z - gridOrigin.y) / cellSize));
+        if (x >= 0 && x < gridWidth && z >= 0 && z < gridDepth) cell = &lightCells[z * gridWidth + x];
+    }
+    size_t cellCount = cell ? cell->size() : 0;
+
+    for (size_t k = 0; k < globalLights.size() + cellCount; ++k) {
+        const GalleryLight& light = lights[k < globalLights.size() ? globalLights[k] : (*cell)[k - globalLights.size()]];
+        glm::vec3 toLight = light.position - position;
+        float distance = glm::length(toLight);
+        if (distance >= light.range || distance <= 0.0f) continue;
+        glm::vec3 lightDir = toLight / distance;
+        float cosine = glm::dot(normal, lightDir);
+        if (cosine <= 0.0f) continue;
+
+        float ratio = distance / light.range;
+        float window = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+        float attenuation = window * window;
+        float theta = glm::dot(lightDir, -light.direction);
+        float spot = glm::clamp((theta - light.cosOuterCutOff) / std::max(light.cosInnerCutOff - light.cosOuterCutOff, 1e-4f), 0.0f, 1.0f);
+        if (attenuation * spot <= 0.0f) continue;
+        if (occluded(position, light.position)) continue;
+        result += light.color * (cosine * attenuation * spot);
+    }
+    return result;
+}
+
+// Follows count paths from origin, four at a time. Each lane accumulates light reflected towards
+// it from every surface it bounces off; direct emission is never added because lights are not geometry.
+void PathTracer::tracePaths(const glm::vec3& origin, const glm::vec3* directions, glm::vec3* radiance,
+    int count, int maxBounces, TraceRandom& random) const {
+    unsigned long long rays = 0;
+    const int lanes = PACKET_SIZE; // std::min takes references, which would need PACKET_SIZE defined
+    for (int base = 0; base < count; base += PACKET_SIZE) {
+        int laneCount = std::min(lanes, count - base);
+        float ox[PACKET_SIZE], oy[PACKET_SIZE], oz[PACKET_SIZE];
+        float dx[PACKET_SIZE], dy[PACKET_SIZE], dz[PACKET_SIZE];
+        glm::vec3 throughput[PACKET_SIZE], result[PACKET_SIZE];
+        int alive = 0;
+        for (int lane = 0; lane < PACKET_SIZE; ++lane) {
+            glm::vec3 d = lane < laneCount ? directions[base + lane] : glm::vec3(0.0f, 1.0f, 0.0f);
+            ox[lane] = origin.x; oy[lane] = origin.y; oz[lane] = origin.z;
+            dx[lane] = d.x; dy[lane] = d.y; dz[lane] = d.z;
+            throughput[lane] = glm::vec3(1.0f);
+            result[lane] = glm::vec3(0.0f);
+            if (lane < laneCount) alive |= 1 << lane;
+        }
+
+        for (int bounce = 0; bounce < maxBounces && alive != 0; ++bounce) {
+            Packet packet;
+            packet.origin.x = Float4::load(ox); packet.origin.y = Float4::load(oy); packet.origin.z = Float4::load(oz);
+            packet.direction.x = Float4::load(dx); packet.direction.y = Float4::load(dy); packet.direction.z = Float4::load(dz);
+            packet.inverseDirection.x = Float4(1.0f) / packet.direction.x;
+            packet.inverseDirection.y = Float4(1.0f) / packet.direction.y;
+            packet.inverseDirection.z = Float4(1.0f) / packet.direction.z;
+            packet.active = maskFromLanes(alive);
+            packet.t = Float4(NO_HIT);
+            packet.triangle = Float4(-1.0f);
+            intersectPacket(packet);
+
+            float hitT[PACKET_SIZE], hitTriangle[PACKET_SIZE];
+            packet.t.store(hitT);
+            packet.triangle.store(hitTriangle);
+            for (int lane = 0; lane < PACKET_SIZE; ++lane) {
+                if (!(alive & (1 << lane))) continue;
+                rays++;
+                if (hitTriangle[lane] < 0.0f) {
+                    result[lane] += throughput[lane] * environment;
+                    alive &= ~(1 << lane);
+                    continue;
+                }
+                const Triangle& triangle = triangles[static_cast<size_t>(hitTriangle[lane])];
+                glm::vec3 direction(dx[lane], dy[lane], dz[lane]);
+                glm::vec3 normal = glm::dot(triangle.normal, direction) > 0.0f ? -triangle.normal : triangle.normal;
+                glm::vec3 hitPosition = glm::vec3(ox[lane], oy[lane], oz[lane]) + direction * hitT[lane] + normal * RAY_EPSILON;
+
+                throughput[lane] *= triangle.albedo;
+                result[lane] += throughput[lane] * directLight(hitPosition, normal);
+                if (bounce + 1 == maxBounces) {
+                    alive &= ~(1 << lane);
+                    continue;
+                }
+                // Russian roulette once a path has bounced twice.
+                if (bounce >= 2) {
+                    float survive = glm::clamp(std::max(throughput[lane].x, std::max(throughput[lane].y, throughput[lane].z)), 0.05f, 0.95f);
+                    if (random.next() > survive) {
+                        alive &= ~(1 << lane);
+                        continue;
+                    }
+                    throughput[lane] /= survive;
+                }
+                glm::vec3 next = cosineDirection(normal, random.next(), random.next());
+                ox[lane] = hitPosition.x; oy[lane] = hitPosition.y; oz[lane] = hitPosition.z;
+                dx[lane] = next.x; dy[lane] = next.y; dz[lane] = next.z;
+            }
+        }
+        for (int lane = 0; lane < laneCount; ++lane) radiance[base + lane] = result[lane];
+    }
+    rayCount.fetch_add(rays, std::memory_order_relaxed);
+}
+
+glm::vec3 PathTracer::indirectLight(const glm::vec3& position, const glm::vec3& normal, int samples, int maxBounces, TraceRandom& random) const {
+    if (samples <= 0) return glm::vec3(0.0f);
+    // Stratified over a sqrt(samples) grid on the unit square, traced in small batches.
+    const int BATCH = 16;
+    int strata = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(samples))));
+    glm::vec3 origin = position + normal * RAY_EPSILON;
+    glm::vec3 directions[BATCH], radiance[BATCH];
+    glm::vec3 sum(0.0f);
+    for (int first = 0; first < samples; first += BATCH) {
+        int batch = std::min(BATCH, samples - first);
+        for (int i = 0; i < batch; ++i) {
+            int index = (first + i) % (strata * strata);
+            float u1 = ((index % strata) + random.next()) / strata;
+            float u2 = ((index / strata) + random.next()) / strata;
+            directions[i] = cosineDirection(normal, u1, u2);
+        }
+        tracePaths(origin, directions, radiance, batch, maxBounces, random);
+        for (int i = 0; i < batch; ++i) sum += radiance[i];
+    }
+    return sum / static_cast<float>(samples);
+}
+
+void PathTracer::traceRadiance(const glm::vec3& position, const glm::vec3* directions, glm::vec3* radiance,
+    int count, int maxBounces, TraceRandom& random) const {
+    tracePaths(position, directions, radiance, count, maxBounces, random);
+}
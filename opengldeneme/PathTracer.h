@@ -0,0 +1,94 @@
+#pragma once
+// PathTracer.h
+// CPU path tracer over the static hall, used for offline baking (lightmaps, irradiance probes).
+// Triangles sit in a BVH that is traversed by packets of four rays, with SSE where the compiler
+// targets it. Direct light comes from the gallery lights through shadow rays; light arriving
+// straight from a light source is never part of a result, since the renderer shades that itself.
+// After build() the const methods can be called from any number of threads.
+#ifndef PATH_TRACER_H
+#define PATH_TRACER_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <vector>
+#include "GalleryLayout.h"
+
+// Small xorshift generator, one per thread.
+struct TraceRandom {
+    unsigned int state;
+
+    explicit TraceRandom(unsigned int seed) : state(seed ? seed : 0x9E3779B9u) {}
+    float next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+class PathTracer {
+public:
+    static const int PACKET_SIZE = 4;
+    static const int LEAF_TRIANGLES = 4;
+
+    PathTracer();
+
+    // Adds the 12 triangles of the unit cube (CubeVertices.h) transformed by model.
+    void addBox(const glm::mat4& model, const glm::vec3& albedo);
+    void addLight(const GalleryLight& light);
+    // Radiance of rays that leave the hall; stands in for the walls and ceiling the scene doesn't model.
+    void setEnvironment(const glm::vec3& radiance) { environment = radiance; }
+    // Floor, exhibits, main light and (optionally) the track lights of a layout.
+    void addLayout(const GalleryLayout& layout, bool trackLights);
+    // Builds the BVH and the light grid. Call after adding everything and before tracing.
+    void build();
+    // Drops all geometry and lights, e.g. before rebuilding after an exhibit moved.
+    void clear();
+
+    // Mean incoming radiance over the cosine-weighted hemisphere above (position, normal).
+    glm::vec3 indirectLight(const glm::vec3& position, const glm::vec3& normal, int samples, int maxBounces, TraceRandom& random) const;
+    // Incoming radiance along each of count directions, for projecting onto a basis.
+    void traceRadiance(const glm::vec3& position, const glm::vec3* directions, glm::vec3* radiance,
+        int count, int maxBounces, TraceRandom& random) const;
+
+    bool occluded(const glm::vec3& from, const glm::vec3& to) const;
+
+    size_t triangleCount() const { return triangles.size(); }
+    unsigned long long raysTraced() const { return rayCount.load(); }
+
+private:
+    struct Triangle {
+        glm::vec3 v0, e1, e2;
+        glm::vec3 normal;
+        glm::vec3 albedo;
+    };
+    struct Node {
+        glm::vec3 boundsMin;
+        unsigned int leftOrFirst; // first triangle for leaves, left child otherwise (right = left + 1)
+        glm::vec3 boundsMax;
+        unsigned int count;       // triangles in a leaf, 0 for inner nodes
+    };
+    struct Packet;
+
+    void buildNode(unsigned int index, unsigned int first, unsigned int count);
+    void intersectPacket(Packet& packet) const;
+    glm::vec3 directLight(const glm::vec3& position, const glm::vec3& normal) const;
+    void tracePaths(const glm::vec3& origin, const glm::vec3* directions, glm::vec3* radiance,
+        int count, int maxBounces, TraceRandom& random) const;
+
+    std::vector<Triangle> triangles;
+    std::vector<Node> nodes;
+    std::vector<GalleryLight> lights;
+    glm::vec3 environment;
+
+    // Ranged lights binned into an XZ grid; lights with a huge range are tested everywhere.
+    std::vector<std::vector<unsigned int> > lightCells;
+    std::vector<unsigned int> globalLights;
+    glm::vec2 gridOrigin;
+    float cellSize;
+    int gridWidth, gridDepth;
+
+    mutable std::atomic<unsigned long long> rayCount;
+};
+
+#endif
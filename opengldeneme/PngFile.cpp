@@ -0,0 +1,226 @@
+// PngFile.cpp
+#include "PngFile.h"
+#include <fstream>
+
+namespace {
+
+const int WINDOW_SIZE = 32768;
+const int MIN_MATCH = 3;
+const int MAX_MATCH = 258;
+const int HASH_BITS = 15;
+
+const unsigned short LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const unsigned char LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const unsigned short DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const unsigned char DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Deflate packs bits from the least significant end; Huffman codes go in most significant bit
+// first, which is why the code tables below hold them reversed.
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char>& out) : out(out), buffer(0), count(0) {}
+
+    void put(unsigned int bits, int length) {
+        buffer |= bits << count;
+        count += length;
+        while (count >= 8) {
+            out.push_back(static_cast<unsigned char>(buffer));
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    void flush() {
+        if (count > 0) out.push_back(static_cast<unsigned char>(buffer));
+        buffer = 0;
+        count = 0;
+    }
+
+private:
+    std::vector<unsigned char>& out;
+    unsigned int buffer;
+    int count;
+};
+
+unsigned int reverseBits(unsigned int code, int length) {
+    unsigned int reversed = 0;
+    for (int i = 0; i < length; ++i) reversed |= ((code >> i) & 1u) << (length - 1 - i);
+    return reversed;
+}
+
+// Fixed literal/length and distance codes of RFC 1951, section 3.2.6, already bit-reversed.
+struct FixedCodes {
+    unsigned short symbols[288];
+    unsigned char symbolLengths[288];
+    unsigned char distances[30];
+    FixedCodes() {
+        for (int symbol = 0; symbol < 288; ++symbol) {
+            unsigned int code;
+            int length;
+            if (symbol < 144) { code = 0x30 + symbol; length = 8; }
+            else if (symbol < 256) { code = 0x190 + symbol - 144; length = 9; }
+            else if (symbol < 280) { code = symbol - 256; length = 7; }
+            else { code = 0xC0 + symbol - 280; length = 8; }
+            symbols[symbol] = static_cast<unsigned short>(reverseBits(code, length));
+            symbolLengths[symbol] = static_cast<unsigned char>(length);
+        }
+        for (int code = 0; code < 30; ++code) distances[code] = static_cast<unsigned char>(reverseBits(code, 5));
+    }
+};
+
+const FixedCodes& fixedCodes() {
+    static const FixedCodes codes; // encoder threads share it; local statics initialize once
+    return codes;
+}
+
+void putMatch(BitWriter& bits, const FixedCodes& codes, int length, int distance) {
+    int code = 28;
+    while (LENGTH_BASE[code] > length) --code;
+    bits.put(codes.symbols[257 + code], codes.symbolLengths[257 + code]);
+    bits.put(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+    code = 29;
+    while (DISTANCE_BASE[code] > distance) --code;
+    bits.put(codes.distances[code], 5);
+    bits.put(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+}
+
+void deflate(const std::vector<unsigned char>& data, std::vector<unsigned char>& out) {
+    const FixedCodes& codes = fixedCodes();
+    BitWriter bits(out);
+    bits.put(1, 1); // final block
+    bits.put(1, 2); // fixed Huffman codes
+    std::vector<int> head(1 << HASH_BITS, -WINDOW_SIZE - 1);
+    const int size = static_cast<int>(data.size());
+    const unsigned char* bytes = data.data();
+    int pos = 0;
+    while (pos < size) {
+        int length = 0, distance = 0;
+        if (pos + MIN_MATCH <= size) {
+            unsigned int key = (bytes[pos] << 16) | (bytes[pos + 1] << 8) | bytes[pos + 2];
+            unsigned int hash = (key * 2654435761u) >> (32 - HASH_BITS);
+            int candidate = head[hash];
+            head[hash] = pos;
+            if (pos - candidate <= WINDOW_SIZE) {
+                int limit = size - pos < MAX_MATCH ? size - pos : MAX_MATCH;
+                while (length < limit && bytes[candidate + length] == bytes[pos + length]) ++length;
+                distance = pos - candidate;
+            }
+        }
+        if (length >= MIN_MATCH) {
+            putMatch(bits, codes, length, distance);
+            pos += length;
+        }
+        else {
+            bits.put(codes.symbols[bytes[pos]], codes.symbolLengths[bytes[pos]]);
+            ++pos;
+        }
+    }
+    bits.put(codes.symbols[256], codes.symbolLengths[256]);
+    bits.flush();
+}
+
+struct CrcTable {
+    unsigned int entries[256];
+    CrcTable() {
+        for (unsigned int n = 0; n < 256; ++n) {
+            unsigned int c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+    }
+};
+
+unsigned int crc32(const unsigned char* data, size_t size) {
+    static const CrcTable table;
+    unsigned int crc = ~0u;
+    for (size_t i = 0; i < size; ++i) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+unsigned int adler32(const std::vector<unsigned char>& data) {
+    unsigned int a = 1, b = 0;
+    size_t i = 0;
+    while (i < data.size()) {
+        size_t end = i + 5552 < data.size() ? i + 5552 : data.size(); // no overflow before the modulo
+        for (; i < end; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+void putBigEndian(std::vector<unsigned char>& out, unsigned int value) {
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+void putChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data) {
+    putBigEndian(png, static_cast<unsigned int>(data.size()));
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    putBigEndian(png, crc32(&png[start], png.size() - start));
+}
+
+} // namespace
+
+void encodePng(int width, int height, const unsigned char* rgba, bool bottomUp, std::vector<unsigned char>& png) {
+    // Filter byte then the row, each byte minus the same channel of the pixel to its left
+    const size_t rowBytes = static_cast<size_t>(width) * 3 + 1;
+    std::vector<unsigned char> filtered(rowBytes * height);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* source = rgba + static_cast<size_t>(bottomUp ? height - 1 - y : y) * width * 4;
+        unsigned char* row = &filtered[rowBytes * y];
+        row[0] = 1; // Sub
+        unsigned char left[3] = { 0, 0, 0 };
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                unsigned char value = source[x * 4 + c];
+                row[1 + x * 3 + c] = static_cast<unsigned char>(value - left[c]);
+                left[c] = value;
+            }
+        }
+    }
+
+    std::vector<unsigned char> compressed;
+    compressed.reserve(filtered.size() / 2);
+    compressed.push_back(0x78); // zlib header: deflate, 32K window
+    compressed.push_back(0x01);
+    deflate(filtered, compressed);
+    putBigEndian(compressed, adler32(filtered));
+
+    std::vector<unsigned char> header;
+    putBigEndian(header, static_cast<unsigned int>(width));
+    putBigEndian(header, static_cast<unsigned int>(height));
+    header.push_back(8); // bits per channel
+    header.push_back(2); // RGB
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.assign(SIGNATURE, SIGNATURE + 8);
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", compressed);
+    putChunk(png, "IEND", std::vector<unsigned char>());
+}
+
+bool writePngFile(const std::string& path, int width, int height, const unsigned char* rgba, bool bottomUp, std::string& error) {
+    std::vector<unsigned char> png;
+    encodePng(width, height, rgba, bottomUp, png);
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(png.data()), png.size())) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+// PngFile.h
+// Writes 8-bit RGB PNG files without an image library. Rows are Sub-filtered and compressed with
+// a small deflate that finds matches through a single-entry hash and emits fixed Huffman codes:
+// files come out larger than a full encoder's, but fast enough to keep up with video capture.
+#ifndef PNG_FILE_H
+#define PNG_FILE_H
+
+#include <string>
+#include <vector>
+
+// Encodes width x height RGBA pixels (as glReadPixels returns them) into an RGB PNG; alpha is
+// dropped. With bottomUp the first row of pixels is the bottom of the image, as in OpenGL.
+void encodePng(int width, int height, const unsigned char* rgba, bool bottomUp, std::vector<unsigned char>& png);
+
+bool writePngFile(const std::string& path, int width, int height, const unsigned char* rgba, bool bottomUp, std::string& error);
+
+#endif
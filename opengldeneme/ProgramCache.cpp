@@ -0,0 +1,151 @@
+// ProgramCache.cpp
+#include "ProgramCache.h"
+#include "GLExtensions.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+    const unsigned int FILE_MAGIC = 0x42504D56; // "VMPB"
+    const unsigned int FILE_VERSION = 1;
+
+    struct FileHeader {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long key;
+        unsigned int binaryFormat;
+        unsigned int length;
+        float compileMs;
+    };
+
+    void hashBytes(unsigned long long& hash, const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull; // FNV-1a
+        }
+    }
+
+    std::string glString(GLenum name) {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        return value ? value : "";
+    }
+}
+
+ProgramCache& ProgramCache::get() {
+    static ProgramCache instance;
+    return instance;
+}
+
+ProgramCache::ProgramCache() : active(false) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+void ProgramCache::init(const std::string& cacheDirectory) {
+    directory = cacheDirectory;
+    driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+    active = !directory.empty() && GLExtensions::programBinary;
+    if (!active) return;
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+unsigned long long ProgramCache::keyFor(const std::string& vertexSource, const std::string& fragmentSource) const {
+    unsigned long long hash = 14695981039346656037ull;
+    // Terminators keep "ab" + "c" and "a" + "bc" apart.
+    hashBytes(hash, driver.c_str(), driver.size() + 1);
+    hashBytes(hash, vertexSource.c_str(), vertexSource.size() + 1);
+    hashBytes(hash, fragmentSource.c_str(), fragmentSource.size() + 1);
+    return hash;
+}
+
+std::string ProgramCache::pathFor(unsigned long long key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return directory + "/" + name;
+}
+
+bool ProgramCache::load(GLuint program, unsigned long long key) {
+    if (!active) return false;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::string path = pathFor(key);
+    std::ifstream file(path.c_str(), std::ios::binary);
+    FileHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.key != key) {
+        counters.misses++;
+        return false;
+    }
+    // The length is only trusted once the file is known to hold that many bytes after the header,
+    // so a truncated or corrupt entry is rejected below instead of sizing the buffer.
+    std::streampos body = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - body;
+    file.seekg(body);
+    std::vector<char> binary;
+    bool complete = header.length > 0 && remaining == static_cast<std::streamoff>(header.length);
+    if (complete) {
+        binary.resize(header.length);
+        complete = static_cast<bool>(file.read(binary.data(), header.length));
+    }
+    file.close();
+
+    GLint linked = GL_FALSE;
+    if (complete) {
+        GLExtensions::loadProgramBinary(program, header.binaryFormat, binary.data(), header.length);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+    if (!linked) {
+        // Same driver strings but a binary it no longer accepts: drop it and compile from source.
+        std::remove(path.c_str());
+        counters.rejected++;
+        counters.misses++;
+        return false;
+    }
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    counters.hits++;
+    counters.loadMs += ms;
+    counters.savedMs += header.compileMs - ms;
+    return true;
+}
+
+void ProgramCache::prepareForLink(GLuint program) {
+    if (active) GLExtensions::programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::store(GLuint program, unsigned long long key, float compileMs) {
+    counters.compileMs += compileMs;
+    if (!active) return;
+
+    GLint linked = GL_FALSE, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GLExtensions::getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    FileHeader header = { FILE_MAGIC, FILE_VERSION, key, format, static_cast<unsigned int>(written), compileMs };
+    std::string path = pathFor(key);
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file.write(binary.data(), written)) {
+        std::cerr << "ERROR::PROGRAM_CACHE::WRITE_FAILED: " << path << std::endl;
+        file.close();
+        std::remove(path.c_str());
+    }
+}
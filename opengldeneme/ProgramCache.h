@@ -0,0 +1,54 @@
+#pragma once
+// ProgramCache.h
+// On-disk cache of linked program binaries (GL_ARB_get_program_binary).
+// Entries are keyed by a hash of the preprocessed stage sources together with the GL vendor,
+// renderer and version strings, so a driver update simply misses. A binary the driver refuses
+// anyway is deleted and the program is compiled from source.
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include <string>
+
+struct ProgramCacheStats {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int rejected;  // files found but refused by the driver
+    float loadMs;           // time spent loading binaries
+    float compileMs;        // time spent compiling from source
+    float savedMs;          // recorded compile time of the hits minus the time to load them
+
+    float hitRate() const { return hits + misses ? (float)hits / (hits + misses) : 0.0f; }
+};
+
+class ProgramCache {
+public:
+    static ProgramCache& get();
+
+    // Reads the driver identity; call once the context is current. An empty directory or a
+    // driver without binary formats leaves the cache disabled.
+    void init(const std::string& directory);
+    bool enabled() const { return active; }
+
+    unsigned long long keyFor(const std::string& vertexSource, const std::string& fragmentSource) const;
+
+    // Loads the cached binary for key into program. Returns true if the program is now linked.
+    bool load(GLuint program, unsigned long long key);
+    // Call before glLinkProgram so the driver keeps the binary retrievable.
+    void prepareForLink(GLuint program);
+    // Writes a linked program to the cache. compileMs is what a later hit saves.
+    void store(GLuint program, unsigned long long key, float compileMs);
+
+    const ProgramCacheStats& stats() const { return counters; }
+
+private:
+    ProgramCache();
+    std::string pathFor(unsigned long long key) const;
+
+    bool active;
+    std::string directory;
+    std::string driver;
+    ProgramCacheStats counters;
+};
+
+#endif
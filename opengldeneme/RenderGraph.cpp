@@ -0,0 +1,304 @@
+// RenderGraph.cpp
+#include "RenderGraph.h"
+#include "GLState.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    struct TargetFormat {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+        size_t bytesPerPixel;
+        bool depth;
+    };
+
+    const TargetFormat TARGET_FORMATS[] = {
+        { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+        { GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 8, false },
+        { GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4, false },
+        { GL_R16F, GL_RED, GL_FLOAT, 2, false },
+        { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4, true },
+    };
+
+    const TargetFormat& formatOf(GLenum internalFormat) {
+        for (const auto& format : TARGET_FORMATS) {
+            if (format.internalFormat == internalFormat) return format;
+        }
+        std::cerr << "ERROR::RENDER_GRAPH::UNSUPPORTED_FORMAT " << internalFormat << std::endl;
+        return TARGET_FORMATS[0];
+    }
+
+    bool sameDesc(const RenderTargetDesc& a, const RenderTargetDesc& b) {
+        return a.internalFormat == b.internalFormat && a.width == b.width && a.height == b.height && a.filter == b.filter;
+    }
+
+    size_t bytesOf(const RenderTargetDesc& desc) {
+        return formatOf(desc.internalFormat).bytesPerPixel * desc.width * desc.height;
+    }
+}
+
+RenderTargetDesc::RenderTargetDesc(GLenum internalFormat, int width, int height, GLenum filter, const glm::vec4& clearValue)
+    : internalFormat(internalFormat), width(width), height(height), filter(filter), clearValue(clearValue) {}
+
+RenderTargetDesc RenderTargetDesc::depth(int width, int height) {
+    return RenderTargetDesc(GL_DEPTH_COMPONENT24, width, height, GL_NEAREST, glm::vec4(1.0f));
+}
+
+RenderGraph::RenderGraph() : frame(0), backbufferFramebuffer(0) {
+    lastStats = RenderGraphStats();
+    reset();
+}
+
+void RenderGraph::shutdown() {
+    GLState& state = GLState::get();
+    for (const auto& cached : framebuffers) state.deleteFramebuffer(cached.framebuffer);
+    for (const auto& texture : pool) state.deleteTexture(texture.texture);
+    framebuffers.clear();
+    pool.clear();
+    reset();
+}
+
+void RenderGraph::reset() {
+    resources.clear();
+    passes.clear();
+    executed.clear();
+    ResourceNode backbuffer = { "Backbuffer", RESOURCE_BACKBUFFER, RenderTargetDesc(GL_RGBA8, 0, 0), -1, -1, -1, false };
+    resources.push_back(backbuffer);
+}
+
+RenderGraph::Resource RenderGraph::createTarget(const std::string& name, const RenderTargetDesc& desc) {
+    ResourceNode node = { name, RESOURCE_TARGET, desc, -1, -1, -1, false };
+    resources.push_back(node);
+    return static_cast<Resource>(resources.size()) - 1;
+}
+
+RenderGraph::Resource RenderGraph::importExternal(const std::string& name) {
+    ResourceNode node = { name, RESOURCE_EXTERNAL, RenderTargetDesc(GL_RGBA8, 0, 0), -1, -1, -1, false };
+    resources.push_back(node);
+    return static_cast<Resource>(resources.size()) - 1;
+}
+
+void RenderGraph::setBackbufferClear(const glm::vec4& color) {
+    resources[BACKBUFFER].desc.clearValue = color;
+}
+
+int RenderGraph::addPass(const std::string& name, int viewportWidth, int viewportHeight, const PassFunction& function) {
+    PassNode node = { name, viewportWidth, viewportHeight, function, std::vector<Resource>(), std::vector<Resource>(), false, 0 };
+    passes.push_back(node);
+    return static_cast<int>(passes.size()) - 1;
+}
+
+void RenderGraph::read(int pass, Resource resource) {
+    passes[pass].reads.push_back(resource);
+}
+
+void RenderGraph::write(int pass, Resource resource) {
+    passes[pass].writes.push_back(resource);
+}
+
+void RenderGraph::execute() {
+    frame++;
+    cull();
+    allocate();
+    for (int index : executed) {
+        PassNode& pass = passes[index];
+        bindPass(pass);
+        pass.function(*this);
+    }
+    trimPool();
+}
+
+GLuint RenderGraph::texture(Resource resource) const {
+    const ResourceNode& node = resources[resource];
+    return node.physical >= 0 ? pool[node.physical].texture : 0;
+}
+
+std::string RenderGraph::describe() const {
+    std::string text;
+    for (size_t i = 0; i < passes.size(); ++i) {
+        if (i > 0) text += ", ";
+        text += passes[i].culled ? "(" + passes[i].name + ")" : passes[i].name;
+    }
+    return text;
+}
+
+void RenderGraph::cull() {
+    // Walk back from the backbuffer: a pass is kept if a kept pass after it reads something it
+    // writes, and then everything it reads is needed too.
+    std::vector<bool> needed(resources.size(), false);
+    needed[BACKBUFFER] = true;
+    for (int i = static_cast<int>(passes.size()) - 1; i >= 0; --i) {
+        PassNode& pass = passes[i];
+        pass.culled = true;
+        for (Resource written : pass.writes) {
+            if (needed[written]) pass.culled = false;
+        }
+        if (pass.culled) continue;
+        for (Resource readFrom : pass.reads) needed[readFrom] = true;
+    }
+    executed.clear();
+    for (size_t i = 0; i < passes.size(); ++i) {
+        if (!passes[i].culled) executed.push_back(static_cast<int>(i));
+    }
+}
+
+void RenderGraph::allocate() {
+    for (size_t step = 0; step < executed.size(); ++step) {
+        const PassNode& pass = passes[executed[step]];
+        for (int use = 0; use < 2; ++use) {
+            for (Resource resource : use == 0 ? pass.reads : pass.writes) {
+                ResourceNode& node = resources[resource];
+                if (node.firstUse < 0) node.firstUse = static_cast<int>(step);
+                node.lastUse = static_cast<int>(step);
+            }
+        }
+    }
+
+    // Hand out pool textures in execution order, returning each as soon as its last user is
+    // done, so a later target of the same description can take it over.
+    RenderGraphStats stats = RenderGraphStats();
+    stats.passes = static_cast<unsigned int>(passes.size());
+    stats.culledPasses = static_cast<unsigned int>(passes.size() - executed.size());
+    size_t liveBytes = 0;
+    std::vector<bool> physicalUsed;
+    for (size_t step = 0; step < executed.size(); ++step) {
+        for (auto& node : resources) {
+            if (node.kind != RESOURCE_TARGET || node.firstUse != static_cast<int>(step)) continue;
+            node.physical = acquireTexture(node.desc);
+            size_t bytes = pool[node.physical].bytes;
+            liveBytes += bytes;
+            stats.transientTargets++;
+            stats.unaliasedBytes += bytes;
+            if (physicalUsed.size() < pool.size()) physicalUsed.resize(pool.size(), false);
+            if (!physicalUsed[node.physical]) stats.physicalTargets++;
+            physicalUsed[node.physical] = true;
+        }
+        stats.peakTransientBytes = std::max(stats.peakTransientBytes, liveBytes);
+        for (auto& node : resources) {
+            if (node.kind != RESOURCE_TARGET || node.lastUse != static_cast<int>(step)) continue;
+            pool[node.physical].inUse = false;
+            liveBytes -= pool[node.physical].bytes;
+        }
+    }
+    for (const auto& texture : pool) stats.poolBytes += texture.bytes;
+    lastStats = stats;
+}
+
+int RenderGraph::acquireTexture(const RenderTargetDesc& desc) {
+    for (size_t i = 0; i < pool.size(); ++i) {
+        if (!pool[i].inUse && sameDesc(pool[i].desc, desc)) {
+            pool[i].inUse = true;
+            pool[i].lastUsedFrame = frame;
+            return static_cast<int>(i);
+        }
+    }
+
+    const TargetFormat& format = formatOf(desc.internalFormat);
+    PoolTexture texture = { 0, desc, bytesOf(desc), true, frame };
+    glGenTextures(1, &texture.texture);
+    GLState::get().bindTexture(0, GL_TEXTURE_2D, texture.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0, format.format, format.type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    pool.push_back(texture);
+    return static_cast<int>(pool.size()) - 1;
+}
+
+GLuint RenderGraph::framebufferFor(const PassNode& pass) {
+    std::vector<GLuint> colors;
+    GLuint depth = 0;
+    for (Resource written : pass.writes) {
+        const ResourceNode& node = resources[written];
+        if (node.kind != RESOURCE_TARGET) continue;
+        if (formatOf(node.desc.internalFormat).depth) depth = pool[node.physical].texture;
+        else colors.push_back(pool[node.physical].texture);
+    }
+    for (const auto& cached : framebuffers) {
+        if (cached.colors == colors && cached.depth == depth) return cached.framebuffer;
+    }
+
+    CachedFramebuffer cached = { 0, colors, depth };
+    glGenFramebuffers(1, &cached.framebuffer);
+    GLState::get().bindFramebuffer(GL_FRAMEBUFFER, cached.framebuffer);
+    std::vector<GLenum> drawBuffers;
+    for (size_t i = 0; i < colors.size(); ++i) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i), GL_TEXTURE_2D, colors[i], 0);
+        drawBuffers.push_back(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i));
+    }
+    if (depth) glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    if (drawBuffers.empty()) {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    else {
+        glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+    }
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE " << pass.name << std::endl;
+    }
+    framebuffers.push_back(cached);
+    return cached.framebuffer;
+}
+
+void RenderGraph::bindPass(PassNode& pass) {
+    GLState& state = GLState::get();
+    bool backbuffer = false, targets = false;
+    for (Resource written : pass.writes) {
+        backbuffer = backbuffer || resources[written].kind == RESOURCE_BACKBUFFER;
+        targets = targets || resources[written].kind == RESOURCE_TARGET;
+    }
+    if (!backbuffer && !targets) return; // works on external state only
+
+    pass.framebuffer = backbuffer ? backbufferFramebuffer : framebufferFor(pass);
+    state.bindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer);
+    if (pass.viewportWidth > 0 && pass.viewportHeight > 0) state.viewport(0, 0, pass.viewportWidth, pass.viewportHeight);
+
+    // Whatever this pass writes first in the frame starts out cleared, all of it
+    GLint colorIndex = 0;
+    bool masksReset = false;
+    for (Resource written : pass.writes) {
+        ResourceNode& node = resources[written];
+        bool depth = node.kind == RESOURCE_TARGET && formatOf(node.desc.internalFormat).depth;
+        if (node.kind != RESOURCE_EXTERNAL && !node.cleared) {
+            if (!masksReset) {
+                state.colorMask(true, true, true, true);
+                state.depthMask(true);
+                state.disable(GL_SCISSOR_TEST);
+                masksReset = true;
+            }
+            float depthClear = 1.0f;
+            if (node.kind == RESOURCE_BACKBUFFER) {
+                glClearBufferfv(GL_COLOR, 0, &node.desc.clearValue.x);
+                glClearBufferfv(GL_DEPTH, 0, &depthClear);
+            }
+            else if (depth) {
+                depthClear = node.desc.clearValue.x;
+                glClearBufferfv(GL_DEPTH, 0, &depthClear);
+            }
+            else {
+                glClearBufferfv(GL_COLOR, colorIndex, &node.desc.clearValue.x);
+            }
+            node.cleared = true;
+        }
+        if (node.kind == RESOURCE_TARGET && !depth) colorIndex++;
+    }
+}
+
+void RenderGraph::trimPool() {
+    GLState& state = GLState::get();
+    for (size_t i = pool.size(); i-- > 0;) {
+        if (frame - pool[i].lastUsedFrame <= POOL_KEEP_FRAMES) continue;
+        GLuint texture = pool[i].texture;
+        for (size_t j = framebuffers.size(); j-- > 0;) {
+            const CachedFramebuffer& cached = framebuffers[j];
+            if (cached.depth != texture && std::find(cached.colors.begin(), cached.colors.end(), texture) == cached.colors.end()) continue;
+            state.deleteFramebuffer(cached.framebuffer);
+            framebuffers.erase(framebuffers.begin() + j);
+        }
+        state.deleteTexture(texture);
+        pool.erase(pool.begin() + i);
+    }
+}
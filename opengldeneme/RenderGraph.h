@@ -0,0 +1,134 @@
+#pragma once
+// RenderGraph.h
+// The frame as a list of passes that declare which resources they read and write. Built again
+// every frame: passes whose results nothing reads are culled, the rest run in dependency order.
+// Render targets declared in the graph are transient: they only exist from their first to their
+// last use and come from a pool, so targets whose lifetimes don't overlap share one texture, and
+// targets that stop being used (say the G-buffer after switching to forward) are freed after a
+// while. Each pass that writes targets gets a framebuffer with them attached, cleared on the
+// first write of the frame. State that lives across frames (the shadow atlas, the light lists)
+// is imported as an external resource, which only orders and keeps the passes that use it.
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct RenderTargetDesc {
+    GLenum internalFormat;  // one of the formats in RenderGraph.cpp
+    int width, height;
+    GLenum filter;
+    glm::vec4 clearValue;   // color, or depth in x
+
+    RenderTargetDesc(GLenum internalFormat, int width, int height, GLenum filter = GL_NEAREST,
+        const glm::vec4& clearValue = glm::vec4(0.0f));
+    // A 24-bit depth target cleared to the far plane.
+    static RenderTargetDesc depth(int width, int height);
+};
+
+struct RenderGraphStats {
+    unsigned int passes;
+    unsigned int culledPasses;
+    unsigned int transientTargets;
+    unsigned int physicalTargets;   // pool textures this frame's targets were placed in
+    size_t peakTransientBytes;      // most target memory in use at once during the frame
+    size_t unaliasedBytes;          // what the targets would take with a texture each
+    size_t poolBytes;               // all pool textures, including idle ones not yet freed
+};
+
+class RenderGraph {
+public:
+    typedef int Resource;
+    typedef std::function<void(RenderGraph&)> PassFunction;
+
+    // The default framebuffer; a pass writing it is drawn there.
+    static const Resource BACKBUFFER = 0;
+    // Frames a pool texture survives unused before it is freed.
+    static const unsigned int POOL_KEEP_FRAMES = 60;
+
+    RenderGraph();
+
+    void shutdown();
+
+    // Starts building a new frame; the pool is kept.
+    void reset();
+    Resource createTarget(const std::string& name, const RenderTargetDesc& desc);
+    Resource importExternal(const std::string& name);
+    // What the backbuffer's color is cleared to on its first write.
+    void setBackbufferClear(const glm::vec4& color);
+    // Where BACKBUFFER is drawn: the window (0) or an offscreen framebuffer with color and depth.
+    void setBackbuffer(GLuint framebuffer) { backbufferFramebuffer = framebuffer; }
+    GLuint backbuffer() const { return backbufferFramebuffer; }
+    // Passes run with their viewport set to width x height (0 leaves it alone).
+    int addPass(const std::string& name, int viewportWidth, int viewportHeight, const PassFunction& function);
+    void read(int pass, Resource resource);
+    // Color targets are attached in the order they are written.
+    void write(int pass, Resource resource);
+
+    // Culls and allocates, then runs the passes in the order they were added. A pass can only
+    // depend on passes added before it, so that order already respects every dependency.
+    void execute();
+
+    // The texture of a target, for passes reading it.
+    GLuint texture(Resource resource) const;
+    const RenderGraphStats& stats() const { return lastStats; }
+    // Passes of the last execute() in the order they ran; culled ones are marked.
+    std::string describe() const;
+
+private:
+    enum ResourceKind { RESOURCE_BACKBUFFER, RESOURCE_EXTERNAL, RESOURCE_TARGET };
+
+    struct ResourceNode {
+        std::string name;
+        ResourceKind kind;
+        RenderTargetDesc desc;
+        int firstUse, lastUse;  // in execution order
+        int physical;           // pool index while allocated
+        bool cleared;
+    };
+
+    struct PassNode {
+        std::string name;
+        int viewportWidth, viewportHeight;
+        PassFunction function;
+        std::vector<Resource> reads;
+        std::vector<Resource> writes;
+        bool culled;
+        GLuint framebuffer;
+    };
+
+    struct PoolTexture {
+        GLuint texture;
+        RenderTargetDesc desc;
+        size_t bytes;
+        bool inUse;
+        unsigned int lastUsedFrame;
+    };
+
+    struct CachedFramebuffer {
+        GLuint framebuffer;
+        std::vector<GLuint> colors;
+        GLuint depth;
+    };
+
+    void cull();
+    void allocate();
+    int acquireTexture(const RenderTargetDesc& desc);
+    GLuint framebufferFor(const PassNode& pass);
+    void bindPass(PassNode& pass);
+    void trimPool();
+
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode> passes;
+    std::vector<int> executed; // kept passes, in order
+    std::vector<PoolTexture> pool;
+    std::vector<CachedFramebuffer> framebuffers;
+    unsigned int frame;
+    GLuint backbufferFramebuffer;
+    RenderGraphStats lastStats;
+};
+
+#endif
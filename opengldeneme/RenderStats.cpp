@@ -0,0 +1,46 @@
+// RenderStats.cpp
+#include "RenderStats.h"
+#include "GLState.h"
+#include <cstring>
+
+void FrameStats::clear() {
+    memset(this, 0, sizeof(*this));
+}
+
+RenderStats& RenderStats::get() {
+    static RenderStats instance;
+    return instance;
+}
+
+RenderStats::RenderStats() {
+    current.clear();
+    last.clear();
+}
+
+void RenderStats::beginFrame() {
+    current.clear();
+}
+
+void RenderStats::endFrame() {
+    const GLStateCounters& counters = GLState::get().frameCounters();
+    current.programSwitches = counters.issued[GLSTATE_PROGRAM];
+    current.vaoSwitches = counters.issued[GLSTATE_VERTEX_ARRAY];
+    current.textureSwitches = counters.issued[GLSTATE_TEXTURE];
+    last = current;
+}
+
+void RenderStats::recordDraw(GLenum mode, GLsizei vertexCount, GLsizei instanceCount) {
+    current.drawCalls++;
+    current.instances += instanceCount;
+    if (mode == GL_TRIANGLES) {
+        current.triangles += (unsigned long long)(vertexCount / 3) * instanceCount;
+    }
+    else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) {
+        if (vertexCount > 2) current.triangles += (unsigned long long)(vertexCount - 2) * instanceCount;
+    }
+}
+
+void RenderStats::recordObjects(unsigned int submitted, unsigned int culled) {
+    current.objectsSubmitted += submitted;
+    current.objectsCulled += culled;
+}
@@ -0,0 +1,52 @@
+#pragma once
+// RenderStats.h
+// Per-frame workload counters (draw calls, triangles, uploads, state switches, culling).
+// Plain integer increments so they stay on in release builds.
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+struct FrameStats {
+    unsigned int drawCalls;
+    unsigned int instances;
+    unsigned long long triangles;
+    unsigned int uniformUploads;
+    unsigned long long bufferBytesUploaded;
+    unsigned long long textureBytesUploaded;
+    unsigned int programSwitches;
+    unsigned int vaoSwitches;
+    unsigned int textureSwitches;
+    unsigned int objectsSubmitted;
+    unsigned int objectsCulled;
+
+    void clear();
+};
+
+class RenderStats {
+public:
+    static RenderStats& get();
+
+    void beginFrame();
+    // Pulls the state switch counts out of GLState, call after GLState::endFrame().
+    void endFrame();
+
+    void recordDraw(GLenum mode, GLsizei vertexCount, GLsizei instanceCount = 1);
+    void recordUniformUpload() { current.uniformUploads++; }
+    void recordBufferUpload(size_t bytes) { current.bufferBytesUploaded += bytes; }
+    void recordTextureUpload(size_t bytes) { current.textureBytesUploaded += bytes; }
+    void recordObjects(unsigned int submitted, unsigned int culled);
+
+    // Counters of the frame in progress and of the last completed frame.
+    const FrameStats& frame() const { return current; }
+    const FrameStats& lastFrame() const { return last; }
+
+private:
+    RenderStats();
+
+    FrameStats current;
+    FrameStats last;
+};
+
+#endif
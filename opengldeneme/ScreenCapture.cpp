@@ -0,0 +1,377 @@
+// ScreenCapture.cpp
+#include "ScreenCapture.h"
+#include "GLState.h"
+#include "PngFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+    // A stall longer than this (say a dragged window) is cut from the video instead of filled
+    const float MAX_REPEAT_SECONDS = 1.0f;
+    const unsigned long long FENCE_TIMEOUT_NS = 1000000000ull;
+
+    std::string timestamp() {
+        std::time_t now = std::time(nullptr);
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y%m%d-%H%M%S", std::localtime(&now));
+        return text;
+    }
+
+    unsigned char clampByte(int value) {
+        return static_cast<unsigned char>(value < 0 ? 0 : value > 255 ? 255 : value);
+    }
+
+    // RGBA bottom row first to planar 4:2:0 top row first, full-range BT.601 as C420jpeg means.
+    void convertToI420(const unsigned char* rgba, int sourceWidth, int sourceHeight, int width, int height,
+        std::vector<unsigned char>& out) {
+        out.resize(static_cast<size_t>(width) * height * 3 / 2);
+        unsigned char* yPlane = out.data();
+        unsigned char* cbPlane = yPlane + width * height;
+        unsigned char* crPlane = cbPlane + (width / 2) * (height / 2);
+        for (int y = 0; y < height; y += 2) {
+            const unsigned char* rows[2] = {
+                rgba + static_cast<size_t>(sourceHeight - 1 - y) * sourceWidth * 4,
+                rgba + static_cast<size_t>(sourceHeight - 2 - y) * sourceWidth * 4 };
+            for (int x = 0; x < width; x += 2) {
+                int r = 0, g = 0, b = 0;
+                for (int dy = 0; dy < 2; ++dy) {
+                    for (int dx = 0; dx < 2; ++dx) {
+                        const unsigned char* pixel = rows[dy] + (x + dx) * 4;
+                        yPlane[(y + dy) * width + x + dx] = clampByte((77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8);
+                        r += pixel[0];
+                        g += pixel[1];
+                        b += pixel[2];
+                    }
+                }
+                // Sums of four pixels, so the shift is two bits longer
+                int chroma = (y / 2) * (width / 2) + x / 2;
+                cbPlane[chroma] = clampByte((-43 * r - 85 * g + 128 * b + (128 << 10) + 512) >> 10);
+                crPlane[chroma] = clampByte((128 * r - 107 * g - 21 * b + (128 << 10) + 512) >> 10);
+            }
+        }
+    }
+}
+
+ScreenCapture::ScreenCapture()
+    : nextSlot(0), source(0), dropFrames(true), screenshotRequested(false), screenshotCount(0), recording(false), format(CAPTURE_PNG_SEQUENCE),
+    fps(60.0f), startTime(0.0), firstFrameNumber(0), sampledFrames(0), videoFrames(0), capturedFrames(0), droppedFrames(0), writtenFrames(0),
+    readbackMs(0.0f), busyEncoders(0), stopping(false) {
+    for (auto& readback : ring) readback = Readback();
+}
+
+void ScreenCapture::init(unsigned int encoderCount, const std::string& directory) {
+    this->directory = directory;
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+    if (encoderCount == 0) encoderCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+    stopping = false;
+    for (unsigned int i = 0; i < encoderCount; ++i) workers.push_back(std::thread(&ScreenCapture::workerLoop, this));
+}
+
+void ScreenCapture::shutdown() {
+    stopRecording();
+    for (auto& readback : ring) {
+        if (readback.fence) finishReadback(readback, true);
+        GLState::get().deleteBuffer(readback.buffer);
+        readback = Readback();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) worker.join(); // they empty the queue first
+    workers.clear();
+    video.reset();
+}
+
+void ScreenCapture::screenshot() {
+    screenshotRequested = true;
+}
+
+void ScreenCapture::startRecording(CaptureFormat format, float fps, const std::string& name, unsigned int firstFrame) {
+    stopRecording();
+    this->format = format;
+    this->fps = std::max(1.0f, fps);
+    recording = true;
+    recordingName = name.empty() ? directory + "/recording-" + timestamp() : name;
+    firstFrameNumber = firstFrame;
+    startTime = -1.0;
+    sampledFrames = 0;
+    videoFrames = 0;
+    capturedFrames = 0;
+    droppedFrames = 0;
+    writtenFrames = 0;
+}
+
+void ScreenCapture::stopRecording() {
+    if (!recording) return;
+    recording = false;
+    for (int i = 0; i < RING_SIZE; ++i) {
+        Readback& readback = ring[(nextSlot + i) % RING_SIZE];
+        if (readback.fence) finishReadback(readback, true);
+    }
+    video.reset(); // the encoders hold it until its last frame is written
+}
+
+unsigned int ScreenCapture::pendingReadbacks() const {
+    unsigned int count = 0;
+    for (const auto& readback : ring) count += readback.fence ? 1 : 0;
+    return count;
+}
+
+void ScreenCapture::capture(int width, int height, double time) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Collect what the GPU has finished copying, oldest first and stopping at the first still in
+    // flight, so the video's frames are handed out in order
+    for (int i = 0; i < RING_SIZE; ++i) {
+        Readback& readback = ring[(nextSlot + i) % RING_SIZE];
+        if (readback.fence && !finishReadback(readback, false)) break;
+    }
+
+    // Frame times since the last sample; a frame drawn late stands for the ones it missed
+    unsigned int due = 0;
+    if (recording) {
+        if (startTime < 0.0) startTime = time;
+        unsigned int elapsed = static_cast<unsigned int>(std::floor((time - startTime) * fps + 0.5)) + 1; // nearest frame time
+        due = elapsed > sampledFrames ? elapsed - sampledFrames : 0;
+        unsigned int maxRepeat = static_cast<unsigned int>(fps * MAX_REPEAT_SECONDS);
+        if (due > maxRepeat) {
+            sampledFrames += due - 1;
+            due = 1;
+        }
+        // A video keeps the size it started with
+        if (due > 0 && format == CAPTURE_Y4M) {
+            if (!video) {
+                video = std::make_shared<VideoStream>();
+                video->width = width & ~1;
+                video->height = height & ~1;
+                video->nextFrame = 0;
+                std::string path = recordingName + ".y4m";
+                video->file.open(path.c_str(), std::ios::binary);
+                if (!video->file) std::cerr << "ERROR::SCREEN_CAPTURE::CANNOT_OPEN " << path << std::endl;
+                char header[128];
+                std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n",
+                    video->width, video->height, static_cast<int>(fps * 1000.0f + 0.5f));
+                video->file << header;
+            }
+            if ((width & ~1) != video->width || (height & ~1) != video->height) {
+                droppedFrames++;
+                due = 0;
+            }
+        }
+    }
+
+    bool wanted = screenshotRequested || due > 0;
+    size_t queued;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (wanted && !dropFrames) {
+            size_t limit = MAX_QUEUED_FRAMES - pendingReadbacks();
+            encodedCondition.wait(lock, [this, limit]() { return jobs.size() + busyEncoders < limit; });
+        }
+        queued = jobs.size() + busyEncoders;
+    }
+    // Behind encoders drop video frames before the readback; the next one covers their time
+    if (wanted && queued + pendingReadbacks() >= MAX_QUEUED_FRAMES) {
+        if (due > 0) droppedFrames++;
+        wanted = false;
+    }
+    if (wanted && width > 0 && height > 0) {
+        Readback& readback = ring[nextSlot];
+        if (readback.fence) finishReadback(readback, true); // RING_SIZE - 1 frames old by now
+        GLState& state = GLState::get();
+        if (!readback.buffer) glGenBuffers(1, &readback.buffer);
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+        if (readback.capacity < bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            readback.capacity = bytes;
+        }
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, source);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // returns at once into the buffer
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readback.width = width;
+        readback.height = height;
+        readback.screenshot = screenshotRequested;
+        readback.repeat = due;
+        readback.firstFrame = sampledFrames;
+        screenshotRequested = false;
+        sampledFrames += due;
+        if (due > 0) capturedFrames++;
+        nextSlot = (nextSlot + 1) % RING_SIZE;
+    }
+    readbackMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+ScreenCaptureStats ScreenCapture::stats() {
+    ScreenCaptureStats stats;
+    stats.recording = recording;
+    stats.capturedFrames = capturedFrames;
+    stats.writtenFrames = writtenFrames;
+    stats.droppedFrames = droppedFrames;
+    stats.pendingReadbacks = pendingReadbacks();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stats.queuedFrames = static_cast<unsigned int>(jobs.size()) + busyEncoders;
+    }
+    stats.readbackMs = readbackMs;
+    return stats;
+}
+
+bool ScreenCapture::finishReadback(Readback& readback, bool wait) {
+    if (!wait && glClientWaitSync(readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+    while (wait && glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(readback.fence);
+    readback.fence = 0;
+
+    EncodeJob job;
+    job.width = readback.width;
+    job.height = readback.height;
+    job.firstFrame = readback.firstFrame;
+    job.repeat = readback.repeat;
+    job.recorded = true;
+    job.pixels = takeBuffer();
+    size_t bytes = static_cast<size_t>(readback.width) * readback.height * 4;
+    GLState& state = GLState::get();
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (mapped) {
+        job.pixels.resize(bytes);
+        std::memcpy(job.pixels.data(), mapped, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!mapped) {
+        // The frame is lost; the video simply carries on with the next one
+        std::cerr << "ERROR::SCREEN_CAPTURE::MAP_FAILED" << std::endl;
+        if (readback.repeat > 0) droppedFrames++;
+        return true;
+    }
+
+    if (readback.screenshot) {
+        EncodeJob shot;
+        shot.width = job.width;
+        shot.height = job.height;
+        shot.firstFrame = 0;
+        shot.repeat = 1;
+        shot.recorded = false;
+        char name[32];
+        std::snprintf(name, sizeof(name), "-%u.png", ++screenshotCount);
+        shot.paths.push_back(directory + "/screenshot-" + timestamp() + name);
+        if (readback.repeat > 0) {
+            shot.pixels = takeBuffer();
+            shot.pixels.assign(job.pixels.begin(), job.pixels.end());
+        }
+        else {
+            shot.pixels.swap(job.pixels);
+        }
+        enqueue(shot);
+    }
+    if (readback.repeat == 0) return true;
+    if (format == CAPTURE_Y4M) {
+        // Numbered by position in the file rather than by frame time: the writer waits for every
+        // number before the next, and a stall cut short or a lost frame must not leave it waiting
+        job.video = video;
+        job.firstFrame = videoFrames;
+        videoFrames += job.repeat;
+    }
+    else {
+        for (unsigned int i = 0; i < job.repeat; ++i) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "-%06u.png", firstFrameNumber + job.firstFrame + i);
+            job.paths.push_back(recordingName + name);
+        }
+    }
+    enqueue(job);
+    return true;
+}
+
+void ScreenCapture::enqueue(EncodeJob& job) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        jobs.push_back(EncodeJob());
+        std::swap(jobs.back(), job);
+    }
+    queueCondition.notify_one();
+}
+
+std::vector<unsigned char> ScreenCapture::takeBuffer() {
+    std::vector<unsigned char> buffer;
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (!freeBuffers.empty()) {
+        buffer.swap(freeBuffers.back());
+        freeBuffers.pop_back();
+    }
+    return buffer;
+}
+
+void ScreenCapture::workerLoop() {
+    for (;;) {
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            std::swap(job, jobs.front());
+            jobs.pop_front();
+            busyEncoders++;
+        }
+        if (job.video) writeY4m(job);
+        else writePng(job);
+        std::lock_guard<std::mutex> lock(queueMutex);
+        busyEncoders--;
+        // Frame-sized buffers are kept for the next readbacks instead of reallocated
+        if (freeBuffers.size() < MAX_QUEUED_FRAMES) freeBuffers.push_back(std::move(job.pixels));
+        encodedCondition.notify_all();
+    }
+}
+
+void ScreenCapture::writePng(EncodeJob& job) {
+    std::vector<unsigned char> png;
+    encodePng(job.width, job.height, job.pixels.data(), true, png);
+    for (const auto& path : job.paths) {
+        std::ofstream file(path.c_str(), std::ios::binary);
+        if (!file.write(reinterpret_cast<const char*>(png.data()), png.size())) {
+            std::cerr << "ERROR::SCREEN_CAPTURE::WRITE_FAILED " << path << std::endl;
+            continue;
+        }
+        if (job.recorded) writtenFrames++;
+    }
+}
+
+void ScreenCapture::writeY4m(EncodeJob& job) {
+    VideoStream& stream = *job.video;
+    std::vector<unsigned char> frame;
+    convertToI420(job.pixels.data(), job.width, job.height, stream.width, stream.height, frame);
+
+    std::lock_guard<std::mutex> lock(stream.mutex);
+    stream.converted[job.firstFrame] = std::make_pair(job.repeat, std::vector<unsigned char>());
+    stream.converted[job.firstFrame].second.swap(frame);
+    // Frames converted ahead of an earlier one wait here until it is written
+    while (!stream.converted.empty() && stream.converted.begin()->first == stream.nextFrame) {
+        const std::pair<unsigned int, std::vector<unsigned char> >& next = stream.converted.begin()->second;
+        for (unsigned int i = 0; i < next.first; ++i) {
+            stream.file << "FRAME\n";
+            stream.file.write(reinterpret_cast<const char*>(next.second.data()), next.second.size());
+        }
+        stream.nextFrame += next.first;
+        writtenFrames += next.first;
+        stream.converted.erase(stream.converted.begin());
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+// ScreenCapture.h
+// Screenshots and video capture without stalling the GPU. Each captured frame is read into one of
+// a ring of pixel-pack buffers, which the copy finishes into asynchronously; the buffer is only
+// mapped once its fence has signalled, or when the ring comes round to it RING_SIZE - 1 frames
+// later. The pixels then go to a pool of encoder threads, which write PNG files (a numbered
+// sequence while recording) or one raw Y4M video. Runs on the GL thread, before the UI is drawn.
+#ifndef SCREEN_CAPTURE_H
+#define SCREEN_CAPTURE_H
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum CaptureFormat {
+    CAPTURE_PNG_SEQUENCE,
+    CAPTURE_Y4M             // 4:2:0 full-range YCbCr, the raw input ffmpeg and most encoders take
+};
+
+struct ScreenCaptureStats {
+    bool recording;
+    unsigned int capturedFrames;    // frames of the current or last recording read back
+    unsigned int writtenFrames;     // ... and on disk, repeats included
+    unsigned int droppedFrames;     // ... skipped because the encoders were too far behind
+    unsigned int pendingReadbacks;
+    unsigned int queuedFrames;      // waiting for or being encoded
+    float readbackMs;               // GL thread time of the last capture: issuing, mapping, copying
+};
+
+class ScreenCapture {
+public:
+    static const int RING_SIZE = 3;
+    // Frames waiting for an encoder before further ones are dropped.
+    static const size_t MAX_QUEUED_FRAMES = 8;
+
+    ScreenCapture();
+
+    // Encoders default to half the cores; files go to directory, which is created if needed.
+    void init(unsigned int encoderCount, const std::string& directory);
+    // Waits for the readbacks and encoders, so nothing captured is lost.
+    void shutdown();
+
+    // The next capture() saves the frame as a PNG.
+    void screenshot();
+    // Samples the frames drawn at fps, repeating a frame when drawing falls behind that rate.
+    // Files are named after the start time unless name is given; PNG numbers start at firstFrame.
+    void startRecording(CaptureFormat format, float fps, const std::string& name = std::string(), unsigned int firstFrame = 0);
+    // Collects the readbacks still in flight; the encoders finish in the background.
+    void stopRecording();
+    bool isRecording() const { return recording; }
+    // True while capture() has something to do this frame.
+    bool isActive() const { return recording || screenshotRequested || pendingReadbacks() > 0; }
+
+    // Once per frame with the scene complete in the source framebuffer; time is when the frame
+    // is shown, in seconds.
+    void capture(int width, int height, double time);
+
+    // The framebuffer read from, the window's by default.
+    void setSource(GLuint framebuffer) { source = framebuffer; }
+    // Offline rendering waits for the encoders instead of dropping frames.
+    void setDropFrames(bool drop) { dropFrames = drop; }
+
+    ScreenCaptureStats stats();
+
+private:
+    struct Readback {
+        GLuint buffer;
+        GLsync fence;
+        int width, height;
+        size_t capacity;
+        unsigned int repeat;    // video frames this one stands for; 0 for a screenshot alone
+        unsigned int firstFrame;
+        bool screenshot;
+    };
+
+    // One Y4M file. Frames are converted in parallel but written in order, and the file closes
+    // when the last job of its recording is done.
+    struct VideoStream {
+        std::mutex mutex;
+        std::ofstream file;
+        int width, height;  // even, the odd row or column of the window is cropped
+        std::map<unsigned int, std::pair<unsigned int, std::vector<unsigned char> > > converted; // by position in the file: repeat, I420
+        unsigned int nextFrame;
+    };
+
+    struct EncodeJob {
+        std::vector<std::string> paths;     // PNG: a file per copy of the frame
+        std::shared_ptr<VideoStream> video; // Y4M
+        unsigned int firstFrame;            // PNG: frame time of the recording; Y4M: position in the file
+        unsigned int repeat;
+        bool recorded;                      // counts towards the recording's written frames
+        int width, height;
+        std::vector<unsigned char> pixels;  // RGBA, bottom row first
+    };
+
+    unsigned int pendingReadbacks() const;
+    // False while the copy is still in flight; readbacks are finished oldest first.
+    bool finishReadback(Readback& readback, bool wait);
+    void enqueue(EncodeJob& job);
+    std::vector<unsigned char> takeBuffer();
+    void workerLoop();
+    void writePng(EncodeJob& job);
+    void writeY4m(EncodeJob& job);
+
+    Readback ring[RING_SIZE];
+    int nextSlot;
+    GLuint source;
+    bool dropFrames;
+    std::string directory;
+    bool screenshotRequested;
+    unsigned int screenshotCount;
+    bool recording;
+    CaptureFormat format;
+    float fps;
+    double startTime;
+    std::string recordingName;    // files of this recording start with it
+    unsigned int firstFrameNumber;
+    std::shared_ptr<VideoStream> video;
+    unsigned int sampledFrames;   // frame times covered so far, repeats included
+    unsigned int videoFrames;     // Y4M frames handed to the encoders, so cut stalls leave no gap
+    unsigned int capturedFrames;
+    unsigned int droppedFrames;
+    std::atomic<unsigned int> writtenFrames;
+    float readbackMs;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::condition_variable encodedCondition; // an encoder finished a job
+    std::deque<EncodeJob> jobs;
+    std::vector<std::vector<unsigned char> > freeBuffers;
+    unsigned int busyEncoders;
+    std::vector<std::thread> workers;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,166 @@
+// SearchIndex.cpp
+#include "SearchIndex.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace {
+    std::string lowercase(const std::string& text) {
+        std::string lowered(text);
+        for (char& c : lowered) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return lowered;
+    }
+
+    unsigned int trigram(unsigned char a, unsigned char b, unsigned char c) {
+        return static_cast<unsigned int>(a) << 16 | static_cast<unsigned int>(b) << 8 | c;
+    }
+
+    void sortUnique(std::vector<unsigned int>& values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+    // The distinct trigrams of a lowercased document, sorted. One starts at every byte of every
+    // field, the last two of a field padded with newlines, so a query of one or two bytes is
+    // always the start of some trigram; none start with a newline or continue past one.
+    void documentTrigrams(const std::string& text, std::vector<unsigned int>& trigrams) {
+        trigrams.clear();
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '\n') continue;
+            char b = i + 1 < text.size() ? text[i + 1] : '\n';
+            char c = b != '\n' && i + 2 < text.size() ? text[i + 2] : '\n';
+            trigrams.push_back(trigram(text[i], b, c));
+        }
+        sortUnique(trigrams);
+    }
+
+    // The distinct trigrams inside a query of three bytes or more.
+    void queryTrigrams(const std::string& query, std::vector<unsigned int>& trigrams) {
+        trigrams.clear();
+        for (size_t i = 0; i + 3 <= query.size(); ++i) trigrams.push_back(trigram(query[i], query[i + 1], query[i + 2]));
+        sortUnique(trigrams);
+    }
+
+    // First position at or after from holding id or more: steps of doubling size, then a binary
+    // search in the last one, so skipping far ahead costs a few probes.
+    size_t gallop(const std::vector<unsigned int>& list, size_t from, unsigned int id) {
+        size_t low = from, high = from, step = 1;
+        while (high < list.size() && list[high] < id) {
+            low = high + 1;
+            high += step;
+            step *= 2;
+        }
+        high = std::min(high, list.size());
+        return std::lower_bound(list.begin() + low, list.begin() + high, id) - list.begin();
+    }
+}
+
+void SearchIndex::set(unsigned int id, const std::string& text) {
+    remove(id);
+    std::string lowered = lowercase(text);
+    if (lowered.empty()) return;
+    if (documents.size() <= id) documents.resize(id + 1);
+    std::vector<unsigned int> trigrams;
+    documentTrigrams(lowered, trigrams);
+    for (unsigned int trigram : trigrams) {
+        std::vector<unsigned int>& list = postings[trigram];
+        // Documents usually arrive in id order, which appends
+        if (list.empty() || list.back() < id) list.push_back(id);
+        else list.insert(std::lower_bound(list.begin(), list.end(), id), id);
+    }
+    documents[id].swap(lowered);
+    count++;
+}
+
+void SearchIndex::remove(unsigned int id) {
+    if (id >= documents.size() || documents[id].empty()) return;
+    std::vector<unsigned int> trigrams;
+    documentTrigrams(documents[id], trigrams);
+    for (unsigned int trigram : trigrams) {
+        auto found = postings.find(trigram);
+        if (found == postings.end()) continue;
+        std::vector<unsigned int>& list = found->second;
+        auto position = std::lower_bound(list.begin(), list.end(), id);
+        if (position != list.end() && *position == id) list.erase(position);
+        if (list.empty()) postings.erase(found);
+    }
+    std::string().swap(documents[id]);
+    count--;
+}
+
+void SearchIndex::clear() {
+    documents.clear();
+    postings.clear();
+    count = 0;
+}
+
+bool SearchIndex::search(const std::string& query, size_t maxResults, std::vector<unsigned int>& results) const {
+    results.clear();
+    std::string needle = lowercase(query);
+    if (needle.find('\n') != std::string::npos) return true;
+
+    if (needle.empty()) {
+        for (unsigned int id = 0; id < documents.size(); ++id) {
+            if (documents[id].empty()) continue;
+            if (results.size() == maxResults) return false;
+            results.push_back(id);
+        }
+        return true;
+    }
+
+    if (needle.size() < 3) {
+        // Every trigram starting with the query: the union of their lists, merged in id order
+        unsigned int first = trigram(needle[0], needle.size() > 1 ? needle[1] : 0, 0);
+        unsigned int last = trigram(needle[0], needle.size() > 1 ? needle[1] : 0xFF, 0xFF);
+        std::vector<const std::vector<unsigned int>*> lists;
+        for (auto it = postings.lower_bound(first); it != postings.end() && it->first <= last; ++it) lists.push_back(&it->second);
+        typedef std::pair<unsigned int, size_t> Head; // next id of a list, the list
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head> > heads;
+        std::vector<size_t> cursors(lists.size(), 0);
+        for (size_t i = 0; i < lists.size(); ++i) heads.push(Head(lists[i]->front(), i));
+        while (!heads.empty()) {
+            Head head = heads.top();
+            heads.pop();
+            if (results.empty() || results.back() != head.first) {
+                if (results.size() == maxResults) return false;
+                results.push_back(head.first);
+            }
+            const std::vector<unsigned int>& list = *lists[head.second];
+            if (++cursors[head.second] < list.size()) heads.push(Head(list[cursors[head.second]], head.second));
+        }
+        return true;
+    }
+
+    std::vector<unsigned int> trigrams;
+    queryTrigrams(needle, trigrams);
+    std::vector<const std::vector<unsigned int>*> lists;
+    for (unsigned int trigram : trigrams) {
+        auto found = postings.find(trigram);
+        if (found == postings.end()) return true; // no document has this trigram
+        lists.push_back(&found->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<unsigned int>* a, const std::vector<unsigned int>* b) {
+        return a->size() < b->size();
+    });
+
+    // A single trigram is the whole query, every document in its list matches
+    bool verify = needle.size() > 3;
+    std::vector<size_t> cursors(lists.size(), 0);
+    for (unsigned int id : *lists[0]) {
+        bool inAll = true;
+        for (size_t i = 1; i < lists.size(); ++i) {
+            cursors[i] = gallop(*lists[i], cursors[i], id);
+            if (cursors[i] == lists[i]->size()) return true; // nothing past here is in every list
+            if ((*lists[i])[cursors[i]] != id) {
+                inAll = false;
+                break;
+            }
+        }
+        if (!inAll || (verify && documents[id].find(needle) == std::string::npos)) continue;
+        if (results.size() == maxResults) return false;
+        results.push_back(id);
+    }
+    return true;
+}
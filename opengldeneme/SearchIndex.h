@@ -0,0 +1,44 @@
+#pragma once
+// SearchIndex.h
+// Substring search over many short documents (the exhibit catalog), fast enough to run on every
+// keystroke. Documents are lowercased and cut into overlapping three-byte trigrams, and each
+// trigram keeps a posting list of the ids of the documents containing it, sorted. A query walks
+// the shortest posting list among its own trigrams and gallops through the others to keep only
+// ids present in all of them; those candidates are then checked for the whole query, because
+// documents can have every trigram of a query without containing it. A trigram starts at every
+// byte of a document (padded at the end of a field), so a query of one or two bytes is answered
+// by merging the lists of the trigrams it begins. Either way the search stops once it has the
+// requested number of results, so a query matching most of the catalog costs no more than a
+// selective one.
+// Documents are set and removed one at a time, so the index follows edits without a rebuild.
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class SearchIndex {
+public:
+    SearchIndex() : count(0) {}
+
+    // Indexes text as document id, replacing what was there. Text may hold several fields
+    // separated by newlines; matches never cross a newline.
+    void set(unsigned int id, const std::string& text);
+    void remove(unsigned int id);
+    void clear();
+
+    size_t documentCount() const { return count; }
+
+    // Ids of the documents containing query, ignoring ASCII case, in increasing order, at most
+    // maxResults of them. False if the search stopped there with more matches left.
+    bool search(const std::string& query, size_t maxResults, std::vector<unsigned int>& results) const;
+
+private:
+    std::vector<std::string> documents;  // lowercased, by id; empty if there is none
+    size_t count;
+    std::map<unsigned int, std::vector<unsigned int> > postings; // by trigram, ordered for prefix lookups
+
+};
+
+#endif
@@ -1,7 +1,13 @@
 // Shader.cpp
 #include "Shader.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "ProgramCache.h"
+#include "GLExtensions.h"
+#include <algorithm>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines, bool async)
+    : vertexShader(0), fragmentShader(0), cacheKey(0), pending(false), linked(false) {
     std::string vertexCode;
     std::string fragmentCode;
     std::ifstream vShaderFile;
@@ -17,65 +23,141 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         fShaderStream << fShaderFile.rdbuf();
         vShaderFile.close();
         fShaderFile.close();
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        vertexCode = injectDefines(vShaderStream.str(), defines);
+        fragmentCode = injectDefines(fShaderStream.str(), defines);
     }
     catch (std::ifstream::failure& e) {
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
     }
+    // A cached binary skips compiling and linking entirely.
+    ProgramCache& cache = ProgramCache::get();
+    cacheKey = cache.keyFor(vertexCode, fragmentCode);
+    ID = glCreateProgram();
+    if (cache.load(ID, cacheKey)) {
+        linked = true;
+        return;
+    }
+    compileStart = std::chrono::high_resolution_clock::now();
+
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    unsigned int vertex, fragment;
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
+    // No status queries until finishLink(), so the driver is free to compile in the background.
+    vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vShaderCode, nullptr);
+    glCompileShader(vertexShader);
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fShaderCode, nullptr);
+    glCompileShader(fragmentShader);
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    glAttachShader(ID, vertexShader);
+    glAttachShader(ID, fragmentShader);
+    cache.prepareForLink(ID);
     glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    pending = true;
+    if (!async) finishLink();
+}
+
+Shader::~Shader() {
+    if (vertexShader) glDeleteShader(vertexShader);
+    if (fragmentShader) glDeleteShader(fragmentShader);
+}
+
+bool Shader::poll() {
+    if (!pending) return linked;
+    if (GLExtensions::parallelShaderCompile) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done) return false;
+    }
+    finishLink();
+    return linked;
+}
+
+void Shader::wait() {
+    if (pending) finishLink();
+}
+
+void Shader::finishLink() {
+    pending = false;
+    checkCompileErrors(vertexShader, "VERTEX");
+    checkCompileErrors(fragmentShader, "FRAGMENT");
+    linked = checkCompileErrors(ID, "PROGRAM");
+
+    glDetachShader(ID, vertexShader);
+    glDetachShader(ID, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    vertexShader = fragmentShader = 0;
+    if (linked) {
+        ProgramCache::get().store(ID, cacheKey,
+            std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count());
+    }
+}
+
+std::string Shader::injectDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty()) return source;
+    // #version has to stay the first statement; #line keeps compiler messages pointing at the file's own lines.
+    size_t versionLine = source.find("#version");
+    if (versionLine == std::string::npos) return defines + "#line 1\n" + source;
+    size_t lineEnd = source.find('\n', versionLine);
+    if (lineEnd == std::string::npos) return source + "\n" + defines;
+    int nextLine = 2 + static_cast<int>(std::count(source.begin(), source.begin() + lineEnd, '\n'));
+    return source.substr(0, lineEnd + 1) + defines + "#line " + std::to_string(nextLine) + "\n" + source.substr(lineEnd + 1);
 }
 
 void Shader::use() {
-    glUseProgram(ID);
+    GLState::get().useProgram(ID);
 }
 
 void Shader::setBool(const std::string& name, bool value) const {
+    RenderStats::get().recordUniformUpload();
     glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
+    RenderStats::get().recordUniformUpload();
     glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
+    RenderStats::get().recordUniformUpload();
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
+    RenderStats::get().recordUniformUpload();
+    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
+    RenderStats::get().recordUniformUpload();
     glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const {
+    RenderStats::get().recordUniformUpload();
     glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
 }
 
+void Shader::setIVec3(const std::string& name, int x, int y, int z) const {
+    RenderStats::get().recordUniformUpload();
+    glUniform3i(glGetUniformLocation(ID, name.c_str()), x, y, z);
+}
+
+void Shader::setVec4Array(const std::string& name, const glm::vec4* values, int count) const {
+    RenderStats::get().recordUniformUpload();
+    glUniform4fv(glGetUniformLocation(ID, name.c_str()), count, &values[0][0]);
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
+    RenderStats::get().recordUniformUpload();
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-void Shader::checkCompileErrors(unsigned int shader, std::string type) {
+bool Shader::checkCompileErrors(unsigned int shader, std::string type) {
     int success;
     char infoLog[1024];
     if (type != "PROGRAM") {
@@ -92,4 +174,5 @@ void Shader::checkCompileErrors(unsigned int shader, std::string type) {
             std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
         }
     }
+    return success != 0;
 }
\ No newline at end of file
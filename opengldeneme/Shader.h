@@ -4,6 +4,7 @@
 #define SHADER_H
 
 #include <glad/glad.h>
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -15,17 +16,41 @@ class Shader {
 public:
     unsigned int ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // defines is a block of "#define NAME" lines inserted after each stage's #version line.
+    // An async shader only submits the compile and link; poll() it (or hand it to ShaderCompiler)
+    // until it is ready instead of using it right away.
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = std::string(), bool async = false);
+    ~Shader();
+
+    // Non-blocking where the driver supports GL_COMPLETION_STATUS_KHR. Returns true once linked.
+    bool poll();
+    // Blocks until the compile and link are done.
+    void wait();
+    bool isReady() const { return !pending && linked; }
+    bool isPending() const { return pending; }
+
     void use();
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
+    void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setVec3(const std::string& name, float x, float y, float z) const;
+    void setIVec3(const std::string& name, int x, int y, int z) const;
+    void setVec4Array(const std::string& name, const glm::vec4* values, int count) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
+    static std::string injectDefines(const std::string& source, const std::string& defines);
+
 private:
-    void checkCompileErrors(unsigned int shader, std::string type);
+    void finishLink();
+    bool checkCompileErrors(unsigned int shader, std::string type);
+
+    unsigned int vertexShader, fragmentShader;
+    unsigned long long cacheKey;
+    std::chrono::high_resolution_clock::time_point compileStart;
+    bool pending;
+    bool linked;
 };
 
 #endif
\ No newline at end of file
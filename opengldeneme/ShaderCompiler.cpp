@@ -0,0 +1,49 @@
+// ShaderCompiler.cpp
+#include "ShaderCompiler.h"
+#include "GLExtensions.h"
+#include <algorithm>
+
+ShaderCompiler& ShaderCompiler::get() {
+    static ShaderCompiler instance;
+    return instance;
+}
+
+ShaderCompiler::ShaderCompiler() : completed(0) {
+}
+
+void ShaderCompiler::init() {
+    // 0xFFFFFFFF lets the implementation pick the thread count.
+    if (GLExtensions::parallelShaderCompile) GLExtensions::maxShaderCompilerThreads(0xFFFFFFFFu);
+}
+
+void ShaderCompiler::submit(Shader* shader) {
+    if (!shader->isPending()) {
+        completed++;
+        return;
+    }
+    pending.push_back(shader);
+}
+
+void ShaderCompiler::cancel(Shader* shader) {
+    pending.erase(std::remove(pending.begin(), pending.end(), shader), pending.end());
+}
+
+void ShaderCompiler::update() {
+    unsigned int blockingFinishes = 0;
+    for (size_t i = 0; i < pending.size();) {
+        if (!GLExtensions::parallelShaderCompile && blockingFinishes++ >= BLOCKING_FINISHES_PER_FRAME) break;
+        pending[i]->poll();
+        if (pending[i]->isPending()) {
+            ++i;
+            continue;
+        }
+        completed++;
+        pending.erase(pending.begin() + i);
+    }
+}
+
+void ShaderCompiler::finishAll() {
+    for (Shader* shader : pending) shader->wait();
+    completed += static_cast<unsigned int>(pending.size());
+    pending.clear();
+}
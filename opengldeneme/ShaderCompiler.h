@@ -0,0 +1,41 @@
+#pragma once
+// ShaderCompiler.h
+// Tracks programs that were submitted for compilation without waiting on them.
+// With GL_KHR_parallel_shader_compile the driver compiles them on its own threads and update()
+// only picks up the finished ones. Without it, checking a program blocks until it is done, so
+// update() finishes a limited number per frame to spread the stalls out.
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <vector>
+#include "Shader.h"
+
+class ShaderCompiler {
+public:
+    static const unsigned int BLOCKING_FINISHES_PER_FRAME = 1;
+
+    static ShaderCompiler& get();
+
+    // Asks the driver for as many compiler threads as it wants. Call after GLExtensions::init().
+    void init();
+
+    void submit(Shader* shader);
+    // Forgets a shader that is about to be destroyed.
+    void cancel(Shader* shader);
+
+    // Once per frame: finishes every program the driver has completed.
+    void update();
+    // Blocks until everything submitted is linked.
+    void finishAll();
+
+    unsigned int pendingCount() const { return static_cast<unsigned int>(pending.size()); }
+    unsigned int completedCount() const { return completed; }
+
+private:
+    ShaderCompiler();
+
+    std::vector<Shader*> pending;
+    unsigned int completed;
+};
+
+#endif
@@ -0,0 +1,95 @@
+// ShaderVariants.cpp
+#include "ShaderVariants.h"
+#include "GLState.h"
+#include "ShaderCompiler.h"
+#include <iostream>
+
+ShaderVariants::ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), fallbackMask(0) {
+}
+
+ShaderVariants::~ShaderVariants() {
+    clear();
+}
+
+void ShaderVariants::clear() {
+    for (auto& variant : variants) {
+        ShaderCompiler::get().cancel(variant.second.get());
+        GLState::get().deleteProgram(variant.second->ID);
+    }
+    variants.clear();
+}
+
+unsigned int ShaderVariants::addKeyword(const std::string& name) {
+    unsigned int bit = keyword(name);
+    if (bit) return bit;
+    if (keywords.size() >= MAX_KEYWORDS) {
+        std::cerr << "ERROR::SHADER_VARIANTS::TOO_MANY_KEYWORDS: " << name << std::endl;
+        return 0;
+    }
+    keywords.push_back(name);
+    return 1u << (keywords.size() - 1);
+}
+
+unsigned int ShaderVariants::keyword(const std::string& name) const {
+    for (size_t i = 0; i < keywords.size(); ++i) {
+        if (keywords[i] == name) return 1u << i;
+    }
+    return 0;
+}
+
+Shader& ShaderVariants::get(unsigned int mask) {
+    auto it = variants.find(mask);
+    if (it != variants.end()) {
+        it->second->wait();
+        return *it->second;
+    }
+    std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), definesFor(mask)));
+    Shader& result = *shader;
+    variants[mask] = std::move(shader);
+    return result;
+}
+
+void ShaderVariants::request(unsigned int mask) {
+    if (variants.count(mask)) return;
+    std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), definesFor(mask), true));
+    ShaderCompiler::get().submit(shader.get());
+    variants[mask] = std::move(shader);
+}
+
+void ShaderVariants::setFallback(unsigned int mask) {
+    get(mask);
+    fallbackMask = mask;
+}
+
+unsigned int ShaderVariants::resolve(unsigned int mask) {
+    auto it = variants.find(mask);
+    if (it == variants.end()) {
+        request(mask);
+        return fallbackMask;
+    }
+    return it->second->isReady() ? mask : fallbackMask;
+}
+
+bool ShaderVariants::isReady(unsigned int mask) const {
+    auto it = variants.find(mask);
+    return it != variants.end() && it->second->isReady();
+}
+
+std::string ShaderVariants::definesFor(unsigned int mask) const {
+    std::string defines;
+    for (size_t i = 0; i < keywords.size(); ++i) {
+        if (mask & (1u << i)) defines += "#define " + keywords[i] + "\n";
+    }
+    return defines;
+}
+
+std::string ShaderVariants::describe(unsigned int mask) const {
+    std::string name;
+    for (size_t i = 0; i < keywords.size(); ++i) {
+        if (!(mask & (1u << i))) continue;
+        if (!name.empty()) name += " ";
+        name += keywords[i];
+    }
+    return name.empty() ? "base" : name;
+}
@@ -0,0 +1,54 @@
+#pragma once
+// ShaderVariants.h
+// Compiles one shader source into variants selected by feature keywords.
+// Each enabled keyword becomes a "#define NAME" in the compiled stages, so a variant only
+// contains the code of the features it uses. Variants are cached by their keyword bitmask and
+// compile in the background through ShaderCompiler; until one is ready, resolve() hands out
+// the fallback variant, which is compiled up front.
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Shader.h"
+
+class ShaderVariants {
+public:
+    static const unsigned int MAX_KEYWORDS = 32;
+
+    ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath);
+    ~ShaderVariants();
+
+    // Registers a keyword and returns its bit. Registering the same name twice returns the same bit.
+    unsigned int addKeyword(const std::string& name);
+    // Bit of a registered keyword, 0 if unknown.
+    unsigned int keyword(const std::string& name) const;
+
+    // The variant with exactly the keywords in mask. Compiles it, or waits for it, if needed.
+    Shader& get(unsigned int mask);
+    // Submits the variant for background compilation if it doesn't exist yet.
+    void request(unsigned int mask);
+    // Compiles the variant now and hands it out while others are still compiling.
+    void setFallback(unsigned int mask);
+    // mask if that variant is ready, otherwise requests it and returns the fallback's mask.
+    unsigned int resolve(unsigned int mask);
+    bool isReady(unsigned int mask) const;
+
+    // Deletes every compiled program; call while the context is still current.
+    void clear();
+
+    std::string definesFor(unsigned int mask) const;
+    std::string describe(unsigned int mask) const; // "USE_TEXTURE CLUSTERED_LIGHTS" or "base"
+    size_t variantCount() const { return variants.size(); }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<std::string> keywords;
+    unsigned int fallbackMask;
+    std::map<unsigned int, std::unique_ptr<Shader> > variants;
+};
+
+#endif
@@ -0,0 +1,307 @@
+// ShadowMaps.cpp
+#include "ShadowMaps.h"
+#include "Frustum.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+ShadowMaps::ShadowMaps()
+    : staticAtlas(0), finalAtlas(0), staticFramebuffer(0), finalFramebuffer(0), dataBuffer(0), dataTexture(0),
+    frame(0), staticGeneration(0) {
+    memset(&lastStats, 0, sizeof(lastStats));
+}
+
+static GLuint createDepthAtlas(bool comparison) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    GLState::get().bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, ShadowMaps::ATLAS_SIZE, ShadowMaps::ATLAS_SIZE, 0,
+        GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, comparison ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, comparison ? GL_LINEAR : GL_NEAREST);
+    if (comparison) {
+        // Hardware 2x2 PCF on every tap of the shader's filter
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+    return texture;
+}
+
+static GLuint createDepthFramebuffer(GLuint texture) {
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    GLState::get().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::SHADOW_MAPS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    GLState::get().depthMask(true);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    return framebuffer;
+}
+
+void ShadowMaps::init() {
+    GLState& state = GLState::get();
+    staticAtlas = createDepthAtlas(false);
+    finalAtlas = createDepthAtlas(true);
+    staticFramebuffer = createDepthFramebuffer(staticAtlas);
+    finalFramebuffer = createDepthFramebuffer(finalAtlas);
+    state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &dataBuffer);
+    state.bindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &dataTexture);
+    state.bindTexture(0, GL_TEXTURE_BUFFER, dataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, dataBuffer);
+
+    tileUsed.assign(TILES_PER_ROW * TILES_PER_ROW, false);
+    entries.clear();
+}
+
+void ShadowMaps::shutdown() {
+    GLState& state = GLState::get();
+    state.deleteFramebuffer(staticFramebuffer);
+    state.deleteFramebuffer(finalFramebuffer);
+    state.deleteTexture(staticAtlas);
+    state.deleteTexture(finalAtlas);
+    state.deleteTexture(dataTexture);
+    state.deleteBuffer(dataBuffer);
+    staticFramebuffer = finalFramebuffer = staticAtlas = finalAtlas = dataTexture = dataBuffer = 0;
+    entries.clear();
+}
+
+bool ShadowMaps::allocateTile(int span, int& tileX, int& tileY) {
+    for (int y = 0; y + span <= TILES_PER_ROW; y += span) {
+        for (int x = 0; x + span <= TILES_PER_ROW; x += span) {
+            bool free = true;
+            for (int dy = 0; dy < span && free; ++dy) {
+                for (int dx = 0; dx < span && free; ++dx) free = !tileUsed[(y + dy) * TILES_PER_ROW + x + dx];
+            }
+            if (!free) continue;
+            for (int dy = 0; dy < span; ++dy) {
+                for (int dx = 0; dx < span; ++dx) tileUsed[(y + dy) * TILES_PER_ROW + x + dx] = true;
+            }
+            tileX = x;
+            tileY = y;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShadowMaps::freeTile(const Entry& entry) {
+    for (int dy = 0; dy < entry.span; ++dy) {
+        for (int dx = 0; dx < entry.span; ++dx) tileUsed[(entry.tileY + dy) * TILES_PER_ROW + entry.tileX + dx] = false;
+    }
+}
+
+void ShadowMaps::requestShadow(unsigned int key, const glm::vec3& position, const glm::vec3& direction,
+    float fovDegrees, float range, int tileSpan, unsigned int updateInterval) {
+    glm::vec3 dir = glm::normalize(direction);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        Entry entry;
+        // Atlas full: take tiles from lights that weren't requested this frame, oldest first.
+        while (!allocateTile(tileSpan, entry.tileX, entry.tileY)) {
+            auto oldest = entries.end();
+            for (auto other = entries.begin(); other != entries.end(); ++other) {
+                if (other->second.lastRequested == frame) continue;
+                if (oldest == entries.end() || other->second.lastRequested < oldest->second.lastRequested) oldest = other;
+            }
+            if (oldest == entries.end()) return; // every tile is in use this frame, the light stays unshadowed
+            freeTile(oldest->second);
+            entries.erase(oldest);
+        }
+        entry.span = tileSpan;
+        entry.staticValid = entry.finalValid = entry.hadDynamicCasters = false;
+        entry.staticGeneration = staticGeneration;
+        entry.lastDynamicUpdate = 0;
+        entry.dataIndex = -1;
+        it = entries.insert(std::make_pair(key, entry)).first;
+    }
+    else if (glm::distance(it->second.position, position) < 1e-4f && glm::dot(it->second.direction, dir) > 0.99999f
+        && it->second.fov == fovDegrees && it->second.range == range) {
+        it->second.lastRequested = frame;
+        it->second.updateInterval = std::max(1u, updateInterval);
+        return;
+    }
+    else {
+        it->second.staticValid = false; // the light moved, its cached layer is useless
+    }
+
+    Entry& entry = it->second;
+    entry.position = position;
+    entry.direction = dir;
+    entry.fov = fovDegrees;
+    entry.range = range;
+    entry.updateInterval = std::max(1u, updateInterval);
+    entry.lastRequested = frame;
+    glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 view = glm::lookAt(position, position + dir, up);
+    glm::mat4 projection = glm::perspective(glm::radians(fovDegrees), 1.0f, std::max(0.05f, range * 0.005f), range);
+    entry.viewProjection = projection * view;
+}
+
+int ShadowMaps::shadowIndex(unsigned int key) const {
+    auto it = entries.find(key);
+    return it == entries.end() ? -1 : it->second.dataIndex;
+}
+
+void ShadowMaps::beginTile(GLuint framebuffer, const Entry& entry) {
+    GLState& state = GLState::get();
+    state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    state.viewport(entry.tileX * TILE_SIZE, entry.tileY * TILE_SIZE, entry.span * TILE_SIZE, entry.span * TILE_SIZE);
+}
+
+unsigned int ShadowMaps::drawCasters(Shader& depthShader, const Entry& entry, const std::vector<ShadowCaster>& casters) {
+    Frustum frustum(entry.viewProjection);
+    depthShader.use();
+    depthShader.setMat4("lightViewProjection", entry.viewProjection);
+    unsigned int drawn = 0;
+    for (const auto& caster : casters) {
+        if (!frustum.intersectsBox(caster.boundsMin, caster.boundsMax)) continue;
+        caster.mesh->DrawGeometry(depthShader, caster.model);
+        drawn++;
+    }
+    return drawn;
+}
+
+void ShadowMaps::render(Shader& depthShader, const std::vector<ShadowCaster>& staticCasters, const std::vector<ShadowCaster>& dynamicCasters) {
+    GLState& state = GLState::get();
+    ShadowMapStats current;
+    memset(&current, 0, sizeof(current));
+
+    // Drop lights nobody asked for in a while.
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (frame - it->second.lastRequested > EVICT_AFTER_FRAMES) {
+            freeTile(it->second);
+            it = entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Static layers first, lights with the tightest update interval ahead of the rest.
+    std::vector<Entry*> work;
+    for (auto& pair : entries) {
+        Entry& entry = pair.second;
+        if (entry.staticGeneration != staticGeneration) entry.staticValid = false;
+        if (!entry.staticValid && entry.lastRequested == frame) work.push_back(&entry);
+    }
+    std::stable_sort(work.begin(), work.end(), [](const Entry* a, const Entry* b) { return a->updateInterval < b->updateInterval; });
+    if (work.size() > (size_t)MAX_STATIC_RENDERS_PER_FRAME) work.resize(MAX_STATIC_RENDERS_PER_FRAME);
+
+    state.enable(GL_DEPTH_TEST);
+    state.depthFunc(GL_LESS);
+    state.depthMask(true);
+    state.disable(GL_BLEND);
+    state.enable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.5f, 2.0f);
+
+    for (Entry* entry : work) {
+        beginTile(staticFramebuffer, *entry);
+        state.enable(GL_SCISSOR_TEST);
+        glScissor(entry->tileX * TILE_SIZE, entry->tileY * TILE_SIZE, entry->span * TILE_SIZE, entry->span * TILE_SIZE);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        state.disable(GL_SCISSOR_TEST);
+        current.casterDraws += drawCasters(depthShader, *entry, staticCasters);
+        entry->staticValid = true;
+        entry->staticGeneration = staticGeneration;
+        entry->finalValid = false;
+        current.staticRenders++;
+    }
+
+    // Final layers: new static content, or a dynamic caster that is (or was) in view and is due.
+    work.clear();
+    for (auto& pair : entries) {
+        Entry& entry = pair.second;
+        if (!entry.staticValid || entry.lastRequested != frame) continue;
+        bool due = frame - entry.lastDynamicUpdate >= entry.updateInterval;
+        if (!entry.finalValid) {
+            work.push_back(&entry);
+        }
+        else if (due) {
+            bool dynamicInView = entry.hadDynamicCasters;
+            Frustum frustum(entry.viewProjection);
+            for (size_t i = 0; i < dynamicCasters.size() && !dynamicInView; ++i) {
+                dynamicInView = frustum.intersectsBox(dynamicCasters[i].boundsMin, dynamicCasters[i].boundsMax);
+            }
+            if (dynamicInView) work.push_back(&entry);
+        }
+    }
+    // Invalid tiles first, then the ones most overdue relative to their interval.
+    unsigned int now = frame;
+    std::stable_sort(work.begin(), work.end(), [now](const Entry* a, const Entry* b) {
+        if (a->finalValid != b->finalValid) return !a->finalValid;
+        return (now - a->lastDynamicUpdate) * b->updateInterval > (now - b->lastDynamicUpdate) * a->updateInterval;
+    });
+    if (work.size() > (size_t)MAX_DYNAMIC_RENDERS_PER_FRAME) work.resize(MAX_DYNAMIC_RENDERS_PER_FRAME);
+
+    for (Entry* entry : work) {
+        GLint x0 = entry->tileX * TILE_SIZE, y0 = entry->tileY * TILE_SIZE;
+        GLint x1 = x0 + entry->span * TILE_SIZE, y1 = y0 + entry->span * TILE_SIZE;
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, staticFramebuffer);
+        state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, finalFramebuffer);
+        glBlitFramebuffer(x0, y0, x1, y1, x0, y0, x1, y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        beginTile(finalFramebuffer, *entry);
+        unsigned int drawn = drawCasters(depthShader, *entry, dynamicCasters);
+        current.casterDraws += drawn;
+        entry->hadDynamicCasters = drawn > 0;
+        entry->finalValid = true;
+        entry->lastDynamicUpdate = frame;
+        current.dynamicRenders++;
+    }
+
+    state.disable(GL_POLYGON_OFFSET_FILL);
+    state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Shadow data: light matrix mapped into the tile (4 texels) and the tile rect for the filter clamp.
+    shadowData.clear();
+    int index = 0;
+    const float texel = 1.0f / ATLAS_SIZE;
+    for (auto& pair : entries) {
+        Entry& entry = pair.second;
+        entry.dataIndex = -1;
+        if (!entry.finalValid || entry.lastRequested != frame) continue;
+        entry.dataIndex = index++;
+        float minU = (float)(entry.tileX * TILE_SIZE) / ATLAS_SIZE;
+        float minV = (float)(entry.tileY * TILE_SIZE) / ATLAS_SIZE;
+        float size = (float)(entry.span * TILE_SIZE) / ATLAS_SIZE;
+        glm::mat4 toAtlas(1.0f);
+        toAtlas[0][0] = 0.5f * size;
+        toAtlas[1][1] = 0.5f * size;
+        toAtlas[2][2] = 0.5f;
+        toAtlas[3] = glm::vec4(minU + 0.5f * size, minV + 0.5f * size, 0.5f, 1.0f);
+        glm::mat4 matrix = toAtlas * entry.viewProjection;
+        const float* values = &matrix[0][0];
+        shadowData.insert(shadowData.end(), values, values + 16);
+        const float rect[4] = { minU + texel * 0.5f, minV + texel * 0.5f, minU + size - texel * 0.5f, minV + size - texel * 0.5f };
+        shadowData.insert(shadowData.end(), rect, rect + 4);
+    }
+    if (shadowData.empty()) shadowData.resize(20, 0.0f);
+    state.bindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, shadowData.size() * sizeof(float), shadowData.data(), GL_STREAM_DRAW);
+    RenderStats::get().recordBufferUpload(shadowData.size() * sizeof(float));
+
+    current.shadows = static_cast<unsigned int>(entries.size());
+    lastStats = current;
+    frame++;
+}
+
+void ShadowMaps::apply(Shader& shader) const {
+    GLState& state = GLState::get();
+    shader.use();
+    state.bindTexture(ATLAS_UNIT, GL_TEXTURE_2D, finalAtlas);
+    state.bindTexture(SHADOW_DATA_UNIT, GL_TEXTURE_BUFFER, dataTexture);
+    shader.setInt("shadowAtlas", ATLAS_UNIT);
+    shader.setInt("shadowData", SHADOW_DATA_UNIT);
+}
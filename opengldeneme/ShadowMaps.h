@@ -0,0 +1,101 @@
+#pragma once
+// ShadowMaps.h
+// Shadow maps for the main light and the gallery spotlights, packed into one depth atlas.
+// Every shadowed light owns a tile in two atlases: a static layer holding only the exhibits,
+// rendered once and again only when the light moves or the exhibits change, and the final layer
+// the shader samples, rebuilt by copying the static tile and drawing the dynamic casters (the
+// robot) on top. Each light has its own update interval, and a per-frame budget caps how many
+// tiles are re-rendered.
+#ifndef SHADOW_MAPS_H
+#define SHADOW_MAPS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <map>
+#include <vector>
+#include "Mesh.h"
+#include "Shader.h"
+
+struct ShadowCaster {
+    Mesh* mesh;
+    glm::mat4 model;
+    glm::vec3 boundsMin, boundsMax; // world space
+};
+
+struct ShadowMapStats {
+    unsigned int shadows;         // tiles in use
+    unsigned int staticRenders;   // static layers rendered last frame
+    unsigned int dynamicRenders;  // final layers rebuilt last frame
+    unsigned int casterDraws;
+};
+
+class ShadowMaps {
+public:
+    static const int ATLAS_SIZE = 4096;
+    static const int TILE_SIZE = 512;
+    static const int TILES_PER_ROW = ATLAS_SIZE / TILE_SIZE;
+    static const int MAX_STATIC_RENDERS_PER_FRAME = 2;
+    static const int MAX_DYNAMIC_RENDERS_PER_FRAME = 12;
+    static const unsigned int EVICT_AFTER_FRAMES = 120;
+
+    // Texture units the shader samples the atlas and the shadow matrices from.
+    static const int ATLAS_UNIT = 4;
+    static const int SHADOW_DATA_UNIT = 5;
+
+    ShadowMaps();
+
+    void init();
+    void shutdown();
+
+    // Declares a shadow-casting spotlight for this frame. key identifies the light across frames,
+    // tileSpan is its tile size in atlas tiles (1 or 2), updateInterval how many frames its dynamic
+    // casters may lag behind.
+    void requestShadow(unsigned int key, const glm::vec3& position, const glm::vec3& direction,
+        float fovDegrees, float range, int tileSpan, unsigned int updateInterval);
+
+    // Static casters changed (an exhibit was moved): every static layer is rendered again.
+    void invalidateStatic() { staticGeneration++; }
+
+    // Renders what the budgets allow and uploads the shadow matrices. Leaves the default framebuffer bound.
+    void render(Shader& depthShader, const std::vector<ShadowCaster>& staticCasters, const std::vector<ShadowCaster>& dynamicCasters);
+
+    // Index into the shader's shadow data, -1 if the light has no usable shadow yet.
+    int shadowIndex(unsigned int key) const;
+
+    void apply(Shader& shader) const;
+    const ShadowMapStats& stats() const { return lastStats; }
+
+private:
+    struct Entry {
+        int tileX, tileY, span;
+        glm::vec3 position, direction;
+        float fov, range;
+        glm::mat4 viewProjection;
+        unsigned int updateInterval;
+        unsigned int lastRequested;
+        unsigned int lastDynamicUpdate;
+        unsigned int staticGeneration; // matches ShadowMaps::staticGeneration when the static layer is current
+        bool staticValid;
+        bool finalValid;
+        bool hadDynamicCasters;        // final layer contains a dynamic caster that may have moved
+        int dataIndex;
+    };
+
+    bool allocateTile(int span, int& tileX, int& tileY);
+    void freeTile(const Entry& entry);
+    void beginTile(GLuint framebuffer, const Entry& entry);
+    unsigned int drawCasters(Shader& depthShader, const Entry& entry, const std::vector<ShadowCaster>& casters);
+
+    GLuint staticAtlas, finalAtlas;
+    GLuint staticFramebuffer, finalFramebuffer;
+    GLuint dataBuffer, dataTexture;
+
+    std::map<unsigned int, Entry> entries;
+    std::vector<bool> tileUsed;
+    std::vector<float> shadowData;
+    unsigned int frame;
+    unsigned int staticGeneration;
+    ShadowMapStats lastStats;
+};
+
+#endif
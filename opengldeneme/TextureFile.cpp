@@ -0,0 +1,155 @@
+// TextureFile.cpp
+#include "TextureFile.h"
+#include "GLExtensions.h"
+#include <fstream>
+
+namespace {
+
+const unsigned int DDS_MAGIC = 0x20534444; // "DDS "
+const unsigned int DDPF_FOURCC = 0x4;
+
+unsigned int fourCC(char a, char b, char c, char d) {
+    return (unsigned int)(unsigned char)a | ((unsigned int)(unsigned char)b << 8)
+        | ((unsigned int)(unsigned char)c << 16) | ((unsigned int)(unsigned char)d << 24);
+}
+
+// DXGI_FORMAT values used by the DX10 extended header.
+enum {
+    DXGI_BC1_UNORM = 71, DXGI_BC1_UNORM_SRGB = 72,
+    DXGI_BC3_UNORM = 77, DXGI_BC3_UNORM_SRGB = 78,
+    DXGI_BC5_UNORM = 83,
+    DXGI_BC7_UNORM = 98, DXGI_BC7_UNORM_SRGB = 99
+};
+
+#pragma pack(push, 1)
+struct DDSPixelFormat {
+    unsigned int size, flags, fourCC, rgbBitCount;
+    unsigned int rMask, gMask, bMask, aMask;
+};
+struct DDSHeader {
+    unsigned int size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+    unsigned int reserved1[11];
+    DDSPixelFormat pixelFormat;
+    unsigned int caps, caps2, caps3, caps4, reserved2;
+};
+struct DDSHeaderDX10 {
+    unsigned int dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+};
+#pragma pack(pop)
+
+}
+
+GLenum TextureFileInfo::glInternalFormat() const {
+    switch (format) {
+    case TEXTURE_FORMAT_BC1: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case TEXTURE_FORMAT_BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TEXTURE_FORMAT_BC5: return GL_COMPRESSED_RG_RGTC2;
+    case TEXTURE_FORMAT_BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return 0;
+    }
+}
+
+unsigned int TextureFileInfo::blockBytes() const {
+    return format == TEXTURE_FORMAT_BC1 ? 8 : 16;
+}
+
+const char* textureFormatName(TextureBlockFormat format) {
+    switch (format) {
+    case TEXTURE_FORMAT_BC1: return "BC1";
+    case TEXTURE_FORMAT_BC3: return "BC3";
+    case TEXTURE_FORMAT_BC5: return "BC5";
+    case TEXTURE_FORMAT_BC7: return "BC7";
+    default: return "unknown";
+    }
+}
+
+bool readTextureFileInfo(const std::string& path, TextureFileInfo& info, std::string& error) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        error = "cannot open file";
+        return false;
+    }
+
+    unsigned int magic = 0;
+    DDSHeader header;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || magic != DDS_MAGIC || header.size != sizeof(DDSHeader)) {
+        error = "not a DDS file";
+        return false;
+    }
+
+    info.path = path;
+    info.format = TEXTURE_FORMAT_UNKNOWN;
+    info.srgb = false;
+    info.width = header.width;
+    info.height = header.height;
+
+    unsigned long long dataOffset = sizeof(magic) + sizeof(header);
+    if (!(header.pixelFormat.flags & DDPF_FOURCC)) {
+        error = "uncompressed DDS files are not supported";
+        return false;
+    }
+    unsigned int cc = header.pixelFormat.fourCC;
+    if (cc == fourCC('D', 'X', '1', '0')) {
+        DDSHeaderDX10 dx10;
+        file.read(reinterpret_cast<char*>(&dx10), sizeof(dx10));
+        if (!file) {
+            error = "truncated DX10 header";
+            return false;
+        }
+        dataOffset += sizeof(dx10);
+        switch (dx10.dxgiFormat) {
+        case DXGI_BC1_UNORM_SRGB: info.srgb = true; // fall through
+        case DXGI_BC1_UNORM: info.format = TEXTURE_FORMAT_BC1; break;
+        case DXGI_BC3_UNORM_SRGB: info.srgb = true; // fall through
+        case DXGI_BC3_UNORM: info.format = TEXTURE_FORMAT_BC3; break;
+        case DXGI_BC5_UNORM: info.format = TEXTURE_FORMAT_BC5; break;
+        case DXGI_BC7_UNORM_SRGB: info.srgb = true; // fall through
+        case DXGI_BC7_UNORM: info.format = TEXTURE_FORMAT_BC7; break;
+        default: break;
+        }
+    }
+    else if (cc == fourCC('D', 'X', 'T', '1')) info.format = TEXTURE_FORMAT_BC1;
+    else if (cc == fourCC('D', 'X', 'T', '5')) info.format = TEXTURE_FORMAT_BC3;
+    else if (cc == fourCC('A', 'T', 'I', '2') || cc == fourCC('B', 'C', '5', 'U')) info.format = TEXTURE_FORMAT_BC5;
+
+    if (info.format == TEXTURE_FORMAT_UNKNOWN) {
+        error = "unsupported pixel format";
+        return false;
+    }
+
+    unsigned int mipCount = header.mipMapCount > 0 ? header.mipMapCount : 1;
+    info.levels.clear();
+    unsigned int w = info.width, h = info.height;
+    unsigned long long offset = dataOffset;
+    for (unsigned int level = 0; level < mipCount; ++level) {
+        TextureLevelInfo li;
+        li.width = w;
+        li.height = h;
+        li.offset = offset;
+        li.size = ((w + 3) / 4) * ((h + 3) / 4) * info.blockBytes();
+        info.levels.push_back(li);
+        offset += li.size;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    file.seekg(0, std::ios::end);
+    if ((unsigned long long)file.tellg() < offset) {
+        error = "file is shorter than its mip chain";
+        return false;
+    }
+    return true;
+}
+
+bool readTextureLevel(const TextureFileInfo& info, unsigned int level, std::vector<unsigned char>& data) {
+    if (level >= info.levels.size()) return false;
+    const TextureLevelInfo& li = info.levels[level];
+    std::ifstream file(info.path.c_str(), std::ios::binary);
+    if (!file) return false;
+    file.seekg((std::streamoff)li.offset);
+    data.resize(li.size);
+    file.read(reinterpret_cast<char*>(data.data()), li.size);
+    return (bool)file;
+}
@@ -0,0 +1,44 @@
+#pragma once
+// TextureFile.h
+// Reader for pre-mipped, block-compressed textures in DDS containers (BC1/BC3/BC5/BC7).
+// Only the header is parsed up front; individual mip levels are read on demand so streaming
+// workers never have to hold the whole file in memory.
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+enum TextureBlockFormat {
+    TEXTURE_FORMAT_UNKNOWN,
+    TEXTURE_FORMAT_BC1,
+    TEXTURE_FORMAT_BC3,
+    TEXTURE_FORMAT_BC5,
+    TEXTURE_FORMAT_BC7
+};
+
+struct TextureLevelInfo {
+    unsigned int width;
+    unsigned int height;
+    unsigned long long offset; // byte offset in the file
+    unsigned int size;         // compressed byte size
+};
+
+struct TextureFileInfo {
+    std::string path;
+    TextureBlockFormat format;
+    bool srgb;
+    unsigned int width;
+    unsigned int height;
+    std::vector<TextureLevelInfo> levels; // level 0 is the full resolution image
+
+    GLenum glInternalFormat() const;
+    unsigned int blockBytes() const;
+};
+
+bool readTextureFileInfo(const std::string& path, TextureFileInfo& info, std::string& error);
+bool readTextureLevel(const TextureFileInfo& info, unsigned int level, std::vector<unsigned char>& data);
+const char* textureFormatName(TextureBlockFormat format);
+
+#endif
@@ -0,0 +1,289 @@
+// TextureManager.cpp
+#include "TextureManager.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+// Creation, uploads and evictions edit through this unit. Drawing may have left any other unit
+// active, and GLState::bindTexture activates this one even when the texture is already bound.
+const unsigned int EDIT_UNIT = 0;
+
+void bindForEdit(GLuint texture) {
+    GLState::get().bindTexture(EDIT_UNIT, GL_TEXTURE_2D, texture);
+}
+}
+
+TextureManager::TextureManager()
+    : budget(0), residentTotal(0), inFlightBytes(0), frame(0), inFlight(0), stopping(false) {
+    lastStats = TextureManagerStats();
+}
+
+TextureManager::~TextureManager() {
+    shutdown();
+}
+
+void TextureManager::init(size_t budgetBytes, unsigned int workerCount) {
+    budget = budgetBytes;
+    stopping = false;
+    if (workerCount == 0) workerCount = 1;
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers.push_back(std::thread(&TextureManager::workerLoop, this));
+    }
+}
+
+void TextureManager::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        requests.clear();
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+
+    for (auto& texture : textures) {
+        if (texture->id) GLState::get().deleteTexture(texture->id);
+        texture->id = 0;
+    }
+    textures.clear();
+    readyUploads.clear();
+    residentTotal = 0;
+    inFlightBytes = 0;
+    inFlight = 0;
+}
+
+TextureManager::Texture* TextureManager::find(TextureHandle handle) {
+    if (handle == 0 || handle > textures.size()) return nullptr;
+    Texture* texture = textures[handle - 1].get();
+    return texture->id ? texture : nullptr;
+}
+
+TextureHandle TextureManager::load(const std::string& path) {
+    std::unique_ptr<Texture> texture(new Texture());
+    std::string error;
+    if (!readTextureFileInfo(path, texture->file, error)) {
+        std::cerr << "ERROR::TEXTURE::LOAD_FAILED " << path << ": " << error << std::endl;
+        return 0;
+    }
+    TextureBlockFormat format = texture->file.format;
+    if ((format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3) && !GLExtensions::s3tc) {
+        std::cerr << "ERROR::TEXTURE::FORMAT_UNSUPPORTED " << path << ": " << textureFormatName(format) << " needs GL_EXT_texture_compression_s3tc" << std::endl;
+        return 0;
+    }
+    if (format == TEXTURE_FORMAT_BC7 && !GLExtensions::bptc) {
+        std::cerr << "ERROR::TEXTURE::FORMAT_UNSUPPORTED " << path << ": BC7 needs GL_ARB_texture_compression_bptc" << std::endl;
+        return 0;
+    }
+
+    const std::vector<TextureLevelInfo>& levels = texture->file.levels;
+    unsigned int lastLevel = static_cast<unsigned int>(levels.size()) - 1;
+    texture->tailStart = lastLevel;
+    for (unsigned int level = 0; level < levels.size(); ++level) {
+        if (std::max(levels[level].width, levels[level].height) <= TAIL_SIZE) {
+            texture->tailStart = level;
+            break;
+        }
+    }
+    texture->residentBase = lastLevel + 1;
+    texture->wantedBase = texture->tailStart;
+    texture->lastUsedFrame = frame;
+    texture->loadInFlight = false;
+    texture->residentBytes = 0;
+
+    glGenTextures(1, &texture->id);
+    bindForEdit(texture->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)lastLevel);
+    if (GLExtensions::anisotropic) glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 8.0f);
+
+    // The tail is small, read it synchronously so the texture is usable right away.
+    std::vector<unsigned char> data;
+    for (unsigned int level = lastLevel + 1; level-- > texture->tailStart;) {
+        if (!readTextureLevel(texture->file, level, data)) {
+            std::cerr << "ERROR::TEXTURE::LOAD_FAILED " << path << ": cannot read mip " << level << std::endl;
+            GLState::get().deleteTexture(texture->id);
+            residentTotal -= texture->residentBytes; // the levels already uploaded went with it
+            return 0;
+        }
+        uploadLevel(*texture, level, data);
+    }
+
+    texture->handle = static_cast<TextureHandle>(textures.size() + 1);
+    textures.push_back(std::move(texture));
+    return textures.back()->handle;
+}
+
+void TextureManager::requestResolution(TextureHandle handle, float screenPixels) {
+    Texture* texture = find(handle);
+    if (!texture) return;
+    texture->lastUsedFrame = frame;
+
+    // Finest level whose size still covers the on-screen footprint.
+    const TextureLevelInfo& top = texture->file.levels[0];
+    float texels = static_cast<float>(std::max(top.width, top.height));
+    float ratio = texels / std::max(screenPixels, 1.0f);
+    unsigned int level = ratio <= 1.0f ? 0 : static_cast<unsigned int>(std::floor(std::log2(ratio)));
+    level = std::min(level, texture->tailStart);
+    texture->wantedBase = std::min(texture->wantedBase, level);
+}
+
+bool TextureManager::bind(TextureHandle handle, unsigned int unit) {
+    Texture* texture = find(handle);
+    if (!texture) return false;
+    texture->lastUsedFrame = frame;
+    GLState::get().bindTexture(unit, GL_TEXTURE_2D, texture->id);
+    return true;
+}
+
+void TextureManager::uploadLevel(Texture& texture, unsigned int level, const std::vector<unsigned char>& data) {
+    const TextureLevelInfo& li = texture.file.levels[level];
+    bindForEdit(texture.id);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.file.glInternalFormat(), li.width, li.height, 0, li.size, data.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level);
+    texture.residentBase = level;
+    texture.residentBytes += li.size;
+    residentTotal += li.size;
+    RenderStats::get().recordTextureUpload(li.size);
+}
+
+void TextureManager::evictLevel(Texture& texture) {
+    unsigned int level = texture.residentBase;
+    const TextureLevelInfo& li = texture.file.levels[level];
+    bindForEdit(texture.id);
+    // Move the base past the level first so the texture stays complete, then release the storage.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)(level + 1));
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    texture.residentBase = level + 1;
+    texture.residentBytes -= li.size;
+    residentTotal -= li.size;
+    lastStats.evictionsLastFrame++;
+}
+
+bool TextureManager::makeRoom(size_t bytes, TextureHandle requester) {
+    while (residentTotal + inFlightBytes + bytes > budget) {
+        // Textures holding more detail than they asked for go first, then least recently used.
+        Texture* victim = nullptr;
+        for (auto& texture : textures) {
+            Texture* candidate = texture.get();
+            if (candidate->handle == requester || !candidate->id || candidate->residentBase >= candidate->tailStart) continue;
+            bool overResident = candidate->residentBase < candidate->wantedBase;
+            if (!overResident && candidate->lastUsedFrame == frame) continue;
+            if (!victim) {
+                victim = candidate;
+                continue;
+            }
+            bool victimOver = victim->residentBase < victim->wantedBase;
+            if (overResident != victimOver) {
+                if (overResident) victim = candidate;
+            }
+            else if (candidate->lastUsedFrame < victim->lastUsedFrame) {
+                victim = candidate;
+            }
+        }
+        if (!victim) return false;
+        evictLevel(*victim);
+    }
+    return true;
+}
+
+void TextureManager::update() {
+    lastStats.uploadsLastFrame = 0;
+    lastStats.evictionsLastFrame = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (auto& result : results) readyUploads.push_back(std::move(result));
+        results.clear();
+    }
+
+    // Upload finished reads, limited per frame so a burst of streaming doesn't hitch.
+    size_t uploaded = 0;
+    while (!readyUploads.empty() && uploaded < UPLOAD_BYTES_PER_FRAME) {
+        LoadResult& result = readyUploads.front();
+        Texture* texture = find(result.handle);
+        if (texture) {
+            size_t size = texture->file.levels[result.level].size;
+            texture->loadInFlight = false;
+            inFlight--;
+            inFlightBytes -= size;
+            // Skip the upload if the texture no longer wants this much detail.
+            if (result.ok && result.level + 1 == texture->residentBase && result.level >= texture->wantedBase) {
+                uploadLevel(*texture, result.level, result.data);
+                uploaded += size;
+                lastStats.uploadsLastFrame++;
+            }
+            else if (!result.ok) {
+                std::cerr << "ERROR::TEXTURE::STREAM_FAILED " << texture->file.path << ": mip " << result.level << std::endl;
+            }
+        }
+        readyUploads.pop_front();
+    }
+
+    // Schedule one level per texture, biggest shortfall first.
+    std::vector<Texture*> candidates;
+    for (auto& texture : textures) {
+        if (texture->id && !texture->loadInFlight && texture->wantedBase < texture->residentBase) {
+            candidates.push_back(texture.get());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b) {
+        return (a->residentBase - a->wantedBase) > (b->residentBase - b->wantedBase);
+    });
+    unsigned int maxInFlight = static_cast<unsigned int>(workers.size()) * 2;
+    for (Texture* texture : candidates) {
+        if (inFlight >= maxInFlight) break;
+        unsigned int level = texture->residentBase - 1;
+        size_t size = texture->file.levels[level].size;
+        if (!makeRoom(size, texture->handle)) continue;
+
+        texture->loadInFlight = true;
+        inFlight++;
+        inFlightBytes += size;
+        LoadRequest request;
+        request.handle = texture->handle;
+        request.level = level;
+        request.file = &texture->file;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            requests.push_back(request);
+        }
+        queueCondition.notify_one();
+    }
+
+    // Demand is re-reported every frame; anything not drawn falls back to its tail.
+    for (auto& texture : textures) texture->wantedBase = texture->tailStart;
+
+    lastStats.residentBytes = residentTotal;
+    lastStats.budgetBytes = budget;
+    lastStats.textures = static_cast<unsigned int>(textures.size());
+    lastStats.pendingLoads = inFlight;
+    frame++;
+}
+
+void TextureManager::workerLoop() {
+    for (;;) {
+        LoadRequest request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !requests.empty(); });
+            if (stopping) return;
+            request = requests.front();
+            requests.pop_front();
+        }
+
+        LoadResult result;
+        result.handle = request.handle;
+        result.level = request.level;
+        result.ok = readTextureLevel(*request.file, request.level, result.data);
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        results.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+// TextureManager.h
+// Streams block-compressed textures into GPU memory.
+// Loading a texture uploads only its low-resolution mip tail. Finer mips are read from disk on
+// worker threads when the renderer reports enough on-screen size for them, uploaded on the GL
+// thread a few megabytes per frame, and evicted least-recently-used first when the resident set
+// would exceed the memory budget.
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TextureFile.h"
+
+typedef unsigned int TextureHandle; // 0 means "no texture"
+
+struct TextureManagerStats {
+    size_t residentBytes;
+    size_t budgetBytes;
+    unsigned int textures;
+    unsigned int pendingLoads;
+    unsigned int uploadsLastFrame;
+    unsigned int evictionsLastFrame;
+};
+
+class TextureManager {
+public:
+    static const unsigned int TAIL_SIZE = 128;                  // levels this size and smaller are always resident
+    static const size_t UPLOAD_BYTES_PER_FRAME = 16 * 1024 * 1024;
+
+    TextureManager();
+    ~TextureManager();
+
+    void init(size_t budgetBytes, unsigned int workerCount);
+    void shutdown();
+
+    // Parses the file and uploads its mip tail. Returns 0 if the file can't be used.
+    TextureHandle load(const std::string& path);
+
+    // Reports how many pixels the texture's longest side covers on screen this frame.
+    void requestResolution(TextureHandle handle, float screenPixels);
+
+    // True once the texture's mip tail is on the GPU, i.e. bind() will succeed.
+    bool isLoaded(TextureHandle handle) { return find(handle) != nullptr; }
+
+    // Binds the resident mips to the given unit. Returns false for handle 0 / failed loads.
+    bool bind(TextureHandle handle, unsigned int unit);
+
+    // Once per frame on the GL thread: uploads finished reads, evicts, schedules new reads.
+    void update();
+
+    void setBudget(size_t bytes) { budget = bytes; }
+    const TextureManagerStats& stats() const { return lastStats; }
+
+private:
+    struct Texture {
+        TextureHandle handle;
+        TextureFileInfo file;
+        GLuint id;
+        unsigned int residentBase; // finest level currently on the GPU
+        unsigned int tailStart;    // first level of the always-resident tail
+        unsigned int wantedBase;   // finest level asked for this frame
+        unsigned int lastUsedFrame;
+        bool loadInFlight;
+        size_t residentBytes;
+    };
+    struct LoadRequest {
+        TextureHandle handle;
+        unsigned int level;
+        const TextureFileInfo* file;
+    };
+    struct LoadResult {
+        TextureHandle handle;
+        unsigned int level;
+        bool ok;
+        std::vector<unsigned char> data;
+    };
+
+    void workerLoop();
+    void uploadLevel(Texture& texture, unsigned int level, const std::vector<unsigned char>& data);
+    void evictLevel(Texture& texture);
+    bool makeRoom(size_t bytes, TextureHandle requester);
+    Texture* find(TextureHandle handle);
+
+    std::vector<std::unique_ptr<Texture> > textures;
+    std::deque<LoadResult> readyUploads; // finished reads waiting for upload bandwidth
+    size_t budget;
+    size_t residentTotal;
+    size_t inFlightBytes;
+    unsigned int frame;
+    unsigned int inFlight;
+    TextureManagerStats lastStats;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<LoadRequest> requests;
+    std::vector<LoadResult> results;
+    std::vector<std::thread> workers;
+    bool stopping;
+};
+
+#endif
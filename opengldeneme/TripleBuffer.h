@@ -0,0 +1,63 @@
+#pragma once
+// TripleBuffer.h
+// Hands the latest value from one writer thread to one reader thread without locking. The writer
+// fills its own slot and swaps it with the shared middle slot; the reader swaps the middle slot
+// with its own when something new was published, so neither ever touches a slot the other owns.
+// The wait functions only park a thread that has nothing to do; the slots are never locked.
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : slots(), middle(1), writeIndex(0), readIndex(2) {}
+
+    // Writer: fill writeSlot(), then publish() it. A value the reader hasn't taken yet is replaced.
+    T& writeSlot() { return slots[writeIndex]; }
+    void publish() {
+        writeIndex = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+        notify();
+    }
+    // True while the last published value is waiting for the reader.
+    bool hasUnread() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+    void waitUntilRead() {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        changed.wait(lock, [this]() { return !hasUnread(); });
+    }
+
+    // Reader: switches readSlot() to the newest published value, false if there is nothing new.
+    bool acquire() {
+        if (!hasUnread()) return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        notify();
+        return true;
+    }
+    T& readSlot() { return slots[readIndex]; }
+    void waitUntilPublished() {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        changed.wait(lock, [this]() { return hasUnread(); });
+    }
+
+private:
+    static const unsigned int INDEX_MASK = 3;
+    static const unsigned int FRESH = 4;
+
+    void notify() {
+        // Taking the mutex orders the change against a waiter between its check and its sleep.
+        { std::lock_guard<std::mutex> lock(waitMutex); }
+        changed.notify_all();
+    }
+
+    T slots[3];
+    std::atomic<unsigned int> middle;  // slot index, FRESH when published and not yet read
+    unsigned int writeIndex;           // touched by the writer only
+    unsigned int readIndex;            // touched by the reader only
+    std::mutex waitMutex;
+    std::condition_variable changed;
+};
+
+#endif
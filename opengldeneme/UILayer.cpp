@@ -0,0 +1,76 @@
+// UILayer.cpp
+#include "UILayer.h"
+#include "GLState.h"
+#include <iostream>
+
+UILayer::UILayer()
+    : texture(0), framebuffer(0), width(0), height(0), cachedHash(0), valid(false), redrawn(false) {
+    counters.redrawnFrames = 0;
+    counters.cachedFrames = 0;
+}
+
+void UILayer::shutdown() {
+    GLState& state = GLState::get();
+    if (framebuffer) state.deleteFramebuffer(framebuffer);
+    if (texture) state.deleteTexture(texture);
+    framebuffer = 0;
+    texture = 0;
+    width = height = 0;
+    valid = false;
+}
+
+bool UILayer::beginRedraw(ImU64 hash, int layerWidth, int layerHeight) {
+    GLState& state = GLState::get();
+    if (layerWidth != width || layerHeight != height) {
+        if (!texture) glGenTextures(1, &texture);
+        state.bindTexture(LAYER_UNIT, GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, layerWidth, layerHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        // Composited pixel for pixel
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (!framebuffer) {
+            glGenFramebuffers(1, &framebuffer);
+            state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cerr << "ERROR::UI_LAYER::FRAMEBUFFER_INCOMPLETE" << std::endl;
+            }
+        }
+        width = layerWidth;
+        height = layerHeight;
+        valid = false;
+    }
+
+    redrawn = !valid || hash != cachedHash;
+    if (!redrawn) return false;
+    cachedHash = hash;
+    valid = true;
+
+    state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    state.viewport(0, 0, width, height);
+    state.colorMask(true, true, true, true);
+    state.disable(GL_SCISSOR_TEST);
+    const float transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, transparent);
+    return true;
+}
+
+void UILayer::composite(Shader& compositeShader) {
+    GLState& state = GLState::get();
+    if (redrawn) counters.redrawnFrames++;
+    else counters.cachedFrames++;
+
+    state.disable(GL_DEPTH_TEST);
+    state.disable(GL_SCISSOR_TEST);
+    state.disable(GL_CULL_FACE);
+    state.enable(GL_BLEND);
+    state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    compositeShader.use();
+    state.bindTexture(LAYER_UNIT, GL_TEXTURE_2D, texture);
+    compositeShader.setInt("layer", LAYER_UNIT);
+    state.bindFullscreenVertexArray();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,49 @@
+#pragma once
+// UILayer.h
+// Keeps the UI in a texture of its own and draws it again only when ImGui's output changes, going
+// by the hash of the draw data snapshot; on every other frame the UI costs one fullscreen blend
+// of the cached texture instead of its geometry. ImGui's blending into a target cleared to
+// transparent leaves premultiplied color behind, which blended with (ONE, ONE_MINUS_SRC_ALPHA)
+// gives the same pixels as drawing the UI straight into the frame. Anything that changes every
+// frame, like the performance overlay's numbers, means a redraw every frame.
+#ifndef UI_LAYER_H
+#define UI_LAYER_H
+
+#include <glad/glad.h>
+#include "Shader.h"
+#include "imgui/imgui.h"
+
+struct UILayerStats {
+    unsigned int redrawnFrames;
+    unsigned int cachedFrames;  // composited without drawing the UI
+};
+
+class UILayer {
+public:
+    // Texture unit the composite pass samples the layer from.
+    static const int LAYER_UNIT = 0;
+
+    UILayer();
+
+    // Also frees the layer while caching is switched off; the next use starts over.
+    void shutdown();
+
+    // True when the cached layer doesn't show a UI with this hash at this size. The layer's
+    // framebuffer is then bound and cleared to transparent, for ImGui to draw into.
+    bool beginRedraw(ImU64 hash, int width, int height);
+    // Blends the layer over the current framebuffer, which has the layer's size.
+    void composite(Shader& compositeShader);
+
+    UILayerStats stats() const { return counters; }
+
+private:
+    GLuint texture;
+    GLuint framebuffer;
+    int width, height;
+    ImU64 cachedHash;
+    bool valid;
+    bool redrawn;   // this frame
+    UILayerStats counters;
+};
+
+#endif
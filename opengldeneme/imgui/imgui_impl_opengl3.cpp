@@ -221,6 +221,19 @@
 #define GL_CALL(_CALL)      _CALL   // Call without error check
 #endif
 
+// Streaming ring, see ImGui_ImplOpenGL3_SetStreamingBuffer(). Each buffer is split into IMGUI_IMPL_OPENGL_STREAM_REGIONS
+// regions; a frame copies all of its draw lists into the next region and fences it, so a region is only written again
+// once the GPU has finished the frame that last read it.
+#define IMGUI_IMPL_OPENGL_STREAM_REGIONS    3
+#define IMGUI_IMPL_OPENGL_STREAM_MIN_VTX    (64 * 1024)     // Initial region capacities, grown by doubling.
+#define IMGUI_IMPL_OPENGL_STREAM_MIN_IDX    (128 * 1024)
+struct ImGui_ImplOpenGL3_StreamRing
+{
+    GLuint          Handle;
+    GLsizeiptr      RegionCapacity;          // In elements (ImDrawVert or ImDrawIdx), so every region starts on an element boundary.
+    char*           Mapped;                  // Whole buffer while persistently mapped, nullptr otherwise.
+};
+
 // OpenGL Data
 struct ImGui_ImplOpenGL3_Data
 {
@@ -243,8 +256,16 @@ struct ImGui_ImplOpenGL3_Data
     bool            HasPolygonMode;
     bool            HasClipOrigin;
     bool            UseBufferSubData;
-
-    ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); }
+    bool            BackupState;             // Save/restore GL state around RenderDrawData(). See ImGui_ImplOpenGL3_SetBackupState().
+    bool            UseStreamingBuffer;      // See ImGui_ImplOpenGL3_SetStreamingBuffer().
+    bool            HasBufferStorage;        // GL 4.4 or GL_ARB_buffer_storage: the streaming ring stays mapped.
+    ImGui_ImplOpenGL3_StreamRing StreamVtx;
+    ImGui_ImplOpenGL3_StreamRing StreamIdx;
+    GLsync          StreamFences[IMGUI_IMPL_OPENGL_STREAM_REGIONS];
+    int             StreamRegion;            // Region the latest frame was streamed into.
+    bool            StreamFrame;             // The frame being rendered is in the ring rather than VboHandle/ElementsHandle.
+
+    ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); BackupState = true; }
 };
 
 // Backend data stored in io.BackendRendererUserData to allow support for multiple Dear ImGui contexts
@@ -394,12 +415,32 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
         const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
         if (extension != nullptr && strcmp(extension, "GL_ARB_clip_control") == 0)
             bd->HasClipOrigin = true;
+        if (extension != nullptr && strcmp(extension, "GL_ARB_buffer_storage") == 0)
+            bd->HasBufferStorage = true;
     }
 #endif
+    if (bd->GlVersion >= 440)
+        bd->HasBufferStorage = true;
+    if (glBufferStorage == nullptr)
+        bd->HasBufferStorage = false;
 
     return true;
 }
 
+void    ImGui_ImplOpenGL3_SetBackupState(bool backup)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->BackupState = backup;
+}
+
+void    ImGui_ImplOpenGL3_SetStreamingBuffer(bool streaming)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->UseStreamingBuffer = streaming;
+}
+
 void    ImGui_ImplOpenGL3_Shutdown()
 {
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
@@ -490,8 +531,8 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
 #endif
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->ElementsHandle));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->StreamFrame ? bd->StreamVtx.Handle : bd->VboHandle));
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->StreamFrame ? bd->StreamIdx.Handle : bd->ElementsHandle));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxPos));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxUV));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxColor));
@@ -500,59 +541,135 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col)));
 }
 
-// OpenGL3 Render function.
-// Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
-// This is in order to be able to run within an OpenGL engine that doesn't do so.
-void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
+// Drop the fences of the streaming ring without waiting, once its buffers are being replaced or deleted.
+static void ImGui_ImplOpenGL3_ReleaseStreamFences()
 {
-    // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
-    int fb_width = (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
-    int fb_height = (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
-    if (fb_width <= 0 || fb_height <= 0)
-        return;
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    for (int i = 0; i < IMGUI_IMPL_OPENGL_STREAM_REGIONS; i++)
+        if (bd->StreamFences[i] != nullptr)
+        {
+            glDeleteSync(bd->StreamFences[i]);
+            bd->StreamFences[i] = nullptr;
+        }
+}
 
-    ImGui_ImplOpenGL3_InitLoader(); // Lazily init loader if not already done for e.g. DLL boundaries.
+// Deleting a buffer also releases its mapping; draws already issued keep the storage alive until they are done.
+static void ImGui_ImplOpenGL3_DestroyStreamRing(ImGui_ImplOpenGL3_StreamRing* ring)
+{
+    if (ring->Handle)
+        glDeleteBuffers(1, &ring->Handle);
+    memset((void*)ring, 0, sizeof(*ring));
+}
 
+// (Re)allocate the ring with room for capacity elements per region. Both rings are allocated and mapped through
+// GL_ARRAY_BUFFER: the target doesn't matter to the buffer, and GL_ELEMENT_ARRAY_BUFFER would need a vertex array bound.
+static bool ImGui_ImplOpenGL3_CreateStreamRing(ImGui_ImplOpenGL3_StreamRing* ring, GLsizeiptr capacity, GLsizeiptr element_size)
+{
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    ImGui_ImplOpenGL3_DestroyStreamRing(ring);
+    const GLsizeiptr buffer_size = capacity * element_size * IMGUI_IMPL_OPENGL_STREAM_REGIONS;
+    GL_CALL(glGenBuffers(1, &ring->Handle));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, ring->Handle));
+    ring->RegionCapacity = capacity;
+    if (!bd->HasBufferStorage)
+    {
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER, buffer_size, nullptr, GL_STREAM_DRAW));
+        return true;
+    }
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GL_CALL(glBufferStorage(GL_ARRAY_BUFFER, buffer_size, nullptr, flags));
+    ring->Mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, buffer_size, flags);
+    if (ring->Mapped != nullptr)
+        return true;
+    // Persistent mapping didn't work out, map each frame's region from now on.
+    bd->HasBufferStorage = false;
+    ImGui_ImplOpenGL3_DestroyStreamRing(ring);
+    return false;
+}
 
-    // Backup GL state
-    GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
-    glActiveTexture(GL_TEXTURE0);
-    GLuint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
-    GLuint last_texture; glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
-#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
-    GLuint last_sampler; if (bd->GlVersion >= 330 || bd->GlProfileIsES3) { glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler); } else { last_sampler = 0; }
-#endif
-    GLuint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
-#ifndef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
-    // This is part of VAO on OpenGL 3.0+ and OpenGL ES 3.0+.
-    GLint last_element_array_buffer; glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &last_element_array_buffer);
-    ImGui_ImplOpenGL3_VtxAttribState last_vtx_attrib_state_pos; last_vtx_attrib_state_pos.GetState(bd->AttribLocationVtxPos);
-    ImGui_ImplOpenGL3_VtxAttribState last_vtx_attrib_state_uv; last_vtx_attrib_state_uv.GetState(bd->AttribLocationVtxUV);
-    ImGui_ImplOpenGL3_VtxAttribState last_vtx_attrib_state_color; last_vtx_attrib_state_color.GetState(bd->AttribLocationVtxColor);
-#endif
-#ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
-    GLuint last_vertex_array_object; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
-#endif
-#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_POLYGON_MODE
-    GLint last_polygon_mode[2]; if (bd->HasPolygonMode) { glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode); }
-#endif
-    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
-    GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    GLenum last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
-    GLenum last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
-    GLenum last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
-    GLenum last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
-    GLenum last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
-    GLenum last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
-    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
-    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-    GLboolean last_enable_stencil_test = glIsEnabled(GL_STENCIL_TEST);
-    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
-#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_PRIMITIVE_RESTART
-    GLboolean last_enable_primitive_restart = (bd->GlVersion >= 310) ? glIsEnabled(GL_PRIMITIVE_RESTART) : GL_FALSE;
-#endif
+// Smallest power-of-two multiple of the current (or initial) capacity that holds element_count elements.
+static GLsizeiptr ImGui_ImplOpenGL3_StreamRingCapacity(const ImGui_ImplOpenGL3_StreamRing* ring, GLsizeiptr element_count, GLsizeiptr min_capacity)
+{
+    GLsizeiptr capacity = ring->RegionCapacity > 0 ? ring->RegionCapacity : min_capacity;
+    while (capacity < element_count)
+        capacity *= 2;
+    return capacity;
+}
+
+// Start writing size bytes at offset. Without persistent mapping the range is mapped unsynchronized: the fence
+// already guarantees the GPU is done with it, so the driver needn't track it.
+static char* ImGui_ImplOpenGL3_MapStreamRing(ImGui_ImplOpenGL3_StreamRing* ring, GLintptr offset, GLsizeiptr size)
+{
+    if (ring->Mapped)
+        return ring->Mapped + offset;
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, ring->Handle));
+    return (char*)glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+static bool ImGui_ImplOpenGL3_UnmapStreamRing(ImGui_ImplOpenGL3_StreamRing* ring)
+{
+    if (ring->Mapped)
+        return true;
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, ring->Handle));
+    return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+}
+
+// Copy every draw list of the frame into the next region of the streaming ring, one after another. Returns false when
+// the ring can't take the frame, the caller then uploads with glBufferData() as usual.
+static bool ImGui_ImplOpenGL3_StreamDrawData(ImDrawData* draw_data)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    if (draw_data->TotalVtxCount == 0 || draw_data->TotalIdxCount == 0)
+        return false;
+    if (bd->StreamVtx.Handle == 0 || bd->StreamVtx.RegionCapacity < draw_data->TotalVtxCount || bd->StreamIdx.RegionCapacity < draw_data->TotalIdxCount)
+    {
+        // Grow both rings together: the fences cover a region of each, and the new buffers have nothing in flight.
+        ImGui_ImplOpenGL3_ReleaseStreamFences();
+        const GLsizeiptr vtx_capacity = ImGui_ImplOpenGL3_StreamRingCapacity(&bd->StreamVtx, draw_data->TotalVtxCount, IMGUI_IMPL_OPENGL_STREAM_MIN_VTX);
+        const GLsizeiptr idx_capacity = ImGui_ImplOpenGL3_StreamRingCapacity(&bd->StreamIdx, draw_data->TotalIdxCount, IMGUI_IMPL_OPENGL_STREAM_MIN_IDX);
+        if (!ImGui_ImplOpenGL3_CreateStreamRing(&bd->StreamVtx, vtx_capacity, sizeof(ImDrawVert)) ||
+            !ImGui_ImplOpenGL3_CreateStreamRing(&bd->StreamIdx, idx_capacity, sizeof(ImDrawIdx)))
+        {
+            ImGui_ImplOpenGL3_DestroyStreamRing(&bd->StreamVtx);
+            ImGui_ImplOpenGL3_DestroyStreamRing(&bd->StreamIdx);
+            return false;
+        }
+    }
+
+    // Wait until the GPU is done with the frame that used this region IMGUI_IMPL_OPENGL_STREAM_REGIONS frames ago.
+    bd->StreamRegion = (bd->StreamRegion + 1) % IMGUI_IMPL_OPENGL_STREAM_REGIONS;
+    if (GLsync fence = bd->StreamFences[bd->StreamRegion])
+    {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(fence);
+        bd->StreamFences[bd->StreamRegion] = nullptr;
+    }
+
+    const GLintptr vtx_offset = (GLintptr)bd->StreamRegion * bd->StreamVtx.RegionCapacity * (GLintptr)sizeof(ImDrawVert);
+    const GLintptr idx_offset = (GLintptr)bd->StreamRegion * bd->StreamIdx.RegionCapacity * (GLintptr)sizeof(ImDrawIdx);
+    char* vtx_dst = ImGui_ImplOpenGL3_MapStreamRing(&bd->StreamVtx, vtx_offset, (GLsizeiptr)draw_data->TotalVtxCount * (int)sizeof(ImDrawVert));
+    char* idx_dst = vtx_dst ? ImGui_ImplOpenGL3_MapStreamRing(&bd->StreamIdx, idx_offset, (GLsizeiptr)draw_data->TotalIdxCount * (int)sizeof(ImDrawIdx)) : nullptr;
+    if (vtx_dst && idx_dst)
+    {
+        for (int n = 0; n < draw_data->CmdListsCount; n++)
+        {
+            const ImDrawList* draw_list = draw_data->CmdLists[n];
+            memcpy(vtx_dst, draw_list->VtxBuffer.Data, (size_t)draw_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            memcpy(idx_dst, draw_list->IdxBuffer.Data, (size_t)draw_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            vtx_dst += (size_t)draw_list->VtxBuffer.Size * sizeof(ImDrawVert);
+            idx_dst += (size_t)draw_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+        }
+    }
+    // An unmap can fail if the storage was lost behind our back (e.g. a mode switch); the contents are undefined then.
+    bool vtx_ok = vtx_dst != nullptr && ImGui_ImplOpenGL3_UnmapStreamRing(&bd->StreamVtx);
+    bool idx_ok = idx_dst != nullptr && ImGui_ImplOpenGL3_UnmapStreamRing(&bd->StreamIdx);
+    return vtx_ok && idx_ok;
+}
+
+// Upload and draw every command list. Leaves the render state set up by ImGui_ImplOpenGL3_SetupRenderState() behind.
+static void ImGui_ImplOpenGL3_RenderCommandLists(ImDrawData* draw_data, int fb_width, int fb_height)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
 
     // Setup desired GL state
     // Recreate the VAO every time (this is to easily allow multiple GL contexts to be rendered to. VAO are not shared among GL contexts)
@@ -561,6 +678,21 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glGenVertexArrays(1, &vertex_array_object));
 #endif
+
+    // Stream the whole frame into the ring first, so the render state below binds the ring's buffers.
+    // Streaming draws with a base vertex, which needs GL 3.2 like the sync objects do.
+    bool streaming = false;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
+    if (bd->UseStreamingBuffer && bd->GlVersion >= 320)
+        streaming = ImGui_ImplOpenGL3_StreamDrawData(draw_data);
+#endif
+    if (!bd->UseStreamingBuffer && bd->StreamVtx.Handle != 0)
+    {
+        ImGui_ImplOpenGL3_ReleaseStreamFences();
+        ImGui_ImplOpenGL3_DestroyStreamRing(&bd->StreamVtx);
+        ImGui_ImplOpenGL3_DestroyStreamRing(&bd->StreamIdx);
+    }
+    bd->StreamFrame = streaming;
     ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
 
     // Will project scissor/clipping rectangles into framebuffer space
@@ -568,6 +700,8 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
     ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
 
     // Render command lists
+    GLint stream_vtx_base = streaming ? (GLint)(bd->StreamRegion * bd->StreamVtx.RegionCapacity) : 0;
+    GLintptr stream_idx_offset = streaming ? (GLintptr)bd->StreamRegion * bd->StreamIdx.RegionCapacity * (GLintptr)sizeof(ImDrawIdx) : 0;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* draw_list = draw_data->CmdLists[n];
@@ -582,7 +716,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
         // - See https://github.com/ocornut/imgui/issues/4468 and please report any corruption issues.
         const GLsizeiptr vtx_buffer_size = (GLsizeiptr)draw_list->VtxBuffer.Size * (int)sizeof(ImDrawVert);
         const GLsizeiptr idx_buffer_size = (GLsizeiptr)draw_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx);
-        if (bd->UseBufferSubData)
+        if (streaming)
+        {
+            // Already in the ring, see ImGui_ImplOpenGL3_StreamDrawData(). The draws below are offset to where this list starts.
+        }
+        else if (bd->UseBufferSubData)
         {
             if (bd->VertexBufferSize < vtx_buffer_size)
             {
@@ -630,18 +768,91 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 GL_CALL(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID()));
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                 if (bd->GlVersion >= 320)
-                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset));
+                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(stream_idx_offset + pcmd->IdxOffset * sizeof(ImDrawIdx)), stream_vtx_base + (GLint)pcmd->VtxOffset));
                 else
 #endif
                 GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx))));
             }
         }
+        if (streaming)
+        {
+            stream_vtx_base += (GLint)draw_list->VtxBuffer.Size;
+            stream_idx_offset += idx_buffer_size;
+        }
     }
 
+    // The GPU reads this region until the fence signals.
+    if (streaming)
+        bd->StreamFences[bd->StreamRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
     // Destroy the temporary VAO
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glDeleteVertexArrays(1, &vertex_array_object));
 #endif
+}
+
+// OpenGL3 Render function.
+// Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
+// This is in order to be able to run within an OpenGL engine that doesn't do so.
+void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
+{
+    // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
+    int fb_width = (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+    int fb_height = (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+    if (fb_width <= 0 || fb_height <= 0)
+        return;
+
+    ImGui_ImplOpenGL3_InitLoader(); // Lazily init loader if not already done for e.g. DLL boundaries.
+
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+
+    // The application shadows GL state itself and will re-issue what it needs, skip the glGet*() round trips.
+    if (!bd->BackupState)
+    {
+        ImGui_ImplOpenGL3_RenderCommandLists(draw_data, fb_width, fb_height);
+        return;
+    }
+
+    // Backup GL state
+    GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
+    glActiveTexture(GL_TEXTURE0);
+    GLuint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
+    GLuint last_texture; glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
+    GLuint last_sampler; if (bd->GlVersion >= 330 || bd->GlProfileIsES3) { glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler); } else { last_sampler = 0; }
+#endif
+    GLuint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
+#ifndef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
+    // This is part of VAO on OpenGL 3.0+ and OpenGL ES 3.0+.
+    GLint last_element_array_buffer; glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &last_element_array_buffer);
+    ImGui_ImplOpenGL3_VtxAttribState last_vtx_attrib_state_pos; last_vtx_attrib_state_pos.GetState(bd->AttribLocationVtxPos);
+    ImGui_ImplOpenGL3_VtxAttribState last_vtx_attrib_state_uv; last_vtx_attrib_state_uv.GetState(bd->AttribLocationVtxUV);
+    ImGui_ImplOpenGL3_VtxAttribState last_vtx_attrib_state_color; last_vtx_attrib_state_color.GetState(bd->AttribLocationVtxColor);
+#endif
+#ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
+    GLuint last_vertex_array_object; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
+#endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_POLYGON_MODE
+    GLint last_polygon_mode[2]; if (bd->HasPolygonMode) { glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode); }
+#endif
+    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
+    GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
+    GLenum last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
+    GLenum last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
+    GLenum last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
+    GLenum last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
+    GLenum last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
+    GLenum last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
+    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
+    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
+    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean last_enable_stencil_test = glIsEnabled(GL_STENCIL_TEST);
+    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_PRIMITIVE_RESTART
+    GLboolean last_enable_primitive_restart = (bd->GlVersion >= 310) ? glIsEnabled(GL_PRIMITIVE_RESTART) : GL_FALSE;
+#endif
+
+    ImGui_ImplOpenGL3_RenderCommandLists(draw_data, fb_width, fb_height);
 
     // Restore modified GL state
     // This "glIsProgram()" check is required because if the program is "pending deletion" at the time of binding backup, it will have been deleted by now and will cause an OpenGL error. See #6220.
@@ -970,6 +1181,9 @@ void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
     if (bd->VboHandle)      { glDeleteBuffers(1, &bd->VboHandle); bd->VboHandle = 0; }
     if (bd->ElementsHandle) { glDeleteBuffers(1, &bd->ElementsHandle); bd->ElementsHandle = 0; }
     if (bd->ShaderHandle)   { glDeleteProgram(bd->ShaderHandle); bd->ShaderHandle = 0; }
+    ImGui_ImplOpenGL3_ReleaseStreamFences();
+    ImGui_ImplOpenGL3_DestroyStreamRing(&bd->StreamVtx);
+    ImGui_ImplOpenGL3_DestroyStreamRing(&bd->StreamIdx);
     ImGui_ImplOpenGL3_DestroyFontsTexture();
 }
 
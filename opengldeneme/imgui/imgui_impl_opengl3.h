@@ -35,6 +35,15 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_Shutdown();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_NewFrame();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data);
 
+// (Optional) Skip the backup/restore of GL state around RenderDrawData(). Only do this when the
+// application tracks GL state itself and resets whatever it relies on after rendering the UI.
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetBackupState(bool backup);
+
+// (Optional) Stream all draw lists of a frame into one ring buffer, fenced per frame, instead of reallocating the
+// buffers with glBufferData() for every draw list. The ring stays persistently mapped on GL 4.4 / GL_ARB_buffer_storage
+// and is mapped unsynchronized per frame otherwise. Needs desktop GL 3.2+, falls back to glBufferData() elsewhere.
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetStreamingBuffer(bool streaming);
+
 // (Optional) Called by Init/NewFrame/Shutdown
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateFontsTexture();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
@@ -1,72 +1,238 @@
 #version 330 core
+#ifdef GBUFFER
+// Geometry pass of the deferred path, see DeferredRenderer
+layout (location = 0) out vec4 GAlbedo;   // albedo, roughness
+layout (location = 1) out vec4 GNormal;   // octahedral normal, metalness, gallery ambient flag
+layout (location = 2) out vec3 GIndirect; // indirect light times albedo
+#else
 out vec4 FragColor;
+#endif
 
+#ifdef DEFERRED
+// Lighting pass of the deferred path: the surface comes from the G-buffer
+in vec2 TexCoord;                  // screen uv, from fullscreen.vert
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gIndirect;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+uniform mat4 inverseView;
+vec3 FragPos_World;                // reconstructed from depth in main()
+float ViewDepth;
+#else
 in vec3 FragPos_World;
 in vec3 Normal_World;
+in vec2 TexCoord;
+#ifdef CLUSTERED_LIGHTS
+in float ViewDepth;
+#endif
+#endif
+#ifdef LIGHTMAP
+in vec2 LightmapCoord;
+uniform sampler2D lightmap; // baked indirect light, replaces the flat ambient terms
+#endif
+#ifdef IRRADIANCE_PROBES
+// Baked L1 SH probe grid for objects without a lightmap, see IrradianceVolume
+uniform sampler3D probeRed;   // (c0, c1) per channel: indirect light = c0 + dot(c1, n)
+uniform sampler3D probeGreen;
+uniform sampler3D probeBlue;
+uniform vec3 probeGridOrigin;
+uniform vec3 probeGridSpacing;
+uniform vec3 probeGridSize;
+
+vec3 probeIrradiance(vec3 position, vec3 normal)
+{
+    vec3 uvw = ((position - probeGridOrigin) / probeGridSpacing + 0.5) / probeGridSize;
+    vec4 basis = vec4(1.0, normal);
+    return max(vec3(dot(texture(probeRed, uvw), basis), dot(texture(probeGreen, uvw), basis),
+        dot(texture(probeBlue, uvw), basis)), 0.0);
+}
+#endif
 
 uniform vec3 objectColor;
+uniform vec2 material;    // roughness, metalness
+#ifdef USE_TEXTURE
+uniform sampler2D diffuseMap; // exhibit artwork, tinted by objectColor
+#endif
 uniform vec3 lightColor;
 uniform vec3 lightPos;    // Light position in world space
 uniform vec3 viewPos;     // Camera position in world space
 
-// Spotlight properties (example)
-uniform vec3 spotLightPos;
-uniform vec3 spotLightDir;
-uniform float spotLightCutOff; // cosine of the angle
-uniform float spotLightOuterCutOff;
-uniform vec3 spotLightColor;
-uniform bool spotLightOn;
+// Surface properties shared by the lighting functions, set at the start of main()
+vec2 surfaceMaterial;     // roughness, metalness
+float galleryAmbient;     // per-light ambient strength, 0 where indirect light is baked
+
+// Octahedral normal encoding into [-1, 1]^2
+vec2 octEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : folded;
+}
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+#ifdef SHADOWS
+uniform sampler2DShadow shadowAtlas;
+uniform samplerBuffer shadowData;    // 5 texels per shadow: light matrix into the atlas, tile rect
+uniform int mainLightShadow;         // -1 when the main light has no shadow yet
+
+// 3x3 taps of hardware 2x2 PCF, clamped to the light's atlas tile
+float shadowFactor(int index, vec3 normal)
+{
+    if (index < 0) return 1.0;
+    mat4 lightMatrix = mat4(texelFetch(shadowData, index * 5), texelFetch(shadowData, index * 5 + 1),
+        texelFetch(shadowData, index * 5 + 2), texelFetch(shadowData, index * 5 + 3));
+    vec4 tileRect = texelFetch(shadowData, index * 5 + 4);
+    vec4 lightClip = lightMatrix * vec4(FragPos_World + normal * 0.02, 1.0); // normal offset against acne
+    if (lightClip.w <= 0.0) return 1.0;
+    vec3 coord = lightClip.xyz / lightClip.w;
+    if (coord.z >= 1.0) return 1.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            vec2 uv = clamp(coord.xy + vec2(x, y) * texel, tileRect.xy, tileRect.zw);
+            lit += texture(shadowAtlas, vec3(uv, coord.z - 0.0005));
+        }
+    }
+    return lit / 9.0;
+}
+#endif
+
+#ifdef CLUSTERED_LIGHTS
+// Clustered gallery lights (spot and point), see ClusteredLighting
+uniform samplerBuffer lightData;     // 4 texels per light: pos+range, color+cosInner, dir+cosOuter, shadow index
+uniform usamplerBuffer clusterGrid;  // offset, count into lightIndices per cluster
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterDims;
+uniform vec2 clusterTileSize;        // pixels per cluster tile
+uniform float clusterZScale;
+uniform float clusterZBias;
+
+vec3 galleryLight(int index, vec3 norm, vec3 viewDir, vec3 baseColor)
+{
+    vec4 posRange = texelFetch(lightData, index * 4);
+    vec4 colorInner = texelFetch(lightData, index * 4 + 1);
+    vec4 dirOuter = texelFetch(lightData, index * 4 + 2);
+
+    vec3 toLight = posRange.xyz - FragPos_World;
+    float dist = length(toLight);
+    if (dist >= posRange.w) return vec3(0.0);
+    vec3 lightDir = toLight / dist;
+
+    // Smooth window so the light reaches exactly zero at its range
+    float ratio = dist / posRange.w;
+    float falloff = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    falloff *= falloff;
+
+    // Spot cone (cosOuter = -1 for point lights)
+    float theta = dot(lightDir, -dirOuter.xyz);
+    float intensity = clamp((theta - dirOuter.w) / max(colorInner.w - dirOuter.w, 0.0001), 0.0, 1.0) * falloff;
+    if (intensity <= 0.0) return vec3(0.0);
+
+    vec3 color = colorInner.rgb;
+    vec3 ambient = galleryAmbient * color;
+    vec3 diffuse = max(dot(norm, lightDir), 0.0) * color * (1.0 - surfaceMaterial.y);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float shininess = max(32.0 * (1.0 - surfaceMaterial.x), 1.0); // half the main light's, for a softer highlight
+    vec3 specular = 0.5 * pow(max(dot(viewDir, reflectDir), 0.0), shininess) * color;
+#ifdef SHADOWS
+    float shadow = shadowFactor(int(texelFetch(lightData, index * 4 + 3).x), norm);
+    return (ambient + (diffuse + specular) * shadow) * baseColor * intensity;
+#else
+    return (ambient + diffuse + specular) * baseColor * intensity;
+#endif
+}
+#endif
 
 
 void main()
 {
+#ifdef DEFERRED
+    // The G-buffer can be larger than the viewport (dynamic resolution), so read it by pixel
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth >= 1.0) discard; // background keeps the clear color
+    vec4 viewPosition = inverseProjection * vec4(vec3(TexCoord, depth) * 2.0 - 1.0, 1.0);
+    viewPosition /= viewPosition.w;
+    ViewDepth = -viewPosition.z;
+    FragPos_World = vec3(inverseView * viewPosition);
+    vec4 albedoRoughness = texelFetch(gAlbedo, pixel, 0);
+    vec4 normalMetal = texelFetch(gNormal, pixel, 0);
+    vec3 baseColor = albedoRoughness.rgb;
+    vec3 norm = octDecode(normalMetal.xy * 2.0 - 1.0);
+    surfaceMaterial = vec2(albedoRoughness.a, normalMetal.z);
+    galleryAmbient = 0.05 * normalMetal.w;
+    vec3 finalColor = texelFetch(gIndirect, pixel, 0).rgb;
+#else
     vec3 finalColor = vec3(0.0);
+#ifdef USE_TEXTURE
+    vec3 baseColor = objectColor * texture(diffuseMap, TexCoord).rgb;
+#else
+    vec3 baseColor = objectColor;
+#endif
+    surfaceMaterial = material;
 
+    vec3 norm = normalize(Normal_World);
+#ifdef LIGHTMAP
+    // Baked indirect light
+    finalColor += texture(lightmap, LightmapCoord).rgb * baseColor;
+    galleryAmbient = 0.0;
+#elif defined(IRRADIANCE_PROBES)
+    finalColor += probeIrradiance(FragPos_World, norm) * baseColor;
+    galleryAmbient = 0.0;
+#else
     // Ambient light
     float ambientStrength = 0.15; // Main ambient light
     vec3 ambient = ambientStrength * lightColor;
-    finalColor += ambient * objectColor;
+    finalColor += ambient * baseColor;
+    galleryAmbient = 0.05;
+#endif
+#endif
 
+#ifdef GBUFFER
+    GAlbedo = vec4(baseColor, surfaceMaterial.x);
+    GNormal = vec4(octEncode(norm) * 0.5 + 0.5, surfaceMaterial.y, galleryAmbient / 0.05);
+    GIndirect = finalColor;
+#else
     // Diffuse lighting (main light)
-    vec3 norm = normalize(Normal_World);
     vec3 lightDir = normalize(lightPos - FragPos_World);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-    finalColor += diffuse * objectColor;
+    vec3 diffuse = diff * lightColor * (1.0 - surfaceMaterial.y);
+#ifdef SHADOWS
+    float mainShadow = shadowFactor(mainLightShadow, norm);
+#else
+    float mainShadow = 1.0;
+#endif
+    finalColor += diffuse * baseColor * mainShadow;
 
     // Specular lighting (main light)
     float specularStrength = 0.5;
     vec3 viewDir = normalize(viewPos - FragPos_World);
     vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), max(64.0 * (1.0 - surfaceMaterial.x), 1.0));
     vec3 specular = specularStrength * spec * lightColor;
-    finalColor += specular * objectColor;
-
-
-    // Spotlight (if active)
-    if (spotLightOn) {
-        vec3 lightDirSpot = normalize(spotLightPos - FragPos_World);
-        float theta = dot(lightDirSpot, normalize(-spotLightDir)); // -spotLightDir because spotLightDir points from the light
-        float epsilon = spotLightCutOff - spotLightOuterCutOff;
-        float intensity = clamp((theta - spotLightOuterCutOff) / epsilon, 0.0, 1.0);
-
-        if (theta > spotLightOuterCutOff) { // or spotLightCutOff for hard edge
-             // Ambient for spotlight (can be different)
-            vec3 ambientSpot = 0.05f * spotLightColor;
-            finalColor += ambientSpot * objectColor * intensity;
-
-            // Diffuse for spotlight
-            float diffSpot = max(dot(norm, lightDirSpot), 0.0);
-            vec3 diffuseSpot = diffSpot * spotLightColor;
-            finalColor += diffuseSpot * objectColor * intensity;
-            
-            // Specular for spotlight
-            vec3 reflectDirSpot = reflect(-lightDirSpot, norm);
-            float specSpot = pow(max(dot(viewDir, reflectDirSpot), 0.0), 16); // smaller exponent for softer highlight
-            vec3 specularSpot = specularStrength * specSpot * spotLightColor;
-            finalColor += specularSpot * objectColor * intensity;
-        }
+    finalColor += specular * baseColor * mainShadow;
+
+
+#ifdef CLUSTERED_LIGHTS
+    // Gallery lights of this fragment's cluster
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize), int(log(max(ViewDepth, 0.0001)) * clusterZScale - clusterZBias));
+    cluster = clamp(cluster, ivec3(0), clusterDims - 1);
+    uvec2 range = texelFetch(clusterGrid, cluster.x + cluster.y * clusterDims.x + cluster.z * clusterDims.x * clusterDims.y).xy;
+    for (uint i = 0u; i < range.y; ++i) {
+        int lightIndex = int(texelFetch(lightIndices, int(range.x + i)).r);
+        finalColor += galleryLight(lightIndex, norm, viewDir, baseColor);
     }
-    
+#endif
+
     FragColor = vec4(finalColor, 1.0);
-}
\ No newline at end of file
+#endif
+}
@@ -1,17 +1,42 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Must match depth.vert for the GL_EQUAL shading pass after a depth prepass
+invariant gl_Position;
+
 out vec3 FragPos_World; // Output position in world space
 out vec3 Normal_World;  // Output normal in world space
+out vec2 TexCoord;
+#ifdef CLUSTERED_LIGHTS
+out float ViewDepth;    // Distance along the view axis, selects the light cluster slice
+#endif
+#ifdef LIGHTMAP
+uniform vec4 lightmapRects[6]; // atlas rect per box face: +X, -X, +Y, -Y, +Z, -Z
+out vec2 LightmapCoord;
+#endif
 
 void main()
 {
     FragPos_World = vec3(model * vec4(aPos, 1.0));
     Normal_World = mat3(transpose(inverse(model))) * aNormal;
-    gl_Position = projection * view * vec4(FragPos_World, 1.0);
+    TexCoord = aTexCoord;
+#ifdef LIGHTMAP
+    // Same face selection as lightmapFaceIndex(): dominant axis of the object space normal
+    vec3 a = abs(aNormal);
+    int face = (a.x >= a.y && a.x >= a.z) ? (aNormal.x >= 0.0 ? 0 : 1)
+             : (a.y >= a.z) ? (aNormal.y >= 0.0 ? 2 : 3) : (aNormal.z >= 0.0 ? 4 : 5);
+    vec4 rect = lightmapRects[face];
+    LightmapCoord = rect.xy + aTexCoord * rect.zw;
+#endif
+    vec4 viewPos = view * vec4(FragPos_World, 1.0);
+#ifdef CLUSTERED_LIGHTS
+    ViewDepth = -viewPos.z;
+#endif
+    gl_Position = projection * viewPos;
 }
\ No newline at end of file
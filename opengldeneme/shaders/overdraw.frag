@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+// One shaded fragment, summed with additive blending into the overdraw count target.
+void main()
+{
+    FragColor = vec4(1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D overdrawCount; // fragments shaded per pixel
+uniform float maxOverdraw;       // count shown as full red
+
+void main()
+{
+    float count = texelFetch(overdrawCount, ivec2(gl_FragCoord.xy), 0).r; // target may be larger than the viewport
+    if (count < 0.5) {
+        FragColor = vec4(0.05, 0.05, 0.05, 1.0);
+        return;
+    }
+    // 1 = blue, then green, yellow and red at maxOverdraw and above
+    float t = clamp((count - 1.0) / max(maxOverdraw - 1.0, 1.0), 0.0, 1.0) * 3.0;
+    vec3 color;
+    if (t < 1.0) color = mix(vec3(0.0, 0.2, 1.0), vec3(0.0, 1.0, 0.2), t);
+    else if (t < 2.0) color = mix(vec3(0.0, 1.0, 0.2), vec3(1.0, 1.0, 0.0), t - 1.0);
+    else color = mix(vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), t - 2.0);
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D sceneColor; // the scene in the lower left sceneSize pixels, see DynamicResolution
+uniform vec2 sceneSize;
+uniform float sharpness;      // 0 for plain bilinear
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+    // Stay half a texel inside the drawn area so bilinear taps never reach the unused part
+    vec2 uv = clamp(TexCoord * sceneSize * texel, 0.5 * texel, (sceneSize - 0.5) * texel);
+    vec3 color = texture(sceneColor, uv).rgb;
+    if (sharpness > 0.0) {
+        // Unsharp mask against the four neighbours, which restores some of the edge contrast
+        // the bilinear stretch loses
+        vec3 neighbours = texture(sceneColor, uv + vec2(texel.x, 0.0)).rgb + texture(sceneColor, uv - vec2(texel.x, 0.0)).rgb
+            + texture(sceneColor, uv + vec2(0.0, texel.y)).rgb + texture(sceneColor, uv - vec2(0.0, texel.y)).rgb;
+        color = max(color + sharpness * (color - 0.25 * neighbours), 0.0);
+    }
+    FragColor = vec4(color, 1.0);
+}